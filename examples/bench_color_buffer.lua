@@ -0,0 +1,50 @@
+--[[ benchmark: reading image pixels from Lua
+
+    usage: raylua examples/bench_color_buffer.lua [size]
+
+    Loads the pixels of a size x size image and sums their red channel, once
+    through a Lua table with one Color object per pixel (what LoadImageColors
+    used to return) and once through a ColorBuffer. Prints the wall time and
+    the peak memory of both.
+--]]
+local size = tonumber(arg[1]) or 1024
+local image = GenImageGradientV(size, size, RED, BLUE)
+
+local function bench(name, load, sum)
+    collectgarbage()
+    collectgarbage('stop')
+    local heap, bytes = collectgarbage('count'), GetAllocatedBytes()
+    local start = os.clock()
+    local pixels = load()
+    local total = sum(pixels)
+    local elapsed = os.clock() - start
+    -- nothing was collected, so the growth is the peak of the pixel data
+    local peakHeap, peakBytes = collectgarbage('count') - heap, GetAllocatedBytes() - bytes
+    collectgarbage('restart')
+    print(string.format('%-12s %8.1f ms %10.1f KiB heap %12d bytes allocated (sum %d)', name,
+        elapsed * 1000, peakHeap, peakBytes, total))
+end
+
+bench('table', function()
+    -- one Color object per pixel, like the old table based binding; the
+    -- intermediate buffer adds 4 bytes per pixel to the figures
+    local buffer = LoadImageColors(image)
+    local colors = {}
+    for i = 1, #buffer do colors[i] = Color(buffer:GetRGBA(i)) end
+    return colors
+end, function(colors)
+    local total = 0
+    for i = 1, #colors do total = total + colors[i].r end
+    return total
+end)
+
+bench('ColorBuffer', function()
+    return LoadImageColors(image)
+end, function(buffer)
+    local total = 0
+    for i = 1, #buffer do
+        local r = buffer:GetRGBA(i)
+        total = total + r
+    end
+    return total
+end)
@@ -0,0 +1,53 @@
+--[[ benchmark: field access on userdata objects
+
+    usage: raylua examples/bench_field_access.lua [iterations]
+
+    Prints ns/op for reading and writing fields of Vector2 and Rectangle and
+    for looking up a method, next to a plain Lua table as reference. Run it
+    with builds before and after a change to the __index/__newindex dispatch
+    to compare them.
+--]]
+local iterations = tonumber(arg[1]) or 10000000
+
+local function bench(name, loop)
+    loop(1000) -- warm up
+    collectgarbage()
+    local start = os.clock()
+    loop(iterations)
+    local elapsed = os.clock() - start
+    print(string.format('%-28s %8.2f ns/op', name, elapsed / iterations * 1e9))
+end
+
+local t = { x = 1, y = 2 }
+local v = Vector2(1, 2)
+local r = Rectangle(1, 2, 3, 4)
+
+bench('empty loop', function(n)
+    for _ = 1, n do end
+end)
+bench('table read t.x', function(n)
+    local sum = 0
+    for _ = 1, n do sum = sum + t.x end
+    return sum
+end)
+bench('Vector2 read v.x', function(n)
+    local sum = 0
+    for _ = 1, n do sum = sum + v.x end
+    return sum
+end)
+bench('Vector2 write v.x', function(n)
+    for i = 1, n do v.x = i end
+end)
+bench('Rectangle read r.height', function(n)
+    local sum = 0
+    for _ = 1, n do sum = sum + r.height end
+    return sum
+end)
+bench('Rectangle write r.height', function(n)
+    for i = 1, n do r.height = i end
+end)
+bench('Vector2 method lookup', function(n)
+    local f
+    for _ = 1, n do f = v.Length end
+    return f
+end)
@@ -0,0 +1,44 @@
+--[[ benchmark: throughput of the parallel Image operations
+
+    usage: raylua --headless examples/bench_image_ops.lua [size] [runs]
+
+    Runs each operation on a size x size RGBA image with one worker thread
+    and with the default thread count, and prints megapixels per second
+    for both. The window only provides GetTime() as a wall clock.
+--]]
+local size = tonumber(arg[1]) or 4096
+local runs = tonumber(arg[2]) or 5
+
+InitWindow(320, 240, 'raylua benchmark - image operations')
+local image = GenImageGradientH(size, size, RED, BLUE)
+local megapixels = size * size / 1e6
+
+local operations = {
+    { 'ColorTint', function() image:ColorTint(SKYBLUE) end },
+    { 'ColorInvert', function() image:ColorInvert() end },
+    { 'ColorBrightness', function() image:ColorBrightness(10) end },
+    { 'ColorContrast', function() image:ColorContrast(10) end },
+    { 'AlphaPremultiply', function() image:AlphaPremultiply() end },
+    { 'FlipVertical', function() image:FlipVertical() end },
+    { 'FlipHorizontal', function() image:FlipHorizontal() end },
+    { 'RotateCW', function() image:RotateCW() end },
+}
+
+local function bench(run)
+    run() -- warm up, also starts the worker pool
+    local start = GetTime()
+    for _ = 1, runs do run() end
+    return megapixels * runs / (GetTime() - start)
+end
+
+local threads = GetWorkerThreadCount()
+print(string.format('%-18s %12s %12s', 'operation', '1 worker', threads .. ' workers'))
+for _, operation in ipairs(operations) do
+    SetWorkerThreadCount(1)
+    local single = bench(operation[2])
+    SetWorkerThreadCount(threads)
+    local multi = bench(operation[2])
+    print(string.format('%-18s %7.1f MP/s %7.1f MP/s', operation[1], single, multi))
+end
+
+CloseWindow()
@@ -0,0 +1,52 @@
+--[[ benchmark: drawing a 100k point polyline
+
+    usage: raylua --headless examples/bench_polyline.lua [points] [frames]
+
+    Animates and draws the same polyline with DrawLineStrip(), once from a
+    Lua table of Vector2 objects and once from a Vector2Array, and prints
+    the time and the bytes allocated per frame for both.
+--]]
+local pointCount = tonumber(arg[1]) or 100000
+local frames = tonumber(arg[2]) or 100
+local screenWidth <const> = 800
+local screenHeight <const> = 450
+
+InitWindow(screenWidth, screenHeight, 'raylua benchmark - polyline')
+
+local function y(i, frame)
+    return screenHeight / 2 + math.sin(i * 0.01 + frame * 0.1) * 100
+end
+
+local function bench(name, update, draw)
+    collectgarbage()
+    local bytes = GetAllocatedBytes()
+    local start = GetTime()
+    for frame = 1, frames do
+        update(frame)
+        BeginDrawing()
+            ClearBackground(RAYWHITE)
+            draw()
+        EndDrawing()
+    end
+    local elapsed = GetTime() - start
+    print(string.format('%-14s %8.3f ms/frame %12.0f bytes/frame', name,
+        elapsed / frames * 1000, (GetAllocatedBytes() - bytes) / frames))
+end
+
+local points = {}
+for i = 1, pointCount do points[i] = Vector2(i * screenWidth / pointCount, y(i, 0)) end
+bench('table', function(frame)
+    for i = 1, pointCount do points[i] = Vector2(i * screenWidth / pointCount, y(i, frame)) end
+end, function()
+    DrawLineStrip(points, MAROON)
+end)
+points = nil
+
+local array = Vector2Array(pointCount)
+bench('Vector2Array', function(frame)
+    for i = 1, pointCount do array:Set(i, i * screenWidth / pointCount, y(i, frame)) end
+end, function()
+    DrawLineStrip(array, MAROON)
+end)
+
+CloseWindow()
@@ -0,0 +1,79 @@
+--[[ benchmark: collision broadphase for moving boxes
+
+    usage: raylua examples/bench_spatial_hash.lua [boxes] [frames]
+
+    Moves the boxes every frame and finds the overlapping pairs, once with a
+    pairwise CheckCollisionRecs() loop and once with a SpatialHash, either
+    one QueryRec() per box or one QueryPairs() call. Prints ms/frame and
+    the pairs found by each. The pairwise loop is quadratic, so it only
+    runs a few frames.
+--]]
+local boxCount = tonumber(arg[1]) or 10000
+local frames = tonumber(arg[2]) or 30
+local worldSize <const> = 4000
+local dt <const> = 1 / 60
+
+math.randomseed(42)
+local boxes = {}
+for i = 1, boxCount do
+    local size = math.random(8, 24)
+    boxes[i] = {
+        rect = Rectangle(math.random() * worldSize, math.random() * worldSize, size, size),
+        vx = math.random(-100, 100), vy = math.random(-100, 100),
+    }
+end
+
+local function move()
+    for i = 1, boxCount do
+        local box, rect = boxes[i], boxes[i].rect
+        rect.x = (rect.x + box.vx * dt) % worldSize
+        rect.y = (rect.y + box.vy * dt) % worldSize
+    end
+end
+
+local function bench(name, frameCount, find)
+    collectgarbage()
+    local start, pairCount = os.clock(), 0
+    for _ = 1, frameCount do
+        move()
+        pairCount = find()
+    end
+    local elapsed = os.clock() - start
+    print(string.format('%-22s %10.2f ms/frame %8d pairs', name, elapsed / frameCount * 1000, pairCount))
+end
+
+bench('pairwise', math.min(frames, 3), function()
+    local n = 0
+    for i = 1, boxCount do
+        local a = boxes[i].rect
+        for j = i + 1, boxCount do
+            if CheckCollisionRecs(a, boxes[j].rect) then n = n + 1 end
+        end
+    end
+    return n
+end)
+
+local grid = SpatialHash(32, 16384)
+for i = 1, boxCount do grid:Insert(i, boxes[i].rect) end
+
+local ids = {}
+bench('SpatialHash QueryRec', frames, function()
+    for i = 1, boxCount do grid:Update(i, boxes[i].rect) end
+    local n = 0
+    for i = 1, boxCount do
+        local count
+        ids, count = grid:QueryRec(boxes[i].rect, ids)
+        for k = 1, count do
+            if ids[k] > i then n = n + 1 end
+        end
+    end
+    return n
+end)
+
+local pairList = {}
+bench('SpatialHash QueryPairs', frames, function()
+    for i = 1, boxCount do grid:Update(i, boxes[i].rect) end
+    local n
+    pairList, n = grid:QueryPairs(pairList)
+    return n
+end)
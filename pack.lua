@@ -0,0 +1,136 @@
+--[[----------------------------------------------------------------------------
+    pack.lua - builds a read-only asset archive for MountArchive()
+
+    usage: lua pack.lua output.pak file...
+           find assets -type f | lua pack.lua output.pak -
+
+    Files are stored under the path given on the command line, with forward
+    slashes and without a leading "./". See the Archive object in raylua.c
+    for the layout.
+--]]----------------------------------------------------------------------------
+local format = {
+    magic = 'RLPK',
+    version = 1,
+    header = '<c4I4I4I4',
+    bucket = '<I4',
+    entry = '<I4I4I4I4I8I8',
+    header_size = 16,
+    entry_size = 32,
+    max_bucket_bits = 24,
+    alignment = 16,
+}
+
+function normalize_path(path)
+    path = string.gsub(path, '\\', '/')
+    while string.sub(path, 1, 2) == './' do
+        path = string.sub(path, 3)
+    end
+    return path
+end
+
+function hash_path(path)
+    -- 32 bit FNV-1a, must match hash_archive_path() in raylua.c
+    local hash = 2166136261
+    for i = 1, #path do
+        hash = ((hash ~ string.byte(path, i)) * 16777619) & 0xffffffff
+    end
+    return hash
+end
+
+function align(offset)
+    return (offset + format.alignment - 1) // format.alignment * format.alignment
+end
+
+function file_size(file_name)
+    local fp <close> = assert(io.open(file_name, 'rb'))
+    return assert(fp:seek('end'))
+end
+
+function collect_files(args)
+    local files, seen = {}, {}
+    local function add(file_name)
+        local path = normalize_path(file_name)
+        if #path == 0 then return end
+        assert(not seen[path], string.format('duplicate path "%s"', path))
+        seen[path] = true
+        files[#files + 1] = { file_name = file_name, path = path, hash = hash_path(path), size = file_size(file_name) }
+    end
+    for i = 2, #args do
+        if args[i] == '-' then
+            for line in io.lines() do add(line) end
+        else
+            add(args[i])
+        end
+    end
+    -- sorted by hash, so the top bits of the hash select a contiguous bucket
+    table.sort(files, function(a, b)
+        if a.hash ~= b.hash then return a.hash < b.hash end
+        return a.path < b.path
+    end)
+    return files
+end
+
+function bucket_bits(count)
+    local bits = 0
+    while (1 << bits) < count and bits < format.max_bucket_bits do
+        bits = bits + 1
+    end
+    return bits
+end
+
+function build_buckets(files, bits)
+    local buckets, index = {}, 1
+    for bucket = 0, (1 << bits) - 1 do
+        while index <= #files and (bits == 0 and 0 or files[index].hash >> (32 - bits)) < bucket do
+            index = index + 1
+        end
+        buckets[#buckets + 1] = string.pack(format.bucket, index - 1)
+    end
+    buckets[#buckets + 1] = string.pack(format.bucket, #files)
+    return table.concat(buckets)
+end
+
+function write_archive(output, files)
+    local bits = bucket_bits(#files)
+    local buckets = build_buckets(files, bits)
+    -- lay out names right after the index, then the aligned file data
+    local offset = format.header_size + #buckets + format.entry_size * #files
+    for _, file in ipairs(files) do
+        file.name_offset = offset
+        offset = offset + #file.path
+    end
+    for _, file in ipairs(files) do
+        offset = align(offset)
+        file.data_offset = offset
+        offset = offset + file.size
+    end
+
+    local fp <close> = assert(io.open(output, 'wb'))
+    assert(fp:write(string.pack(format.header, format.magic, format.version, #files, bits), buckets))
+    for _, file in ipairs(files) do
+        assert(fp:write(string.pack(format.entry, file.hash, file.name_offset, #file.path, 0, file.data_offset, file.size)))
+    end
+    for _, file in ipairs(files) do
+        assert(fp:write(file.path))
+    end
+    for _, file in ipairs(files) do
+        assert(fp:write(string.rep('\0', file.data_offset - assert(fp:seek()))))
+        local input <close> = assert(io.open(file.file_name, 'rb'))
+        local data = assert(input:read('a'))
+        assert(#data == file.size, string.format('"%s" changed while packing', file.file_name))
+        assert(fp:write(data))
+    end
+    return offset
+end
+
+function main(args)
+    if #args < 2 then
+        io.stderr:write('usage: lua pack.lua output.pak file... (use - to read file names from stdin)\n')
+        os.exit(1)
+    end
+    local files = collect_files(args)
+    local size = write_archive(args[1], files)
+    print(string.format('%s: %d files, %d bytes', args[1], #files, size))
+end
+
+main(arg)
@@ -23,8 +23,19 @@
 
 */
 //==[[ Includes ]]==============================================================
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 #include "lua.h"
 #include "lauxlib.h"
@@ -32,71 +43,85 @@
 
 #include "raylib.h"
 #include "raymath.h"
+#include "rlgl.h"
 #include "raygui.h"
 
 
 //==[[ Helper Functions ]]======================================================
 
-enum { INDEX_TABLE, NEWINDEX_TABLE, METHOD_TABLE };
-
 static void *push_object(lua_State *L, const char *name, const size_t size, const int uvalues) {
     void *object = lua_newuserdatauv(L, size, uvalues);
     luaL_setmetatable(L, name);
     return object;
 }
 
+static int f__index(lua_State *L) {
+    // upvalue 1: method table, upvalue 2: getter table
+    lua_pushvalue(L, 2);
+    if (lua_rawget(L, lua_upvalueindex(1)) != LUA_TNIL)
+        return 1;
+    lua_pushvalue(L, 2);
+    if (lua_rawget(L, lua_upvalueindex(2)) == LUA_TFUNCTION) {
+        lua_CFunction getter = lua_tocfunction(L, -1);
+        lua_settop(L, 1);
+        return getter(L);
+    }
+    return 0;
+}
+
+static int f__newindex(lua_State *L) {
+    // upvalue 1: setter table
+    lua_pushvalue(L, 2);
+    if (lua_rawget(L, lua_upvalueindex(1)) == LUA_TFUNCTION) {
+        lua_CFunction setter = lua_tocfunction(L, -1);
+        lua_settop(L, 3);
+        lua_remove(L, 2);
+        return setter(L);
+    }
+    return 0;
+}
+
 static void push_meta(lua_State *L, const char *name, const luaL_Reg funcs[]) {
+    int setters = 0;
     luaL_newmetatable(L, name);
-    lua_newtable(L); lua_pushvalue(L, -1); lua_rawseti(L, -3, INDEX_TABLE);
-    lua_newtable(L); lua_pushvalue(L, -1); lua_rawseti(L, -4, NEWINDEX_TABLE);
-    lua_newtable(L); lua_pushvalue(L, -1); lua_rawseti(L, -5, METHOD_TABLE);
+    lua_newtable(L); // methods
+    lua_newtable(L); // getters
+    lua_newtable(L); // setters
     for (int i = 0; funcs[i].name != NULL; ++i) {
         lua_pushcfunction(L, funcs[i].func);
         switch (funcs[i].name[0]) {
             case '_': lua_setfield(L, -5, funcs[i].name); break; // set directly to meta-table
-            case '?': lua_setfield(L, -4, &funcs[i].name[1]); break; // set to index table
-            case '=': lua_setfield(L, -3, &funcs[i].name[1]); break; // set to new-index table
-            default: lua_setfield(L, -2, funcs[i].name); break; // set to the method table
+            case '?': lua_setfield(L, -3, &funcs[i].name[1]); break; // set to getter table
+            case '=': lua_setfield(L, -2, &funcs[i].name[1]); ++setters; break; // set to setter table
+            default: lua_setfield(L, -4, funcs[i].name); break; // set to the method table
         }
     }
-    lua_pop(L, 4);
+    // keep the tables as upvalues, so field access never touches the registry
+    if (setters > 0) {
+        lua_pushcclosure(L, f__newindex, 1);
+        lua_setfield(L, -4, "__newindex");
+    } else {
+        lua_pop(L, 1);
+    }
+    lua_pushcclosure(L, f__index, 2);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
 }
 
-static int push_index(lua_State *L, const char *name) {
-    if (luaL_getmetatable(L, name) != LUA_TTABLE)
-        return 0;
-    const char *key = lua_tostring(L, 2);
-    int index = lua_absindex(L, -1);
-    // try to locate method
-    if (lua_rawgeti(L, index, METHOD_TABLE) == LUA_TTABLE) {
-        if (lua_getfield(L, -1, key) == LUA_TFUNCTION)
-            return 1;
-    }
-    // try to locate component
-    if (lua_rawgeti(L, index, INDEX_TABLE) == LUA_TTABLE) {
-        if (lua_getfield(L, -1, key) == LUA_TFUNCTION) {
-            lua_pushvalue(L, 1);
-            lua_call(L, 1, 1);
-            return 1;
-        }
-    }
-    return 0;
+typedef struct ObjectMeta {
+    const char *name;
+    const luaL_Reg *funcs;
+} ObjectMeta;
+
+// Methods are the entries that are neither metamethods nor getters / setters
+static bool is_method_name(const char *name) {
+    return name[0] != '_' && name[0] != '?' && name[0] != '=';
 }
 
-static int push_newindex(lua_State *L, const char *name) {
-    if (luaL_getmetatable(L, name) != LUA_TTABLE)
-        return 0;
-    const char *key = lua_tostring(L, 2);
-    int index = lua_absindex(L, -1);
-    // try to locate component
-    if (lua_rawgeti(L, index, NEWINDEX_TABLE) == LUA_TTABLE) {
-        if (lua_getfield(L, -1, key) == LUA_TFUNCTION) {
-            lua_pushvalue(L, 1);
-            lua_pushvalue(L, 3);
-            lua_call(L, 2, 0);
-        }
-    }
-    return 0;
+// Returns true if the environment variable is set to anything but "" or "0"
+static bool env_flag(const char *name) {
+    const char *env = getenv(name);
+    return env != NULL && *env != '\0' && strcmp(env, "0") != 0;
 }
 
 
@@ -126,21 +151,6 @@ static Vector2 *test_Vector2(lua_State *L, const int idx) {
     return luaL_testudata(L, idx, "Vector2");
 }
 
-static Vector2 *check_Vector2_List(lua_State *L, const int idx, int *count) {
-    static Vector2 points[1024];
-    int i;
-    luaL_argcheck(L, lua_type(L, idx) == LUA_TTABLE, idx, "table with Vector2 expected");
-    for (i = 0; i < 1024; ++i) {
-        lua_rawgeti(L, idx, i + 1);
-        const Vector2 *vector = test_Vector2(L, -1);
-        if (vector == NULL) break;
-        points[i] = *vector;
-        lua_pop(L, 1);
-    }
-    *count = i;
-    return points;
-}
-
 static int f_Vector2(lua_State *L) {
     switch (lua_gettop(L)) {
         case 0: return push_Vector2(L, Vector2Zero());
@@ -150,14 +160,6 @@ static int f_Vector2(lua_State *L) {
     }
 }
 
-static int f_Vector2__index(lua_State *L) {
-    return push_index(L, "Vector2");
-}
-
-static int f_Vector2__newindex(lua_State *L) {
-    return push_newindex(L, "Vector2");
-}
-
 static int f_Vector2__tostring(lua_State *L) {
     const Vector2 *vector = check_Vector2(L, 1);
     lua_pushfstring(L, "Vector2(x = %f, y = %f)", vector->x, vector->y);
@@ -215,6 +217,43 @@ static int f_Vector2_Angle(lua_State *L) {
     return 1;
 }
 
+static int f_Vector2_AddInPlace(lua_State *L) {
+    Vector2 *v1 = check_Vector2(L, 1);
+    const Vector2 *v2 = test_Vector2(L, 2);
+    *v1 = v2 != NULL ? Vector2Add(*v1, *v2) : Vector2AddValue(*v1, (float)luaL_checknumber(L, 2));
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int f_Vector2_SubInPlace(lua_State *L) {
+    Vector2 *v1 = check_Vector2(L, 1);
+    const Vector2 *v2 = test_Vector2(L, 2);
+    *v1 = v2 != NULL ? Vector2Subtract(*v1, *v2) : Vector2SubtractValue(*v1, (float)luaL_checknumber(L, 2));
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int f_Vector2_ScaleInPlace(lua_State *L) {
+    Vector2 *v1 = check_Vector2(L, 1);
+    *v1 = Vector2Scale(*v1, (float)luaL_checknumber(L, 2));
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int f_Vector2_LerpInto(lua_State *L) {
+    Vector2 *out = check_Vector2(L, 1);
+    *out = Vector2Lerp(*check_Vector2(L, 2), *check_Vector2(L, 3), (float)luaL_checknumber(L, 4));
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int f_Vector2_MulAdd(lua_State *L) {
+    Vector2 *out = check_Vector2(L, 1);
+    *out = Vector2Add(*check_Vector2(L, 2), Vector2Scale(*check_Vector2(L, 3), (float)luaL_checknumber(L, 4)));
+    lua_settop(L, 1);
+    return 1;
+}
+
 static int f_Vector2_get_x(lua_State *L) {
     lua_pushnumber(L, check_Vector2(L, 1)->x);
     return 1;
@@ -235,6 +274,191 @@ static int f_Vector2_set_y(lua_State *L) {
     return 0;
 }
 
+//==[[ Vector2Array object ]]===================================================
+
+typedef struct Vector2Array {
+    int count;
+    int capacity;
+    Vector2 *points;
+} Vector2Array;
+
+static Vector2Array *check_Vector2Array(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "Vector2Array");
+}
+
+static void reserve_Vector2Array(lua_State *L, Vector2Array *array, const int capacity) {
+    if (capacity <= array->capacity) return;
+    if (capacity > INT_MAX / (int)sizeof(Vector2)) luaL_error(L, "Vector2Array too large");
+    int new_capacity = array->capacity > 0 ? array->capacity : 16;
+    while (new_capacity < capacity) new_capacity *= 2;
+    Vector2 *points = realloc(array->points, sizeof(Vector2) * (size_t)new_capacity);
+    if (points == NULL) luaL_error(L, "out of memory");
+    array->points = points;
+    array->capacity = new_capacity;
+}
+
+static void resize_Vector2Array(lua_State *L, Vector2Array *array, const int count) {
+    reserve_Vector2Array(L, array, count);
+    if (count > array->count)
+        memset(&array->points[array->count], 0, sizeof(Vector2) * (size_t)(count - array->count));
+    array->count = count;
+}
+
+static Vector2Array *push_Vector2Array(lua_State *L, const int count) {
+    Vector2Array *array = push_object(L, "Vector2Array", sizeof(Vector2Array), 0);
+    *array = (Vector2Array){ 0 };
+    resize_Vector2Array(L, array, count);
+    return array;
+}
+
+static Vector2 check_Vector2_XY(lua_State *L, const int idx) {
+    const Vector2 *vector = test_Vector2(L, idx);
+    if (vector != NULL) return *vector;
+    return (Vector2){ .x = (float)luaL_checknumber(L, idx), .y = (float)luaL_checknumber(L, idx + 1) };
+}
+
+static int check_Vector2Array_index(lua_State *L, const Vector2Array *array, const int idx) {
+    lua_Integer i = luaL_checkinteger(L, idx);
+    luaL_argcheck(L, i >= 1 && i <= array->count, idx, "index out of range");
+    return (int)i - 1;
+}
+
+static Vector2 *check_Vector2_List(lua_State *L, const int idx, int *count) {
+    // a Vector2Array is passed through without copying
+    Vector2Array *array = luaL_testudata(L, idx, "Vector2Array");
+    if (array != NULL) {
+        *count = array->count;
+        return array->points;
+    }
+    // fallback: copy a table of Vector2 into a scratch buffer which lives on the Lua stack
+    luaL_argcheck(L, lua_type(L, idx) == LUA_TTABLE, idx, "Vector2Array or table with Vector2 expected");
+    int length = (int)lua_rawlen(L, idx), i;
+    Vector2 *points = lua_newuserdatauv(L, sizeof(Vector2) * (size_t)(length > 0 ? length : 1), 0);
+    for (i = 0; i < length; ++i) {
+        lua_rawgeti(L, idx, i + 1);
+        const Vector2 *vector = test_Vector2(L, -1);
+        lua_pop(L, 1);
+        if (vector == NULL) break;
+        points[i] = *vector;
+    }
+    *count = i;
+    return points;
+}
+
+static int f_Vector2Array(lua_State *L) {
+    if (lua_type(L, 1) == LUA_TTABLE) {
+        int count;
+        const Vector2 *points = check_Vector2_List(L, 1, &count);
+        Vector2Array *array = push_Vector2Array(L, count);
+        memcpy(array->points, points, sizeof(Vector2) * (size_t)count);
+        return 1;
+    }
+    lua_Integer count = luaL_optinteger(L, 1, 0);
+    luaL_argcheck(L, count >= 0 && count <= INT_MAX, 1, "invalid count");
+    push_Vector2Array(L, (int)count);
+    return 1;
+}
+
+static int f_Vector2Array__gc(lua_State *L) {
+    Vector2Array *array = check_Vector2Array(L, 1);
+    free(array->points);
+    *array = (Vector2Array){ 0 };
+    return 0;
+}
+
+static int f_Vector2Array__tostring(lua_State *L) {
+    const Vector2Array *array = check_Vector2Array(L, 1);
+    lua_pushfstring(L, "Vector2Array(count = %d)", array->count);
+    return 1;
+}
+
+static int f_Vector2Array__len(lua_State *L) {
+    lua_pushinteger(L, check_Vector2Array(L, 1)->count);
+    return 1;
+}
+
+static int f_Vector2Array_Push(lua_State *L) {
+    Vector2Array *array = check_Vector2Array(L, 1);
+    const Vector2 vector = check_Vector2_XY(L, 2);
+    reserve_Vector2Array(L, array, array->count + 1);
+    array->points[array->count++] = vector;
+    lua_pushinteger(L, array->count);
+    return 1;
+}
+
+static int f_Vector2Array_Get(lua_State *L) {
+    const Vector2Array *array = check_Vector2Array(L, 1);
+    return push_Vector2(L, array->points[check_Vector2Array_index(L, array, 2)]);
+}
+
+static int f_Vector2Array_GetXY(lua_State *L) {
+    const Vector2Array *array = check_Vector2Array(L, 1);
+    const Vector2 vector = array->points[check_Vector2Array_index(L, array, 2)];
+    lua_pushnumber(L, vector.x);
+    lua_pushnumber(L, vector.y);
+    return 2;
+}
+
+static int f_Vector2Array_Set(lua_State *L) {
+    Vector2Array *array = check_Vector2Array(L, 1);
+    array->points[check_Vector2Array_index(L, array, 2)] = check_Vector2_XY(L, 3);
+    return 0;
+}
+
+static int f_Vector2Array_Resize(lua_State *L) {
+    Vector2Array *array = check_Vector2Array(L, 1);
+    lua_Integer count = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, count >= 0 && count <= INT_MAX, 2, "invalid count");
+    resize_Vector2Array(L, array, (int)count);
+    return 0;
+}
+
+static int f_Vector2Array_Clear(lua_State *L) {
+    check_Vector2Array(L, 1)->count = 0;
+    return 0;
+}
+
+static int f_Vector2Array_Translate(lua_State *L) {
+    Vector2Array *array = check_Vector2Array(L, 1);
+    const Vector2 offset = check_Vector2_XY(L, 2);
+    for (int i = 0; i < array->count; ++i) {
+        array->points[i].x += offset.x;
+        array->points[i].y += offset.y;
+    }
+    return 0;
+}
+
+static int f_Vector2Array_Scale(lua_State *L) {
+    Vector2Array *array = check_Vector2Array(L, 1);
+    const Vector2 *factor = test_Vector2(L, 2);
+    const Vector2 scale = factor != NULL ? *factor : (Vector2){ (float)luaL_checknumber(L, 2), (float)luaL_optnumber(L, 3, lua_tonumber(L, 2)) };
+    for (int i = 0; i < array->count; ++i) {
+        array->points[i].x *= scale.x;
+        array->points[i].y *= scale.y;
+    }
+    return 0;
+}
+
+static int f_Vector2Array_Rotate(lua_State *L) {
+    Vector2Array *array = check_Vector2Array(L, 1);
+    const float angle = (float)luaL_checknumber(L, 2);
+    const Vector2 origin = lua_isnoneornil(L, 3) ? Vector2Zero() : *check_Vector2(L, 3);
+    // build the 2x2 rotation matrix once and apply it to every point
+    const float c = cosf(angle), s = sinf(angle);
+    for (int i = 0; i < array->count; ++i) {
+        const float x = array->points[i].x - origin.x, y = array->points[i].y - origin.y;
+        array->points[i].x = origin.x + x * c - y * s;
+        array->points[i].y = origin.y + x * s + y * c;
+    }
+    return 0;
+}
+
+static int f_Vector2Array_get_count(lua_State *L) {
+    lua_pushinteger(L, check_Vector2Array(L, 1)->count);
+    return 1;
+}
+
+
 //==[[ Vector3 object ]]========================================================
 
 static int push_Vector3(lua_State *L, const Vector3 vector) {
@@ -276,14 +500,6 @@ static int f_Vector3__tostring(lua_State *L) {
     return 1;
 }
 
-static int f_Vector3__index(lua_State *L) {
-    return push_index(L, "Vector3");
-}
-
-static int f_Vector3__newindex(lua_State *L) {
-    return push_newindex(L, "Vector3");
-}
-
 static int f_Vector3__add(lua_State *L) {
     const Vector3 *v1 = check_Vector3(L, 1);
     const Vector3 *v2 = test_Vector3(L, 2);
@@ -335,6 +551,43 @@ static int f_Vector3_Normal(lua_State *L) {
     return push_Vector3(L, Vector3Normalize(*check_Vector3(L, 1)));
 }
 
+static int f_Vector3_AddInPlace(lua_State *L) {
+    Vector3 *v1 = check_Vector3(L, 1);
+    const Vector3 *v2 = test_Vector3(L, 2);
+    *v1 = v2 != NULL ? Vector3Add(*v1, *v2) : Vector3AddValue(*v1, (float)luaL_checknumber(L, 2));
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int f_Vector3_SubInPlace(lua_State *L) {
+    Vector3 *v1 = check_Vector3(L, 1);
+    const Vector3 *v2 = test_Vector3(L, 2);
+    *v1 = v2 != NULL ? Vector3Subtract(*v1, *v2) : Vector3SubtractValue(*v1, (float)luaL_checknumber(L, 2));
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int f_Vector3_ScaleInPlace(lua_State *L) {
+    Vector3 *v1 = check_Vector3(L, 1);
+    *v1 = Vector3Scale(*v1, (float)luaL_checknumber(L, 2));
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int f_Vector3_LerpInto(lua_State *L) {
+    Vector3 *out = check_Vector3(L, 1);
+    *out = Vector3Lerp(*check_Vector3(L, 2), *check_Vector3(L, 3), (float)luaL_checknumber(L, 4));
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int f_Vector3_MulAdd(lua_State *L) {
+    Vector3 *out = check_Vector3(L, 1);
+    *out = Vector3Add(*check_Vector3(L, 2), Vector3Scale(*check_Vector3(L, 3), (float)luaL_checknumber(L, 4)));
+    lua_settop(L, 1);
+    return 1;
+}
+
 static int f_Vector3_get_x(lua_State *L) {
     lua_pushnumber(L, check_Vector3(L, 1)->x);
     return 1;
@@ -404,14 +657,6 @@ static int f_Color__tostring(lua_State *L) {
     return 1;
 }
 
-static int f_Color__index(lua_State *L) {
-    return push_index(L, "Color");
-}
-
-static int f_Color__newindex(lua_State *L) {
-    return push_newindex(L, "Color");
-}
-
 static int f_Color_Fade(lua_State *L) {
     return push_Color(L, Fade(*check_Color(L, 1), (float)luaL_checknumber(L, 2)));
 }
@@ -460,6 +705,156 @@ static int f_Color_set_a(lua_State *L) {
 }
 
 
+//==[[ ColorBuffer object ]]====================================================
+
+typedef struct ColorBuffer {
+    int width;
+    int height;
+    int count;
+    Color colors[];
+} ColorBuffer;
+
+static ColorBuffer *push_ColorBuffer(lua_State *L, const int width, const int height, const Color *colors) {
+    const int count = width * height;
+    ColorBuffer *buffer = push_object(L, "ColorBuffer", sizeof(ColorBuffer) + sizeof(Color) * (size_t)count, 0);
+    buffer->width = width;
+    buffer->height = height;
+    buffer->count = count;
+    if (colors != NULL)
+        memcpy(buffer->colors, colors, sizeof(Color) * (size_t)count);
+    else
+        memset(buffer->colors, 0, sizeof(Color) * (size_t)count);
+    return buffer;
+}
+
+static ColorBuffer *check_ColorBuffer(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "ColorBuffer");
+}
+
+static int check_ColorBuffer_index(lua_State *L, const ColorBuffer *buffer, const int idx) {
+    lua_Integer i = luaL_checkinteger(L, idx);
+    luaL_argcheck(L, i >= 1 && i <= buffer->count, idx, "index out of range");
+    return (int)i - 1;
+}
+
+static Color check_Color_RGBA(lua_State *L, const int idx) {
+    const Color *color = luaL_testudata(L, idx, "Color");
+    if (color != NULL) return *color;
+    return (Color){
+        .r = check_color_component(L, idx),
+        .g = check_color_component(L, idx + 1),
+        .b = check_color_component(L, idx + 2),
+        .a = (unsigned char)Clamp((float)luaL_optnumber(L, idx + 3, 255.0), 0.0f, 255.0f),
+    };
+}
+
+static unsigned char to_color_component(lua_State *L, const int idx) {
+    return (unsigned char)Clamp((float)lua_tonumber(L, idx), 0.0f, 255.0f);
+}
+
+static void check_ColorBuffer_range(lua_State *L, const ColorBuffer *buffer, const int idx, int *first, int *last) {
+    lua_Integer i = luaL_optinteger(L, idx, 1), j = luaL_optinteger(L, idx + 1, buffer->count);
+    luaL_argcheck(L, i >= 1 && i <= buffer->count + 1, idx, "index out of range");
+    luaL_argcheck(L, j >= i - 1 && j <= buffer->count, idx + 1, "index out of range");
+    *first = (int)i - 1;
+    *last = (int)j;
+}
+
+static int f_ColorBuffer(lua_State *L) {
+    lua_Integer width = luaL_checkinteger(L, 1), height = luaL_optinteger(L, 2, 1);
+    luaL_argcheck(L, width >= 0 && width <= INT_MAX / (int)sizeof(Color), 1, "invalid width");
+    luaL_argcheck(L, height >= 0 && (width == 0 || height <= INT_MAX / (int)sizeof(Color) / width), 2, "invalid height");
+    ColorBuffer *buffer = push_ColorBuffer(L, (int)width, (int)height, NULL);
+    if (!lua_isnoneornil(L, 3)) {
+        const Color color = *check_Color(L, 3);
+        for (int i = 0; i < buffer->count; ++i) buffer->colors[i] = color;
+    }
+    return 1;
+}
+
+static int f_ColorBuffer__tostring(lua_State *L) {
+    const ColorBuffer *buffer = check_ColorBuffer(L, 1);
+    lua_pushfstring(L, "ColorBuffer(width = %d, height = %d)", buffer->width, buffer->height);
+    return 1;
+}
+
+static int f_ColorBuffer__len(lua_State *L) {
+    lua_pushinteger(L, check_ColorBuffer(L, 1)->count);
+    return 1;
+}
+
+static int f_ColorBuffer_Get(lua_State *L) {
+    const ColorBuffer *buffer = check_ColorBuffer(L, 1);
+    return push_Color(L, buffer->colors[check_ColorBuffer_index(L, buffer, 2)]);
+}
+
+static int f_ColorBuffer_GetRGBA(lua_State *L) {
+    const ColorBuffer *buffer = check_ColorBuffer(L, 1);
+    const Color color = buffer->colors[check_ColorBuffer_index(L, buffer, 2)];
+    lua_pushinteger(L, color.r);
+    lua_pushinteger(L, color.g);
+    lua_pushinteger(L, color.b);
+    lua_pushinteger(L, color.a);
+    return 4;
+}
+
+static int f_ColorBuffer_Set(lua_State *L) {
+    ColorBuffer *buffer = check_ColorBuffer(L, 1);
+    buffer->colors[check_ColorBuffer_index(L, buffer, 2)] = check_Color_RGBA(L, 3);
+    return 0;
+}
+
+static int f_ColorBuffer_Fill(lua_State *L) {
+    int first, last;
+    ColorBuffer *buffer = check_ColorBuffer(L, 1);
+    const Color color = *check_Color(L, 2);
+    check_ColorBuffer_range(L, buffer, 3, &first, &last);
+    for (int i = first; i < last; ++i) buffer->colors[i] = color;
+    return 0;
+}
+
+static int f_ColorBuffer_Map(lua_State *L) {
+    int first, last;
+    ColorBuffer *buffer = check_ColorBuffer(L, 1);
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+    check_ColorBuffer_range(L, buffer, 3, &first, &last);
+    // the callback gets (r, g, b, a, index) and returns the new r, g, b, a
+    for (int i = first; i < last; ++i) {
+        Color *color = &buffer->colors[i];
+        lua_pushvalue(L, 2);
+        lua_pushinteger(L, color->r);
+        lua_pushinteger(L, color->g);
+        lua_pushinteger(L, color->b);
+        lua_pushinteger(L, color->a);
+        lua_pushinteger(L, i + 1);
+        lua_call(L, 5, 4);
+        if (!lua_isnil(L, -4)) {
+            color->r = to_color_component(L, -4);
+            color->g = to_color_component(L, -3);
+            color->b = to_color_component(L, -2);
+            color->a = lua_isnil(L, -1) ? color->a : to_color_component(L, -1);
+        }
+        lua_pop(L, 4);
+    }
+    return 0;
+}
+
+static int f_ColorBuffer_get_width(lua_State *L) {
+    lua_pushinteger(L, check_ColorBuffer(L, 1)->width);
+    return 1;
+}
+
+static int f_ColorBuffer_get_height(lua_State *L) {
+    lua_pushinteger(L, check_ColorBuffer(L, 1)->height);
+    return 1;
+}
+
+static int f_ColorBuffer_get_count(lua_State *L) {
+    lua_pushinteger(L, check_ColorBuffer(L, 1)->count);
+    return 1;
+}
+
+
 //==[[ Rectangle object ]]======================================================
 
 static int push_Rectangle(lua_State *L, const Rectangle rect) {
@@ -489,14 +884,6 @@ static int f_Rectangle__tostring(lua_State *L) {
     return 1;
 }
 
-static int f_Rectangle__index(lua_State *L) {
-    return push_index(L, "Rectangle");
-}
-
-static int f_Rectangle__newindex(lua_State *L) {
-    return push_newindex(L, "Rectangle");
-}
-
 static int f_Rectangle_get_x(lua_State *L) {
     lua_pushnumber(L, check_Rectangle(L, 1)->x);
     return 1;
@@ -563,10 +950,6 @@ static int f_Image__gc(lua_State *L) {
     return 0;
 }
 
-static int f_Image__index(lua_State *L) {
-    return push_index(L, "Image");
-}
-
 
 //==[[ Texture object ]]========================================================
 
@@ -575,7 +958,17 @@ static int push_Texture(lua_State *L, const Texture texture) {
     return 1;
 }
 
+// References a Texture owned by the object at index 1, e.g. the color buffer of a RenderTexture
+static int push_Texture_Ref(lua_State *L, Texture *texture) {
+    *((Texture**)push_object(L, "Texture*", sizeof(Texture*), 1)) = texture;
+    lua_pushvalue(L, 1);
+    lua_setiuservalue(L, -2, 1);
+    return 1;
+}
+
 static Texture *check_Texture(lua_State *L, const int idx) {
+    Texture **ref = luaL_testudata(L, idx, "Texture*");
+    if (ref != NULL) return *ref;
     return luaL_checkudata(L, idx, "Texture");
 }
 
@@ -585,12 +978,10 @@ static int f_Texture__tostring(lua_State *L) {
     return 1;
 }
 
-static int f_Texture__index(lua_State *L) {
-    return push_index(L, "Texture");
-}
-
 static int f_Texture__gc(lua_State *L) {
-    UnloadTexture(*check_Texture(L, 1));
+    // references are unloaded by their owner
+    const Texture *texture = luaL_testudata(L, 1, "Texture");
+    if (texture != NULL) UnloadTexture(*texture);
     return 0;
 }
 
@@ -605,6 +996,119 @@ static int f_Texture_get_height(lua_State *L) {
 }
 
 
+//==[[ RenderTexture object ]]==================================================
+
+// Render targets are expensive to create, so AcquireRenderTexture() recycles
+// released ones of the same size. Pooled targets left unused for a while are
+// unloaded at the end of a frame.
+
+#define RENDER_POOL_SIZE 32
+#define RENDER_POOL_FRAMES 120
+
+typedef struct RenderTextureObject {
+    RenderTexture target;
+    bool pooled;    // returned to the pool instead of unloaded when collected
+} RenderTextureObject;
+
+static struct {
+    int count;
+    unsigned int frame;
+    struct {
+        RenderTexture target;
+        unsigned int frame;     // frame of the release
+    } entries[RENDER_POOL_SIZE];
+} render_pool;
+
+static RenderTexture *check_RenderTexture(lua_State *L, const int idx) {
+    return &((RenderTextureObject*)luaL_checkudata(L, idx, "RenderTexture"))->target;
+}
+
+static RenderTexture *check_RenderTexture_loaded(lua_State *L, const int idx) {
+    RenderTexture *target = check_RenderTexture(L, idx);
+    luaL_argcheck(L, target->id != 0, idx, "RenderTexture has been released");
+    return target;
+}
+
+static int push_RenderTexture(lua_State *L, const RenderTexture target, const bool pooled) {
+    *((RenderTextureObject*)push_object(L, "RenderTexture", sizeof(RenderTextureObject), 0)) = (RenderTextureObject){ target, pooled };
+    return 1;
+}
+
+static void release_render_target(const RenderTexture target) {
+    if (target.id == 0) return;
+    // no GL context left to return it to
+    if (!IsWindowReady()) return;
+    if (render_pool.count == RENDER_POOL_SIZE) {
+        // make room by dropping the oldest release
+        UnloadRenderTexture(render_pool.entries[0].target);
+        memmove(&render_pool.entries[0], &render_pool.entries[1], sizeof(render_pool.entries[0]) * (RENDER_POOL_SIZE - 1));
+        render_pool.count--;
+    }
+    render_pool.entries[render_pool.count].target = target;
+    render_pool.entries[render_pool.count].frame = render_pool.frame;
+    render_pool.count++;
+}
+
+static RenderTexture acquire_render_target(const int width, const int height) {
+    // the most recently released one is the likeliest to still be in the GPU caches
+    for (int i = render_pool.count - 1; i >= 0; --i) {
+        const RenderTexture target = render_pool.entries[i].target;
+        if (target.texture.width != width || target.texture.height != height) continue;
+        memmove(&render_pool.entries[i], &render_pool.entries[i + 1], sizeof(render_pool.entries[0]) * (size_t)(render_pool.count - i - 1));
+        render_pool.count--;
+        return target;
+    }
+    return LoadRenderTexture(width, height);
+}
+
+// Called after every frame, unloads pooled targets unused for RENDER_POOL_FRAMES frames
+static void TrimRenderTexturePool(void) {
+    render_pool.frame++;
+    int count = 0;
+    for (int i = 0; i < render_pool.count; ++i) {
+        if (render_pool.frame - render_pool.entries[i].frame > RENDER_POOL_FRAMES)
+            UnloadRenderTexture(render_pool.entries[i].target);
+        else
+            render_pool.entries[count++] = render_pool.entries[i];
+    }
+    render_pool.count = count;
+}
+
+static void ReleaseRenderTexturePool(void) {
+    for (int i = 0; i < render_pool.count; ++i)
+        UnloadRenderTexture(render_pool.entries[i].target);
+    render_pool.count = 0;
+}
+
+static int f_RenderTexture__tostring(lua_State *L) {
+    const RenderTexture *target = check_RenderTexture(L, 1);
+    lua_pushfstring(L, "RenderTexture(id = %d, width = %d, height = %d)", target->id, target->texture.width, target->texture.height);
+    return 1;
+}
+
+static int f_RenderTexture__gc(lua_State *L) {
+    RenderTextureObject *object = luaL_checkudata(L, 1, "RenderTexture");
+    if (object->pooled) release_render_target(object->target);
+    else if (object->target.id != 0) UnloadRenderTexture(object->target);
+    object->target = (RenderTexture){ 0 };
+    return 0;
+}
+
+static int f_RenderTexture_get_texture(lua_State *L) {
+    return push_Texture_Ref(L, &check_RenderTexture(L, 1)->texture);
+}
+
+static int f_RenderTexture_get_width(lua_State *L) {
+    lua_pushinteger(L, check_RenderTexture(L, 1)->texture.width);
+    return 1;
+}
+
+static int f_RenderTexture_get_height(lua_State *L) {
+    lua_pushinteger(L, check_RenderTexture(L, 1)->texture.height);
+    return 1;
+}
+
+
 //==[[ Font object ]]===========================================================
 
 static int push_Font(lua_State *L, const Font font) {
@@ -660,14 +1164,6 @@ static int f_Camera3D__tostring(lua_State *L) {
     return 1;
 }
 
-static int f_Camera3D__index(lua_State *L) {
-    return push_index(L, "Camera3D");
-}
-
-static int f_Camera3D__newindex(lua_State *L) {
-    return push_newindex(L, "Camera3D");
-}
-
 static int f_Camera3D_get_position(lua_State *L) {
     return push_Vector3_Ref(L, &check_Camera3D(L, 1)->position);
 }
@@ -741,157 +1237,4785 @@ static int f_Camera2D(lua_State *L) {
     }
 }
 
-static int f_Camera2D__tostring(lua_State *L) {
-    const Camera2D *camera = check_Camera2D(L, 1);
-    lua_pushfstring(L, "Camera2D(%p)", camera);
+static int f_Camera2D__tostring(lua_State *L) {
+    const Camera2D *camera = check_Camera2D(L, 1);
+    lua_pushfstring(L, "Camera2D(%p)", camera);
+    return 1;
+}
+
+static int f_Camera2D_get_offset(lua_State *L) {
+    return push_Vector2_Ref(L, &check_Camera2D(L, 1)->offset);
+}
+
+static int f_Camera2D_set_offset(lua_State *L) {
+    check_Camera2D(L, 1)->offset = *check_Vector2(L, 2);
+    return 0;
+}
+
+static int f_Camera2D_get_target(lua_State *L) {
+    return push_Vector2_Ref(L, &check_Camera2D(L, 1)->target);
+}
+
+static int f_Camera2D_set_target(lua_State *L) {
+    check_Camera2D(L, 1)->target = *check_Vector2(L, 2);
+    return 0;
+}
+
+static int f_Camera2D_get_rotation(lua_State *L) {
+     lua_pushnumber(L, check_Camera2D(L, 1)->rotation);
+     return 1;
+}
+
+static int f_Camera2D_set_rotation(lua_State *L) {
+    check_Camera2D(L, 1)->rotation = (float)luaL_checknumber(L, 2);
+    return 0;
+}
+
+static int f_Camera2D_get_zoom(lua_State *L) {
+     lua_pushnumber(L, check_Camera2D(L, 1)->zoom);
+     return 1;
+}
+
+static int f_Camera2D_set_zoom(lua_State *L) {
+    check_Camera2D(L, 1)->zoom = (float)luaL_checknumber(L, 2);
+    return 0;
+}
+
+
+//==[[ Wave object ]]===========================================================
+
+static int push_Wave(lua_State *L, const Wave wave) {
+    *((Wave*)push_object(L, "Wave", sizeof(Wave), 0)) = wave;
+    return 1;
+}
+
+static Wave *check_Wave(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "Wave");
+}
+
+static int f_Wave__gc(lua_State *L) {
+    UnloadWave(*check_Wave(L, 1));
+    return 0;
+}
+
+static int f_Wave__tostring(lua_State *L) {
+    const Wave *wave = check_Wave(L, 1);
+    lua_pushfstring(L, "Wave(%p)", wave);
+    return 1;
+}
+
+static int f_Wave_get_frameCount(lua_State *L) {
+     lua_pushinteger(L, check_Wave(L, 1)->frameCount);
+     return 1;
+}
+
+static int f_Wave_get_sampleRate(lua_State *L) {
+     lua_pushinteger(L, check_Wave(L, 1)->sampleRate);
+     return 1;
+}
+
+static int f_Wave_get_sampleSize(lua_State *L) {
+     lua_pushinteger(L, check_Wave(L, 1)->sampleSize);
+     return 1;
+}
+
+static int f_Wave_get_channels(lua_State *L) {
+     lua_pushinteger(L, check_Wave(L, 1)->channels);
+     return 1;
+}
+
+
+//==[[ SampleBuffer object ]]===================================================
+
+typedef struct SampleBuffer {
+    int frameCount;
+    int channels;
+    int stride; // distance between two frames, differs from 'channels' for channel views
+    int sampleRate;
+    float *samples; // points to 'data' or into the buffer this one is a view of
+    float data[];
+} SampleBuffer;
+
+static SampleBuffer *push_SampleBuffer(lua_State *L, const int frameCount, const int channels, const int sampleRate) {
+    const size_t count = (size_t)frameCount * (size_t)channels;
+    SampleBuffer *buffer = push_object(L, "SampleBuffer", sizeof(SampleBuffer) + sizeof(float) * count, 1);
+    buffer->frameCount = frameCount;
+    buffer->channels = channels;
+    buffer->stride = channels;
+    buffer->sampleRate = sampleRate;
+    buffer->samples = buffer->data;
+    memset(buffer->data, 0, sizeof(float) * count);
+    return buffer;
+}
+
+static SampleBuffer *push_SampleBuffer_View(lua_State *L, const int parent, const SampleBuffer view) {
+    SampleBuffer *buffer = push_object(L, "SampleBuffer", sizeof(SampleBuffer), 1);
+    *buffer = view;
+    // keep the buffer owning the samples alive as long as the view exists
+    lua_pushvalue(L, parent);
+    lua_setiuservalue(L, -2, 1);
+    return buffer;
+}
+
+static SampleBuffer *check_SampleBuffer(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "SampleBuffer");
+}
+
+// Returns the samples without gaps, views with a stride are packed into a temporary userdata
+static const float *pack_SampleBuffer(lua_State *L, const SampleBuffer *buffer) {
+    if (buffer->stride == buffer->channels) return buffer->samples;
+    float *packed = lua_newuserdatauv(L, sizeof(float) * (size_t)buffer->frameCount * (size_t)buffer->channels + 1, 0);
+    for (int f = 0; f < buffer->frameCount; ++f)
+        memcpy(&packed[f * buffer->channels], &buffer->samples[f * buffer->stride], sizeof(float) * (size_t)buffer->channels);
+    return packed;
+}
+
+static float *check_SampleBuffer_sample(lua_State *L, SampleBuffer *buffer, const int idx) {
+    lua_Integer i = luaL_checkinteger(L, idx);
+    luaL_argcheck(L, i >= 1 && i <= (lua_Integer)buffer->frameCount * buffer->channels, idx, "index out of range");
+    --i;
+    return &buffer->samples[(i / buffer->channels) * buffer->stride + (i % buffer->channels)];
+}
+
+static void check_SampleBuffer_size(lua_State *L, const lua_Integer frameCount, const lua_Integer channels) {
+    luaL_argcheck(L, channels >= 1 && channels <= 64, 2, "invalid channel count");
+    luaL_argcheck(L, frameCount >= 0 && frameCount <= INT_MAX / (int)sizeof(float) / channels, 1, "invalid frame count");
+}
+
+static int f_SampleBuffer(lua_State *L) {
+    lua_Integer frameCount = luaL_checkinteger(L, 1), channels = luaL_optinteger(L, 2, 1);
+    const lua_Integer sampleRate = luaL_optinteger(L, 3, 44100);
+    check_SampleBuffer_size(L, frameCount, channels);
+    luaL_argcheck(L, sampleRate > 0 && sampleRate <= INT_MAX, 3, "invalid sample rate");
+    push_SampleBuffer(L, (int)frameCount, (int)channels, (int)sampleRate);
+    return 1;
+}
+
+static int f_SampleBuffer__tostring(lua_State *L) {
+    const SampleBuffer *buffer = check_SampleBuffer(L, 1);
+    lua_pushfstring(L, "SampleBuffer(frameCount = %d, channels = %d, sampleRate = %d)", buffer->frameCount, buffer->channels, buffer->sampleRate);
+    return 1;
+}
+
+static int f_SampleBuffer__len(lua_State *L) {
+    const SampleBuffer *buffer = check_SampleBuffer(L, 1);
+    lua_pushinteger(L, (lua_Integer)buffer->frameCount * buffer->channels);
+    return 1;
+}
+
+static int f_SampleBuffer_Get(lua_State *L) {
+    lua_pushnumber(L, *check_SampleBuffer_sample(L, check_SampleBuffer(L, 1), 2));
+    return 1;
+}
+
+static int f_SampleBuffer_Set(lua_State *L) {
+    *check_SampleBuffer_sample(L, check_SampleBuffer(L, 1), 2) = (float)luaL_checknumber(L, 3);
+    return 0;
+}
+
+static int f_SampleBuffer_Slice(lua_State *L) {
+    SampleBuffer view = *check_SampleBuffer(L, 1);
+    lua_Integer first = luaL_checkinteger(L, 2), last = luaL_optinteger(L, 3, view.frameCount);
+    luaL_argcheck(L, first >= 1 && first <= view.frameCount + 1, 2, "frame out of range");
+    luaL_argcheck(L, last >= first - 1 && last <= view.frameCount, 3, "frame out of range");
+    view.samples += (first - 1) * view.stride;
+    view.frameCount = (int)(last - first + 1);
+    push_SampleBuffer_View(L, 1, view);
+    return 1;
+}
+
+static int f_SampleBuffer_Channel(lua_State *L) {
+    SampleBuffer view = *check_SampleBuffer(L, 1);
+    lua_Integer channel = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, channel >= 1 && channel <= view.channels, 2, "channel out of range");
+    view.samples += channel - 1;
+    view.channels = 1;
+    push_SampleBuffer_View(L, 1, view);
+    return 1;
+}
+
+static int f_SampleBuffer_Copy(lua_State *L) {
+    const SampleBuffer *source = check_SampleBuffer(L, 1);
+    SampleBuffer *buffer = push_SampleBuffer(L, source->frameCount, source->channels, source->sampleRate);
+    for (int f = 0; f < source->frameCount; ++f)
+        memcpy(&buffer->samples[f * buffer->stride], &source->samples[f * source->stride], sizeof(float) * (size_t)source->channels);
+    return 1;
+}
+
+static int f_SampleBuffer_Gain(lua_State *L) {
+    SampleBuffer *buffer = check_SampleBuffer(L, 1);
+    const float gain = (float)luaL_checknumber(L, 2);
+    for (int f = 0; f < buffer->frameCount; ++f) {
+        float *frame = &buffer->samples[f * buffer->stride];
+        for (int c = 0; c < buffer->channels; ++c) frame[c] *= gain;
+    }
+    return 0;
+}
+
+static int f_SampleBuffer_Mix(lua_State *L) {
+    SampleBuffer *buffer = check_SampleBuffer(L, 1);
+    const SampleBuffer *other = check_SampleBuffer(L, 2);
+    const float gain = (float)luaL_optnumber(L, 3, 1.0);
+    luaL_argcheck(L, other->channels == buffer->channels || other->channels == 1, 2, "channel count mismatch");
+    const int frames = other->frameCount < buffer->frameCount ? other->frameCount : buffer->frameCount;
+    // a mono source is mixed into every channel
+    for (int f = 0; f < frames; ++f) {
+        float *dst = &buffer->samples[f * buffer->stride];
+        const float *src = &other->samples[f * other->stride];
+        for (int c = 0; c < buffer->channels; ++c) dst[c] += src[other->channels == 1 ? 0 : c] * gain;
+    }
+    return 0;
+}
+
+static float get_SampleBuffer_peak(const SampleBuffer *buffer) {
+    float peak = 0.0f;
+    for (int f = 0; f < buffer->frameCount; ++f) {
+        const float *frame = &buffer->samples[f * buffer->stride];
+        for (int c = 0; c < buffer->channels; ++c) {
+            const float value = fabsf(frame[c]);
+            if (value > peak) peak = value;
+        }
+    }
+    return peak;
+}
+
+static int f_SampleBuffer_Peak(lua_State *L) {
+    lua_pushnumber(L, get_SampleBuffer_peak(check_SampleBuffer(L, 1)));
+    return 1;
+}
+
+static int f_SampleBuffer_RMS(lua_State *L) {
+    const SampleBuffer *buffer = check_SampleBuffer(L, 1);
+    double sum = 0.0;
+    for (int f = 0; f < buffer->frameCount; ++f) {
+        const float *frame = &buffer->samples[f * buffer->stride];
+        for (int c = 0; c < buffer->channels; ++c) sum += (double)frame[c] * frame[c];
+    }
+    const double count = (double)buffer->frameCount * buffer->channels;
+    lua_pushnumber(L, count > 0.0 ? sqrt(sum / count) : 0.0);
+    return 1;
+}
+
+static int f_SampleBuffer_Normalize(lua_State *L) {
+    SampleBuffer *buffer = check_SampleBuffer(L, 1);
+    const float target = (float)luaL_optnumber(L, 2, 1.0);
+    const float peak = get_SampleBuffer_peak(buffer);
+    if (peak > 0.0f) {
+        lua_settop(L, 1);
+        lua_pushnumber(L, target / peak);
+        f_SampleBuffer_Gain(L);
+    }
+    lua_pushnumber(L, peak);
+    return 1;
+}
+
+static int f_SampleBuffer_get_frameCount(lua_State *L) {
+    lua_pushinteger(L, check_SampleBuffer(L, 1)->frameCount);
+    return 1;
+}
+
+static int f_SampleBuffer_get_channels(lua_State *L) {
+    lua_pushinteger(L, check_SampleBuffer(L, 1)->channels);
+    return 1;
+}
+
+static int f_SampleBuffer_get_sampleRate(lua_State *L) {
+    lua_pushinteger(L, check_SampleBuffer(L, 1)->sampleRate);
+    return 1;
+}
+
+static int f_SampleBuffer_set_sampleRate(lua_State *L) {
+    lua_Integer sampleRate = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, sampleRate > 0 && sampleRate <= INT_MAX, 2, "invalid sample rate");
+    check_SampleBuffer(L, 1)->sampleRate = (int)sampleRate;
+    return 0;
+}
+
+
+//==[[ Sound object ]]===========================================================
+
+static int push_Sound(lua_State *L, const Sound sound) {
+    *((Sound*)push_object(L, "Sound", sizeof(Sound), 0)) = sound;
+    return 1;
+}
+
+static Sound *check_Sound(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "Sound");
+}
+
+static int f_Sound__gc(lua_State *L) {
+    UnloadSound(*check_Sound(L, 1));
+    return 0;
+}
+
+static int f_Sound__tostring(lua_State *L) {
+    const Sound *sound = check_Sound(L, 1);
+    lua_pushfstring(L, "Sound(%p)", sound);
+    return 1;
+}
+
+
+//==[[ Music object ]]===========================================================
+
+// Music is refilled by UpdateMusicStream(), normally called by Lua once per
+// frame, so a slow frame underruns it. Streams moved to the background are
+// refilled by a worker thread instead, which also runs crossfades. Calls on a
+// background stream lock music_worker.mutex, the worker holds it while it
+// decodes; foreground streams never lock.
+
+#define MUSIC_WORKER_MAX 16
+
+typedef struct MusicObject {
+    Music music;
+    float volume;           // volume set by Lua, the fade gain scales it
+    float gain;
+    float fadeFrom, fadeTo;
+    double fadeStart, fadeDuration;
+    double interval;        // refill period, a quarter of a sub-buffer
+    bool background;
+    bool fading;
+    bool stopAfterFade;
+} MusicObject;
+
+static struct {
+    bool started;
+    bool quit;
+    int count;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;    // signalled when a stream is added or the worker quits
+    MusicObject *streams[MUSIC_WORKER_MAX];
+} music_worker = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+};
+
+// last value passed to SetAudioStreamBufferSizeDefault(), raylib has no getter
+static int audio_buffer_size_default;
+
+static double music_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// 'frames' is the sub-buffer size the stream was loaded with, raylib keeps two
+static int push_Music(lua_State *L, const Music music, int frames) {
+    MusicObject *object = push_object(L, "Music", sizeof(MusicObject), 1);
+    const unsigned int sampleRate = music.stream.sampleRate > 0 ? music.stream.sampleRate : 44100;
+    if (frames <= 0) frames = audio_buffer_size_default > 0 ? audio_buffer_size_default : (int)sampleRate / 30;
+    const double interval = (double)frames / sampleRate / 4.0;
+    *object = (MusicObject){
+        .music = music,
+        .volume = 1.0f,
+        .gain = 1.0f,
+        .interval = interval < 0.001 ? 0.001 : interval > 0.01 ? 0.01 : interval,
+    };
+    return 1;
+}
+
+static MusicObject *check_MusicObject(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "Music");
+}
+
+static Music *check_Music(lua_State *L, const int idx) {
+    return &check_MusicObject(L, idx)->music;
+}
+
+// the background flag only changes on the main thread, so it can be read unlocked
+static void lock_Music(const MusicObject *object) {
+    if (object->background) pthread_mutex_lock(&music_worker.mutex);
+}
+
+static void unlock_Music(const MusicObject *object) {
+    if (object->background) pthread_mutex_unlock(&music_worker.mutex);
+}
+
+// Sets the fade gain and the stream volume, called with the stream locked
+static void set_Music_gain(MusicObject *object, const float gain) {
+    object->gain = gain;
+    SetMusicVolume(object->music, object->volume * gain);
+}
+
+static void start_Music_fade(MusicObject *object, const float gain, const double duration, const bool stop) {
+    object->fadeFrom = object->gain;
+    object->fadeTo = gain;
+    object->fadeStart = music_clock();
+    object->fadeDuration = duration;
+    object->fading = true;
+    object->stopAfterFade = stop;
+}
+
+static void cancel_Music_fade(MusicObject *object) {
+    object->fading = false;
+    set_Music_gain(object, 1.0f);
+}
+
+static void update_Music_fade(MusicObject *object, const double now) {
+    const double t = object->fadeDuration > 0.0 ? (now - object->fadeStart) / object->fadeDuration : 1.0;
+    if (t < 1.0) {
+        set_Music_gain(object, object->fadeFrom + (object->fadeTo - object->fadeFrom) * (float)t);
+        return;
+    }
+    object->fading = false;
+    if (object->stopAfterFade) {
+        StopMusicStream(object->music);
+        set_Music_gain(object, 1.0f);
+    } else {
+        set_Music_gain(object, object->fadeTo);
+    }
+}
+
+static void *music_worker_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&music_worker.mutex);
+    while (!music_worker.quit) {
+        const double now = music_clock();
+        double interval = 0.01;
+        for (int i = 0; i < music_worker.count; ++i) {
+            MusicObject *object = music_worker.streams[i];
+            if (object->fading) update_Music_fade(object, now);
+            if (object->interval < interval) interval = object->interval;
+            if (IsMusicStreamPlaying(object->music)) UpdateMusicStream(object->music);
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += (long)(interval * 1e9);
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&music_worker.wake, &music_worker.mutex, &deadline);
+    }
+    pthread_mutex_unlock(&music_worker.mutex);
+    return NULL;
+}
+
+static void add_background_Music(lua_State *L, MusicObject *object) {
+    if (object->background) return;
+    if (music_worker.count == MUSIC_WORKER_MAX) luaL_error(L, "too many background music streams");
+    if (!music_worker.started) {
+        music_worker.quit = false;
+        if (pthread_create(&music_worker.thread, NULL, music_worker_main, NULL) != 0)
+            luaL_error(L, "cannot start music thread");
+        music_worker.started = true;
+    }
+    pthread_mutex_lock(&music_worker.mutex);
+    music_worker.streams[music_worker.count++] = object;
+    object->background = true;
+    pthread_cond_signal(&music_worker.wake);
+    pthread_mutex_unlock(&music_worker.mutex);
+}
+
+// Hands the stream back to the main thread, a running fade jumps to its end
+static void remove_background_Music(MusicObject *object) {
+    if (!object->background) return;
+    pthread_mutex_lock(&music_worker.mutex);
+    for (int i = 0; i < music_worker.count; ++i) {
+        if (music_worker.streams[i] != object) continue;
+        music_worker.streams[i] = music_worker.streams[--music_worker.count];
+        break;
+    }
+    if (object->fading) update_Music_fade(object, object->fadeStart + object->fadeDuration);
+    object->background = false;
+    pthread_mutex_unlock(&music_worker.mutex);
+}
+
+static void ReleaseMusicWorker(void) {
+    if (!music_worker.started) return;
+    pthread_mutex_lock(&music_worker.mutex);
+    music_worker.quit = true;
+    pthread_cond_signal(&music_worker.wake);
+    pthread_mutex_unlock(&music_worker.mutex);
+    pthread_join(music_worker.thread, NULL);
+    music_worker.started = false;
+}
+
+static int f_Music__gc(lua_State *L) {
+    MusicObject *object = check_MusicObject(L, 1);
+    // the worker must drop the stream before it is unloaded
+    remove_background_Music(object);
+    UnloadMusicStream(object->music);
+    return 0;
+}
+
+static int f_Music__tostring(lua_State *L) {
+    const Music *music = check_Music(L, 1);
+    lua_pushfstring(L, "Music(%p)", music);
+    return 1;
+}
+
+static int f_Music_get_background(lua_State *L) {
+    lua_pushboolean(L, check_MusicObject(L, 1)->background);
+    return 1;
+}
+
+static int f_Music_set_background(lua_State *L) {
+    MusicObject *object = check_MusicObject(L, 1);
+    if (lua_toboolean(L, 2)) add_background_Music(L, object);
+    else remove_background_Music(object);
+    return 0;
+}
+
+
+//==[[ AudioStream object ]]====================================================
+
+// Streams created with a ring size are fed from a lock-free single producer,
+// single consumer ring buffer: Lua writes frames on the main thread, the audio
+// thread reads them in raylib's stream callback and never waits for Lua. An
+// empty ring plays silence and counts an underrun.
+//
+// raylib's AudioCallback has no user pointer, so callbacks are taken from a
+// fixed set of trampolines, one per slot.
+
+#define AUDIO_SLOT_COUNT 8
+#define AUDIO_RING_MAX_FRAMES (1 << 22)
+
+// GCC/Clang builtins, <stdatomic.h> is not available in C99
+#define ATOMIC_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+typedef void (*AudioSlotFunc)(void *data, float *buffer, unsigned int frames);
+
+// slots are only changed on the main thread: set before the callback is
+// installed and cleared after the stream is unloaded. func is published with a
+// release store after data and read with an acquire load by the trampolines,
+// so an audio thread seeing func also sees its data
+static struct {
+    AudioSlotFunc func;
+    void *data;
+} audio_slots[AUDIO_SLOT_COUNT];
+
+#define AUDIO_SLOT_CALLBACK(n) \
+    static void audio_slot_callback_##n(void *buffer, unsigned int frames) { \
+        const AudioSlotFunc func = ATOMIC_LOAD(&audio_slots[n].func); \
+        if (func != NULL) func(audio_slots[n].data, buffer, frames); \
+    }
+AUDIO_SLOT_CALLBACK(0) AUDIO_SLOT_CALLBACK(1) AUDIO_SLOT_CALLBACK(2) AUDIO_SLOT_CALLBACK(3)
+AUDIO_SLOT_CALLBACK(4) AUDIO_SLOT_CALLBACK(5) AUDIO_SLOT_CALLBACK(6) AUDIO_SLOT_CALLBACK(7)
+
+static const AudioCallback audio_slot_callbacks[AUDIO_SLOT_COUNT] = {
+    audio_slot_callback_0, audio_slot_callback_1, audio_slot_callback_2, audio_slot_callback_3,
+    audio_slot_callback_4, audio_slot_callback_5, audio_slot_callback_6, audio_slot_callback_7,
+};
+
+// Returns a free slot calling func(data, ...) or -1
+static int acquire_audio_slot(AudioSlotFunc func, void *data) {
+    for (int i = 0; i < AUDIO_SLOT_COUNT; ++i) {
+        if (audio_slots[i].func != NULL) continue;
+        audio_slots[i].data = data;
+        ATOMIC_STORE(&audio_slots[i].func, func);
+        return i;
+    }
+    return -1;
+}
+
+static void release_audio_slot(const int slot) {
+    ATOMIC_STORE(&audio_slots[slot].func, (AudioSlotFunc)NULL);
+    audio_slots[slot].data = NULL;
+}
+
+typedef struct AudioRing {
+    unsigned int capacity;      // frames, a power of two
+    unsigned int channels;
+    // free running frame counters, head - tail frames are queued; kept on
+    // separate cache lines as each is written by a different thread
+    unsigned int head;          // written by the main thread
+    char pad0[60];
+    unsigned int tail;          // written by the audio thread
+    unsigned int underruns;
+    char pad1[56];
+    float samples[];
+} AudioRing;
+
+typedef struct AudioStreamObject {
+    AudioStream stream;
+    AudioRing *ring;            // NULL for streams fed by UpdateAudioStream()
+    int slot;
+} AudioStreamObject;
+
+static AudioStreamObject *check_AudioStreamObject(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "AudioStream");
+}
+
+static AudioStream *check_AudioStream(lua_State *L, const int idx) {
+    return &check_AudioStreamObject(L, idx)->stream;
+}
+
+static void read_AudioRing(void *data, float *buffer, unsigned int frames) {
+    AudioRing *ring = data;
+    const unsigned int channels = ring->channels, mask = ring->capacity - 1;
+    const unsigned int tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    const unsigned int available = ATOMIC_LOAD(&ring->head) - tail;
+    const unsigned int count = frames < available ? frames : available;
+    const unsigned int first = tail & mask;
+    const unsigned int part = count < ring->capacity - first ? count : ring->capacity - first;
+    memcpy(buffer, &ring->samples[(size_t)first * channels], sizeof(float) * part * channels);
+    memcpy(buffer + (size_t)part * channels, ring->samples, sizeof(float) * (count - part) * channels);
+    ATOMIC_STORE(&ring->tail, tail + count);
+    if (count < frames) {
+        memset(buffer + (size_t)count * channels, 0, sizeof(float) * (frames - count) * channels);
+        __atomic_add_fetch(&ring->underruns, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static unsigned int get_AudioRing_queued(const AudioRing *ring) {
+    return ATOMIC_LOAD(&ring->head) - ATOMIC_LOAD(&ring->tail);
+}
+
+// Writes up to 'frames' frames of float samples, 'stride' floats apart, returns the frames written
+static unsigned int write_AudioRing(AudioRing *ring, const float *samples, const int stride, const unsigned int frames) {
+    const unsigned int channels = ring->channels, mask = ring->capacity - 1;
+    const unsigned int head = ring->head;
+    const unsigned int space = ring->capacity - (head - ATOMIC_LOAD(&ring->tail));
+    const unsigned int count = frames < space ? frames : space;
+    if (stride == (int)channels) {
+        const unsigned int first = head & mask;
+        const unsigned int part = count < ring->capacity - first ? count : ring->capacity - first;
+        memcpy(&ring->samples[(size_t)first * channels], samples, sizeof(float) * part * channels);
+        memcpy(ring->samples, samples + (size_t)part * channels, sizeof(float) * (count - part) * channels);
+    } else {
+        for (unsigned int f = 0; f < count; ++f)
+            memcpy(&ring->samples[(size_t)((head + f) & mask) * channels], &samples[(size_t)f * stride], sizeof(float) * channels);
+    }
+    ATOMIC_STORE(&ring->head, head + count);
+    return count;
+}
+
+// Like write_AudioRing for interleaved signed 16 bit samples
+static unsigned int write_AudioRing_s16(AudioRing *ring, const unsigned char *bytes, const unsigned int frames) {
+    const unsigned int channels = ring->channels, mask = ring->capacity - 1;
+    const unsigned int head = ring->head;
+    const unsigned int space = ring->capacity - (head - ATOMIC_LOAD(&ring->tail));
+    const unsigned int count = frames < space ? frames : space;
+    for (unsigned int f = 0; f < count; ++f) {
+        float *frame = &ring->samples[(size_t)((head + f) & mask) * channels];
+        for (unsigned int c = 0; c < channels; ++c, bytes += 2)
+            frame[c] = (float)(short)(bytes[0] | (bytes[1] << 8)) / 32768.0f;
+    }
+    ATOMIC_STORE(&ring->head, head + count);
+    return count;
+}
+
+static int f_AudioStream__gc(lua_State *L) {
+    AudioStreamObject *object = check_AudioStreamObject(L, 1);
+    // unloading detaches the callback under the audio lock, after that the ring is unused
+    if (object->stream.buffer != NULL) UnloadAudioStream(object->stream);
+    if (object->slot >= 0) release_audio_slot(object->slot);
+    free(object->ring);
+    *object = (AudioStreamObject){ .slot = -1 };
+    return 0;
+}
+
+static int f_AudioStream__tostring(lua_State *L) {
+    const AudioStream *stream = check_AudioStream(L, 1);
+    lua_pushfstring(L, "AudioStream(sampleRate = %d, sampleSize = %d, channels = %d)", (int)stream->sampleRate, (int)stream->sampleSize, (int)stream->channels);
+    return 1;
+}
+
+static int f_AudioStream_get_sampleRate(lua_State *L) {
+    lua_pushinteger(L, check_AudioStream(L, 1)->sampleRate);
+    return 1;
+}
+
+static int f_AudioStream_get_sampleSize(lua_State *L) {
+    lua_pushinteger(L, check_AudioStream(L, 1)->sampleSize);
+    return 1;
+}
+
+static int f_AudioStream_get_channels(lua_State *L) {
+    lua_pushinteger(L, check_AudioStream(L, 1)->channels);
+    return 1;
+}
+
+static int f_AudioStream_get_queued(lua_State *L) {
+    const AudioStreamObject *object = check_AudioStreamObject(L, 1);
+    lua_pushinteger(L, object->ring != NULL ? get_AudioRing_queued(object->ring) : 0);
+    return 1;
+}
+
+static int f_AudioStream_get_capacity(lua_State *L) {
+    const AudioStreamObject *object = check_AudioStreamObject(L, 1);
+    lua_pushinteger(L, object->ring != NULL ? object->ring->capacity : 0);
+    return 1;
+}
+
+static int f_AudioStream_get_underruns(lua_State *L) {
+    const AudioStreamObject *object = check_AudioStreamObject(L, 1);
+    lua_pushinteger(L, object->ring != NULL ? __atomic_load_n(&object->ring->underruns, __ATOMIC_RELAXED) : 0);
+    return 1;
+}
+
+
+//==[[ Mixer object ]]==========================================================
+
+// A native mixer rendering on the audio thread through an AudioStream
+// callback. Voices play SampleBuffers into submix buses, each bus runs its
+// effect chain and mixes into its parent, bus 1 is the master. Lua never
+// touches the audio thread's state: every change is queued as a command on a
+// lock-free single producer, single consumer queue and applied before the
+// next block is rendered.
+
+#define MIXER_BLOCK 256
+#define MIXER_MAX_VOICES 4096
+#define MIXER_MAX_BUSES 32
+#define MIXER_MAX_EFFECTS 4
+#define MIXER_EFFECT_PARAMS 5
+#define MIXER_QUEUE_SIZE 1024   // a power of two
+
+enum { MIXER_LOWPASS, MIXER_HIGHPASS, MIXER_REVERB, MIXER_COMPRESSOR };
+enum { MIXER_STEAL_NONE, MIXER_STEAL_OLDEST, MIXER_STEAL_QUIETEST };
+
+static const char *const mixer_steal_names[] = { "none", "oldest", "quietest", NULL };
+
+static const char *const mixer_effect_names[] = { "lowpass", "highpass", "reverb", "compressor", NULL };
+
+// parameter names per effect type, in the order of MixerEffect.params
+static const char *const mixer_effect_params[][MIXER_EFFECT_PARAMS + 1] = {
+    { "cutoff", "q" },                                          // Hz
+    { "cutoff", "q" },
+    { "room", "damping", "wet", "dry" },                        // 0 to 1
+    { "threshold", "ratio", "attack", "release", "makeup" },    // dB, x:1, seconds, dB
+};
+
+static const float mixer_effect_defaults[][MIXER_EFFECT_PARAMS] = {
+    { 1000.0f, 0.7071f },
+    { 200.0f, 0.7071f },
+    { 0.5f, 0.5f, 0.3f, 1.0f },
+    { -12.0f, 4.0f, 0.01f, 0.1f, 0.0f },
+};
+
+// Freeverb's tunings at 44100 Hz, the right channel is spread by 23 samples
+static const int reverb_comb_lengths[4] = { 1116, 1188, 1277, 1356 };
+static const int reverb_allpass_lengths[2] = { 556, 441 };
+
+typedef struct MixerEffect {
+    int type;
+    bool enabled;
+    bool dirty;                 // coefficients need an update
+    float params[MIXER_EFFECT_PARAMS];
+    float b0, b1, b2, a1, a2;   // biquad filters
+    float z[2][2];
+    float envelope;             // compressor, overshoot in dB
+    float attack, release;
+    float *comb[8];             // reverb, 4 comb and 2 allpass filters per channel
+    float *allpass[4];
+    int combLength[8], allpassLength[4];
+    int combIndex[8], allpassIndex[4];
+    float combStore[8];
+    float memory[];
+} MixerEffect;
+
+typedef struct MixerVoice {
+    unsigned int id;            // 0 when idle
+    const float *samples;
+    int frames, channels, stride;
+    double position;
+    float rate;                 // source frames per output frame at pitch 1
+    float pitch, gain, pan;
+    float left, right;          // current channel gains, ramped to gain and pan over a block
+    int bus;
+    bool loop;
+} MixerVoice;
+
+typedef struct MixerBus {
+    float gain;
+    int parent;
+    int effectCount;
+    MixerEffect *effects[MIXER_MAX_EFFECTS];
+} MixerBus;
+
+enum { MIXER_PLAY, MIXER_STOP, MIXER_STOP_ALL, MIXER_SET_VOICE, MIXER_SET_BUS, MIXER_ADD_EFFECT, MIXER_SET_EFFECT };
+
+typedef struct MixerCommand {
+    int type;
+    int index;                  // voice or bus
+    int effect;
+    int param;                  // -1 toggles the effect
+    float values[3];
+    MixerEffect *pointer;
+    MixerVoice voice;
+} MixerCommand;
+
+// Main thread bookkeeping of a voice, for limits and stealing
+typedef struct MixerSlot {
+    unsigned int id;            // id of the last voice started in the slot
+    const SampleBuffer *source;
+    int priority;
+    unsigned int order;         // start order, for stealing the oldest
+    float loudness;             // gain after distance attenuation, for stealing the quietest
+} MixerSlot;
+
+typedef struct MixerStats {
+    int peak, started, stolen, culled, rejected;
+} MixerStats;
+
+// uservalue 1: voice index -> SampleBuffer being played, 2: SampleBuffer -> limits (weak keys),
+// 3: queue position of a PLAY command -> SampleBuffer of the voice it steals
+typedef struct Mixer {
+    AudioStream stream;
+    int slot;
+    float sampleRate;
+    int voiceCount, busCount;
+    // audio thread
+    MixerVoice *voices;
+    MixerBus buses[MIXER_MAX_BUSES];
+    float *mix;                 // busCount blocks of stereo frames
+    // shared, see push_MixerCommand()
+    MixerCommand *commands;
+    unsigned int head;
+    char pad0[60];
+    unsigned int tail;
+    char pad1[60];
+    unsigned int *ended;        // id of the last voice that stopped in each slot
+    // main thread
+    MixerSlot *slots;
+    int effectCounts[MIXER_MAX_BUSES];
+    MixerEffect *effects[MIXER_MAX_BUSES][MIXER_MAX_EFFECTS];
+    int stealPolicy;
+    unsigned int order;
+    Vector2 listener;
+    float maxDistance;          // 0 disables distance attenuation and culling
+    MixerStats stats;           // since the last GetStats()
+    int retiring;               // entries in uservalue 3
+} Mixer;
+
+static Mixer *check_Mixer(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "Mixer");
+}
+
+static void update_MixerEffect(MixerEffect *effect, const float sampleRate) {
+    const float *p = effect->params;
+    effect->dirty = false;
+    if (effect->type == MIXER_LOWPASS || effect->type == MIXER_HIGHPASS) {
+        // RBJ audio EQ cookbook, normalized by a0
+        const float cutoff = fminf(fmaxf(p[0], 10.0f), sampleRate * 0.45f);
+        const float w = 2.0f * PI * cutoff / sampleRate, c = cosf(w);
+        const float alpha = sinf(w) / (2.0f * fmaxf(p[1], 0.05f)), a0 = 1.0f + alpha;
+        const float k = effect->type == MIXER_LOWPASS ? 1.0f - c : 1.0f + c;
+        effect->b0 = effect->b2 = k / 2.0f / a0;
+        effect->b1 = (effect->type == MIXER_LOWPASS ? k : -k) / a0;
+        effect->a1 = -2.0f * c / a0;
+        effect->a2 = (1.0f - alpha) / a0;
+    } else if (effect->type == MIXER_COMPRESSOR) {
+        effect->attack = expf(-1.0f / (fmaxf(p[2], 1e-4f) * sampleRate));
+        effect->release = expf(-1.0f / (fmaxf(p[3], 1e-4f) * sampleRate));
+    }
+}
+
+// Flushes values decaying towards zero before they become denormal, which is very slow on x86;
+// like Freeverb's undenormalise() for the filter states and delay lines
+static float flush_denormal(const float x) {
+    return fabsf(x) < 1e-15f ? 0.0f : x;
+}
+
+static void process_biquad(MixerEffect *effect, float *buffer, const int frames) {
+    for (int c = 0; c < 2; ++c) {
+        float z1 = effect->z[c][0], z2 = effect->z[c][1];
+        for (int f = 0; f < frames; ++f) {
+            // transposed direct form II
+            const float in = buffer[2 * f + c], out = effect->b0 * in + z1;
+            z1 = effect->b1 * in - effect->a1 * out + z2;
+            z2 = effect->b2 * in - effect->a2 * out;
+            buffer[2 * f + c] = out;
+        }
+        effect->z[c][0] = flush_denormal(z1);
+        effect->z[c][1] = flush_denormal(z2);
+    }
+}
+
+static void process_reverb(MixerEffect *effect, float *buffer, const int frames) {
+    const float feedback = 0.7f + 0.28f * fminf(fmaxf(effect->params[0], 0.0f), 1.0f);
+    const float damp = 0.4f * fminf(fmaxf(effect->params[1], 0.0f), 1.0f);
+    const float wet = 3.0f * effect->params[2], dry = effect->params[3];
+    for (int f = 0; f < frames; ++f) {
+        const float input = (buffer[2 * f] + buffer[2 * f + 1]) * 0.015f;
+        for (int c = 0; c < 2; ++c) {
+            float out = 0.0f;
+            for (int i = c * 4; i < c * 4 + 4; ++i) {
+                float *sample = &effect->comb[i][effect->combIndex[i]];
+                const float y = *sample;
+                effect->combStore[i] = flush_denormal(y * (1.0f - damp) + effect->combStore[i] * damp);
+                *sample = flush_denormal(input + effect->combStore[i] * feedback);
+                if (++effect->combIndex[i] == effect->combLength[i]) effect->combIndex[i] = 0;
+                out += y;
+            }
+            for (int i = c * 2; i < c * 2 + 2; ++i) {
+                float *sample = &effect->allpass[i][effect->allpassIndex[i]];
+                const float y = *sample;
+                *sample = flush_denormal(out + y * 0.5f);
+                if (++effect->allpassIndex[i] == effect->allpassLength[i]) effect->allpassIndex[i] = 0;
+                out = y - out;
+            }
+            buffer[2 * f + c] = buffer[2 * f + c] * dry + out * wet;
+        }
+    }
+}
+
+static void process_compressor(MixerEffect *effect, float *buffer, const int frames) {
+    const float threshold = effect->params[0], slope = 1.0f - 1.0f / fmaxf(effect->params[1], 1.0f), makeup = effect->params[4];
+    float envelope = effect->envelope;
+    for (int f = 0; f < frames; ++f) {
+        // stereo linked peak detector, smoothed in the dB domain
+        const float peak = fmaxf(fabsf(buffer[2 * f]), fabsf(buffer[2 * f + 1]));
+        const float over = fmaxf(20.0f * log10f(peak + 1e-9f) - threshold, 0.0f);
+        const float coef = over > envelope ? effect->attack : effect->release;
+        envelope = over + coef * (envelope - over);
+        const float gain = powf(10.0f, (makeup - envelope * slope) / 20.0f);
+        buffer[2 * f] *= gain;
+        buffer[2 * f + 1] *= gain;
+    }
+    effect->envelope = flush_denormal(envelope);
+}
+
+static void process_MixerEffect(MixerEffect *effect, float *buffer, const int frames, const float sampleRate) {
+    if (effect->dirty) update_MixerEffect(effect, sampleRate);
+    switch (effect->type) {
+        case MIXER_LOWPASS:
+        case MIXER_HIGHPASS: process_biquad(effect, buffer, frames); break;
+        case MIXER_REVERB: process_reverb(effect, buffer, frames); break;
+        case MIXER_COMPRESSOR: process_compressor(effect, buffer, frames); break;
+    }
+}
+
+// Mixes a block of the voice into 'out', returns false when the voice has ended
+static bool render_MixerVoice(MixerVoice *voice, float *out, const int frames) {
+    // linear balance like a mixing desk: unity at the center, 0 is left, 1 is right
+    const float pan = fminf(fmaxf(voice->pan, 0.0f), 1.0f);
+    const float left = voice->gain * fminf(2.0f * (1.0f - pan), 1.0f), right = voice->gain * fminf(2.0f * pan, 1.0f);
+    const float stepLeft = (left - voice->left) / (float)frames, stepRight = (right - voice->right) / (float)frames;
+    // a negative step would read before the samples, the rate is checked by play_Mixer()
+    const double step = fmax((double)voice->rate * voice->pitch, 0.0);
+    const int last = voice->frames - 1;
+    double position = voice->position;
+    for (int f = 0; f < frames; ++f) {
+        if (position >= voice->frames) {
+            if (!voice->loop || voice->frames == 0) return false;
+            position = fmod(position, voice->frames);
+        }
+        const int i = (int)position;
+        const int next = i < last ? i + 1 : (voice->loop ? 0 : i);
+        const float t = (float)(position - i);
+        const float *a = &voice->samples[(size_t)i * voice->stride], *b = &voice->samples[(size_t)next * voice->stride];
+        const float sampleLeft = a[0] + (b[0] - a[0]) * t;
+        const float sampleRight = voice->channels > 1 ? a[1] + (b[1] - a[1]) * t : sampleLeft;
+        out[2 * f] += sampleLeft * (voice->left + stepLeft * (float)f);
+        out[2 * f + 1] += sampleRight * (voice->right + stepRight * (float)f);
+        position += step;
+    }
+    voice->position = position;
+    voice->left = left;
+    voice->right = right;
+    return true;
+}
+
+static void finish_MixerVoice(Mixer *mixer, const int index) {
+    // a stolen slot has a newer id by now, so the late end of the old voice does not free it
+    ATOMIC_STORE(&mixer->ended[index], mixer->voices[index].id);
+    mixer->voices[index].id = 0;
+}
+
+static void apply_MixerCommand(Mixer *mixer, const MixerCommand *command) {
+    MixerVoice *voice = command->index < mixer->voiceCount ? &mixer->voices[command->index] : NULL;
+    MixerBus *bus = command->index < mixer->busCount ? &mixer->buses[command->index] : NULL;
+    switch (command->type) {
+        case MIXER_PLAY:
+            *voice = command->voice;
+            break;
+        case MIXER_STOP:
+            if (voice->id == command->voice.id) finish_MixerVoice(mixer, command->index);
+            break;
+        case MIXER_STOP_ALL:
+            for (int i = 0; i < mixer->voiceCount; ++i)
+                if (mixer->voices[i].id != 0) finish_MixerVoice(mixer, i);
+            break;
+        case MIXER_SET_VOICE:
+            if (voice->id != command->voice.id) break;
+            voice->gain = command->values[0];
+            voice->pitch = command->values[1];
+            voice->pan = command->values[2];
+            break;
+        case MIXER_SET_BUS:
+            bus->gain = command->values[0];
+            bus->parent = command->param;
+            break;
+        case MIXER_ADD_EFFECT:
+            bus->effects[bus->effectCount++] = command->pointer;
+            break;
+        case MIXER_SET_EFFECT: {
+            MixerEffect *effect = bus->effects[command->effect];
+            if (command->param < 0) effect->enabled = command->values[0] != 0.0f;
+            else effect->params[command->param] = command->values[0];
+            effect->dirty = true;
+            break;
+        }
+    }
+}
+
+// Audio thread: applies the queued commands and renders the buses
+static void render_Mixer(void *data, float *buffer, unsigned int frames) {
+    Mixer *mixer = data;
+    const unsigned int head = ATOMIC_LOAD(&mixer->head);
+    unsigned int tail = __atomic_load_n(&mixer->tail, __ATOMIC_RELAXED);
+    for (; tail != head; ++tail)
+        apply_MixerCommand(mixer, &mixer->commands[tail & (MIXER_QUEUE_SIZE - 1)]);
+    ATOMIC_STORE(&mixer->tail, tail);
+
+    while (frames > 0) {
+        const int count = frames < MIXER_BLOCK ? (int)frames : MIXER_BLOCK;
+        memset(mixer->mix, 0, sizeof(float) * 2 * MIXER_BLOCK * (size_t)mixer->busCount);
+        for (int i = 0; i < mixer->voiceCount; ++i) {
+            MixerVoice *voice = &mixer->voices[i];
+            if (voice->id != 0 && !render_MixerVoice(voice, &mixer->mix[2 * MIXER_BLOCK * voice->bus], count))
+                finish_MixerVoice(mixer, i);
+        }
+        // parents have lower indices, so children are done before they are mixed in
+        for (int b = mixer->busCount - 1; b >= 0; --b) {
+            const MixerBus *bus = &mixer->buses[b];
+            float *samples = &mixer->mix[2 * MIXER_BLOCK * b];
+            for (int e = 0; e < bus->effectCount; ++e)
+                if (bus->effects[e]->enabled) process_MixerEffect(bus->effects[e], samples, count, mixer->sampleRate);
+            if (b == 0) {
+                for (int s = 0; s < 2 * count; ++s) buffer[s] = samples[s] * bus->gain;
+            } else {
+                float *parent = &mixer->mix[2 * MIXER_BLOCK * bus->parent];
+                for (int s = 0; s < 2 * count; ++s) parent[s] += samples[s] * bus->gain;
+            }
+        }
+        buffer += 2 * count;
+        frames -= (unsigned int)count;
+    }
+}
+
+// Main thread: returns false if the queue is full, e.g. while the stream does not play
+static bool push_MixerCommand(Mixer *mixer, const MixerCommand *command) {
+    const unsigned int head = mixer->head;
+    if (head - ATOMIC_LOAD(&mixer->tail) == MIXER_QUEUE_SIZE) return false;
+    mixer->commands[head & (MIXER_QUEUE_SIZE - 1)] = *command;
+    ATOMIC_STORE(&mixer->head, head + 1);
+    return true;
+}
+
+static MixerEffect *alloc_MixerEffect(const int type, const float sampleRate) {
+    const float scale = sampleRate / 44100.0f;
+    size_t size = 0;
+    int combLength[8] = { 0 }, allpassLength[4] = { 0 };
+    if (type == MIXER_REVERB) {
+        for (int c = 0; c < 2; ++c) {
+            for (int i = 0; i < 4; ++i) size += (size_t)(combLength[c * 4 + i] = (int)((float)(reverb_comb_lengths[i] + 23 * c) * scale) + 1);
+            for (int i = 0; i < 2; ++i) size += (size_t)(allpassLength[c * 2 + i] = (int)((float)(reverb_allpass_lengths[i] + 23 * c) * scale) + 1);
+        }
+    }
+    MixerEffect *effect = calloc(1, sizeof(MixerEffect) + sizeof(float) * size);
+    if (effect == NULL) return NULL;
+    effect->type = type;
+    effect->enabled = true;
+    effect->dirty = true;
+    memcpy(effect->params, mixer_effect_defaults[type], sizeof(effect->params));
+    float *memory = effect->memory;
+    for (int i = 0; type == MIXER_REVERB && i < 8; ++i) {
+        effect->comb[i] = memory;
+        memory += effect->combLength[i] = combLength[i];
+    }
+    for (int i = 0; type == MIXER_REVERB && i < 4; ++i) {
+        effect->allpass[i] = memory;
+        memory += effect->allpassLength[i] = allpassLength[i];
+    }
+    return effect;
+}
+
+static int check_Mixer_bus(lua_State *L, const Mixer *mixer, const int idx) {
+    const lua_Integer bus = luaL_checkinteger(L, idx);
+    luaL_argcheck(L, bus >= 1 && bus <= mixer->busCount, idx, "bus out of range");
+    return (int)bus - 1;
+}
+
+// Returns the voice index of a voice id or -1 for unknown or stale ids
+static int get_Mixer_voice(const Mixer *mixer, const lua_Integer id) {
+    const lua_Integer index = id & (MIXER_MAX_VOICES - 1);
+    if (id <= 0 || id > UINT_MAX || index >= mixer->voiceCount || mixer->slots[index].id != (unsigned int)id) return -1;
+    return (int)index;
+}
+
+static bool is_Mixer_slot_free(const Mixer *mixer, const int index) {
+    return ATOMIC_LOAD(&mixer->ended[index]) == mixer->slots[index].id;
+}
+
+// Returns true if voice b should be stolen rather than voice a
+static bool is_better_victim(const Mixer *mixer, const int a, const int b) {
+    if (a < 0) return true;
+    const MixerSlot *sa = &mixer->slots[a], *sb = &mixer->slots[b];
+    if (sa->priority != sb->priority) return sb->priority < sa->priority;
+    if (mixer->stealPolicy == MIXER_STEAL_QUIETEST && sa->loudness != sb->loudness) return sb->loudness < sa->loudness;
+    return (int)(sb->order - sa->order) < 0;
+}
+
+// Returns the slot for a new voice: a free one, else a voice to steal or -1
+static int find_Mixer_slot(const Mixer *mixer, const SampleBuffer *source, const int priority, const int maxInstances, bool *steal) {
+    int instances = 0, free = -1, victim = -1, instanceVictim = -1;
+    for (int i = 0; i < mixer->voiceCount; ++i) {
+        if (is_Mixer_slot_free(mixer, i)) {
+            if (free < 0) free = i;
+            continue;
+        }
+        const MixerSlot *slot = &mixer->slots[i];
+        if (slot->source == source) {
+            ++instances;
+            if (is_better_victim(mixer, instanceVictim, i)) instanceVictim = i;
+        }
+        if (slot->priority <= priority && is_better_victim(mixer, victim, i)) victim = i;
+    }
+    *steal = true;
+    // at its limit a sound replaces one of its own instances
+    if (maxInstances > 0 && instances >= maxInstances) return mixer->stealPolicy != MIXER_STEAL_NONE ? instanceVictim : -1;
+    if (free >= 0) {
+        *steal = false;
+        return free;
+    }
+    return mixer->stealPolicy != MIXER_STEAL_NONE ? victim : -1;
+}
+
+static void update_Mixer_peak(Mixer *mixer) {
+    int count = 0;
+    for (int i = 0; i < mixer->voiceCount; ++i)
+        count += !is_Mixer_slot_free(mixer, i);
+    if (count > mixer->stats.peak) mixer->stats.peak = count;
+}
+
+// Releases the samples of stolen voices once the audio thread applied the PLAY command replacing them
+static void release_Mixer_retired(lua_State *L, Mixer *mixer) {
+    if (mixer->retiring == 0) return;
+    const unsigned int tail = ATOMIC_LOAD(&mixer->tail);
+    lua_getiuservalue(L, 1, 3);
+    lua_pushnil(L);
+    while (lua_next(L, -2)) {
+        lua_pop(L, 1);
+        if ((int)(tail - (unsigned int)lua_tointeger(L, -1)) > 0) {
+            lua_pushvalue(L, -1);
+            lua_pushnil(L);
+            lua_rawset(L, -4);
+            mixer->retiring--;
+        }
+    }
+    lua_pop(L, 1);
+}
+
+// Starts the voice of the command with the limits of the SampleBuffer at idx, pushes its id or nil
+static int play_Mixer(lua_State *L, Mixer *mixer, MixerCommand *command, const int idx) {
+    const SampleBuffer *source = check_SampleBuffer(L, idx);
+    luaL_argcheck(L, source->sampleRate > 0, idx, "invalid sample rate");
+    release_Mixer_retired(L, mixer);
+    int priority = 0, maxInstances = 0;
+    lua_getiuservalue(L, 1, 2);
+    lua_pushvalue(L, idx);
+    if (lua_rawget(L, -2) == LUA_TNUMBER) {
+        // packed by SetSoundLimits()
+        const lua_Integer limits = lua_tointeger(L, -1);
+        priority = (int)(limits >> 16);
+        maxInstances = (int)(limits & 0xffff);
+    }
+    lua_pop(L, 2);
+    bool steal;
+    const int index = source->frameCount > 0 ? find_Mixer_slot(mixer, source, priority, maxInstances, &steal) : -1;
+    if (index < 0) {
+        mixer->stats.rejected++;
+        return 0;
+    }
+    MixerSlot *slot = &mixer->slots[index];
+    unsigned int generation = ((slot->id >> 12) + 1) & 0xfffff;
+    if (generation == 0) generation = 1;
+    command->type = MIXER_PLAY;
+    command->index = index;
+    command->voice.id = generation << 12 | (unsigned int)index;
+    // ramps up from silence over the first block, which avoids a click
+    command->voice.left = command->voice.right = 0.0f;
+    const unsigned int position = mixer->head;
+    if (!push_MixerCommand(mixer, command)) {
+        mixer->stats.rejected++;
+        return 0;
+    }
+    *slot = (MixerSlot){ command->voice.id, source, priority, mixer->order++, command->voice.gain };
+    mixer->stats.started++;
+    mixer->stats.stolen += steal;
+    update_Mixer_peak(mixer);
+    // keep the samples alive while they play
+    lua_getiuservalue(L, 1, 1);
+    if (steal) {
+        // the audio thread reads the stolen voice's samples until it applies the command
+        lua_getiuservalue(L, 1, 3);
+        if (lua_rawgeti(L, -2, index + 1) != LUA_TNIL) {
+            lua_rawseti(L, -2, position);
+            mixer->retiring++;
+        } else {
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+    }
+    lua_pushvalue(L, idx);
+    lua_rawseti(L, -2, index + 1);
+    lua_pushinteger(L, command->voice.id);
+    return 1;
+}
+
+static MixerVoice get_MixerVoice(const Mixer *mixer, const SampleBuffer *buffer, const int bus) {
+    return (MixerVoice){
+        .samples = buffer->samples,
+        .frames = buffer->frameCount,
+        .channels = buffer->channels,
+        .stride = buffer->stride,
+        .rate = (float)buffer->sampleRate / mixer->sampleRate,
+        .gain = 1.0f,
+        .pitch = 1.0f,
+        .pan = 0.5f,
+        .bus = bus,
+    };
+}
+
+static int f_Mixer(lua_State *L) {
+    const lua_Integer voiceCount = luaL_optinteger(L, 1, 64), busCount = luaL_optinteger(L, 2, 4);
+    const lua_Integer sampleRate = luaL_optinteger(L, 3, 48000);
+    luaL_argcheck(L, voiceCount >= 1 && voiceCount <= MIXER_MAX_VOICES, 1, "invalid voice count");
+    luaL_argcheck(L, busCount >= 1 && busCount <= MIXER_MAX_BUSES, 2, "invalid bus count");
+    luaL_argcheck(L, sampleRate >= 8000 && sampleRate <= 192000, 3, "invalid sample rate");
+    Mixer *mixer = push_object(L, "Mixer", sizeof(Mixer), 3);
+    *mixer = (Mixer){ .slot = -1, .sampleRate = (float)sampleRate, .voiceCount = (int)voiceCount, .busCount = (int)busCount, .stealPolicy = MIXER_STEAL_OLDEST };
+    lua_newtable(L);
+    lua_setiuservalue(L, -2, 1);
+    lua_newtable(L);
+    lua_newtable(L);
+    lua_pushliteral(L, "k");
+    lua_setfield(L, -2, "__mode");
+    lua_setmetatable(L, -2);
+    lua_setiuservalue(L, -2, 2);
+    lua_newtable(L);
+    lua_setiuservalue(L, -2, 3);
+    mixer->voices = calloc((size_t)voiceCount, sizeof(MixerVoice));
+    mixer->mix = calloc((size_t)busCount * 2 * MIXER_BLOCK, sizeof(float));
+    mixer->commands = calloc(MIXER_QUEUE_SIZE, sizeof(MixerCommand));
+    mixer->ended = calloc((size_t)voiceCount, sizeof(unsigned int));
+    mixer->slots = calloc((size_t)voiceCount, sizeof(MixerSlot));
+    if (mixer->voices == NULL || mixer->mix == NULL || mixer->commands == NULL || mixer->ended == NULL || mixer->slots == NULL)
+        return luaL_error(L, "out of memory");
+    for (int b = 0; b < mixer->busCount; ++b)
+        mixer->buses[b] = (MixerBus){ .gain = 1.0f, .parent = 0 };
+    mixer->slot = acquire_audio_slot(render_Mixer, mixer);
+    if (mixer->slot < 0) return luaL_error(L, "too many callback driven audio streams (%d)", AUDIO_SLOT_COUNT);
+    mixer->stream = LoadAudioStream((unsigned int)sampleRate, 32, 2);
+    SetAudioStreamCallback(mixer->stream, audio_slot_callbacks[mixer->slot]);
+    PlayAudioStream(mixer->stream);
+    return 1;
+}
+
+static int f_Mixer__gc(lua_State *L) {
+    Mixer *mixer = check_Mixer(L, 1);
+    // unloading detaches the callback under the audio lock, after that nothing is shared
+    if (mixer->stream.buffer != NULL) UnloadAudioStream(mixer->stream);
+    if (mixer->slot >= 0) release_audio_slot(mixer->slot);
+    for (int b = 0; b < MIXER_MAX_BUSES; ++b)
+        for (int e = 0; e < mixer->effectCounts[b]; ++e) free(mixer->effects[b][e]);
+    free(mixer->voices);
+    free(mixer->mix);
+    free(mixer->commands);
+    free(mixer->ended);
+    free(mixer->slots);
+    *mixer = (Mixer){ .slot = -1 };
+    return 0;
+}
+
+static int f_Mixer__tostring(lua_State *L) {
+    const Mixer *mixer = check_Mixer(L, 1);
+    lua_pushfstring(L, "Mixer(voices = %d, buses = %d, sampleRate = %d)", mixer->voiceCount, mixer->busCount, (int)mixer->sampleRate);
+    return 1;
+}
+
+static int f_Mixer_Play(lua_State *L) {
+    Mixer *mixer = check_Mixer(L, 1);
+    const SampleBuffer *buffer = check_SampleBuffer(L, 2);
+    MixerCommand command = { .voice = get_MixerVoice(mixer, buffer, lua_isnoneornil(L, 3) ? 0 : check_Mixer_bus(L, mixer, 3)) };
+    command.voice.gain = (float)luaL_optnumber(L, 4, 1.0);
+    command.voice.pitch = (float)luaL_optnumber(L, 5, 1.0);
+    command.voice.pan = (float)luaL_optnumber(L, 6, 0.5);
+    command.voice.loop = lua_toboolean(L, 7);
+    return play_Mixer(L, mixer, &command, 2);
+}
+
+static int f_Mixer_PlayAt(lua_State *L) {
+    Mixer *mixer = check_Mixer(L, 1);
+    const SampleBuffer *buffer = check_SampleBuffer(L, 2);
+    const Vector2 position = *check_Vector2(L, 3);
+    MixerCommand command = { .voice = get_MixerVoice(mixer, buffer, lua_isnoneornil(L, 4) ? 0 : check_Mixer_bus(L, mixer, 4)) };
+    command.voice.gain = (float)luaL_optnumber(L, 5, 1.0);
+    command.voice.pitch = (float)luaL_optnumber(L, 6, 1.0);
+    command.voice.loop = lua_toboolean(L, 7);
+    if (mixer->maxDistance > 0.0f) {
+        const float distance = Vector2Distance(position, mixer->listener);
+        // inaudible sounds never take a voice
+        if (distance >= mixer->maxDistance) {
+            mixer->stats.culled++;
+            return 0;
+        }
+        command.voice.gain *= 1.0f - distance / mixer->maxDistance;
+        command.voice.pan = 0.5f + 0.5f * Clamp((position.x - mixer->listener.x) / mixer->maxDistance, -1.0f, 1.0f);
+    }
+    return play_Mixer(L, mixer, &command, 2);
+}
+
+static int f_Mixer_SetVoice(lua_State *L) {
+    Mixer *mixer = check_Mixer(L, 1);
+    const lua_Integer id = luaL_checkinteger(L, 2);
+    const int index = get_Mixer_voice(mixer, id);
+    if (index < 0) return 0;
+    MixerCommand command = { .type = MIXER_SET_VOICE, .index = index, .voice.id = (unsigned int)id };
+    command.values[0] = (float)luaL_checknumber(L, 3);
+    command.values[1] = (float)luaL_optnumber(L, 4, 1.0);
+    command.values[2] = (float)luaL_optnumber(L, 5, 0.5);
+    if (push_MixerCommand(mixer, &command)) mixer->slots[index].loudness = command.values[0];
+    return 0;
+}
+
+static int f_Mixer_Stop(lua_State *L) {
+    Mixer *mixer = check_Mixer(L, 1);
+    const lua_Integer id = luaL_checkinteger(L, 2);
+    const int index = get_Mixer_voice(mixer, id);
+    if (index >= 0) push_MixerCommand(mixer, &(MixerCommand){ .type = MIXER_STOP, .index = index, .voice.id = (unsigned int)id });
+    return 0;
+}
+
+static int f_Mixer_StopAll(lua_State *L) {
+    push_MixerCommand(check_Mixer(L, 1), &(MixerCommand){ .type = MIXER_STOP_ALL });
+    return 0;
+}
+
+static int f_Mixer_IsPlaying(lua_State *L) {
+    const Mixer *mixer = check_Mixer(L, 1);
+    const int index = get_Mixer_voice(mixer, luaL_checkinteger(L, 2));
+    lua_pushboolean(L, index >= 0 && !is_Mixer_slot_free(mixer, index));
+    return 1;
+}
+
+static int f_Mixer_SetBus(lua_State *L) {
+    Mixer *mixer = check_Mixer(L, 1);
+    const int bus = check_Mixer_bus(L, mixer, 2);
+    const int parent = lua_isnoneornil(L, 4) ? 0 : check_Mixer_bus(L, mixer, 4);
+    luaL_argcheck(L, bus == 0 || parent < bus, 4, "parent must be a bus with a lower number");
+    MixerCommand command = { .type = MIXER_SET_BUS, .index = bus, .param = parent };
+    command.values[0] = (float)luaL_checknumber(L, 3);
+    push_MixerCommand(mixer, &command);
+    return 0;
+}
+
+static int f_Mixer_AddEffect(lua_State *L) {
+    Mixer *mixer = check_Mixer(L, 1);
+    const int bus = check_Mixer_bus(L, mixer, 2);
+    const int type = luaL_checkoption(L, 3, NULL, mixer_effect_names);
+    luaL_argcheck(L, mixer->effectCounts[bus] < MIXER_MAX_EFFECTS, 2, "too many effects on the bus");
+    MixerEffect *effect = alloc_MixerEffect(type, mixer->sampleRate);
+    if (effect == NULL) return luaL_error(L, "out of memory");
+    if (!push_MixerCommand(mixer, &(MixerCommand){ .type = MIXER_ADD_EFFECT, .index = bus, .pointer = effect })) {
+        free(effect);
+        return 0;
+    }
+    mixer->effects[bus][mixer->effectCounts[bus]] = effect;
+    lua_pushinteger(L, ++mixer->effectCounts[bus]);
+    return 1;
+}
+
+static int f_Mixer_SetEffect(lua_State *L) {
+    Mixer *mixer = check_Mixer(L, 1);
+    const int bus = check_Mixer_bus(L, mixer, 2);
+    const lua_Integer effect = luaL_checkinteger(L, 3);
+    const char *name = luaL_checkstring(L, 4);
+    luaL_argcheck(L, effect >= 1 && effect <= mixer->effectCounts[bus], 3, "effect out of range");
+    MixerCommand command = { .type = MIXER_SET_EFFECT, .index = bus, .effect = (int)effect - 1, .param = -1 };
+    if (strcmp(name, "enabled") == 0) {
+        command.values[0] = lua_toboolean(L, 5) ? 1.0f : 0.0f;
+    } else {
+        const char *const *names = mixer_effect_params[mixer->effects[bus][effect - 1]->type];
+        int param = 0;
+        while (names[param] != NULL && strcmp(names[param], name) != 0) ++param;
+        if (names[param] == NULL) return luaL_argerror(L, 4, lua_pushfstring(L, "invalid parameter '%s'", name));
+        command.param = param;
+        command.values[0] = (float)luaL_checknumber(L, 5);
+    }
+    push_MixerCommand(mixer, &command);
+    return 0;
+}
+
+static int f_Mixer_SetSoundLimits(lua_State *L) {
+    check_Mixer(L, 1);
+    check_SampleBuffer(L, 2);
+    const lua_Integer priority = luaL_checkinteger(L, 3), maxInstances = luaL_optinteger(L, 4, 0);
+    luaL_argcheck(L, priority >= 0 && priority <= 0xffff, 3, "invalid priority");
+    luaL_argcheck(L, maxInstances >= 0 && maxInstances <= MIXER_MAX_VOICES, 4, "invalid instance count");
+    lua_getiuservalue(L, 1, 2);
+    lua_pushvalue(L, 2);
+    lua_pushinteger(L, priority << 16 | maxInstances);
+    lua_rawset(L, -3);
+    return 0;
+}
+
+static int f_Mixer_SetListener(lua_State *L) {
+    Mixer *mixer = check_Mixer(L, 1);
+    mixer->listener = *check_Vector2(L, 2);
+    if (!lua_isnoneornil(L, 3)) mixer->maxDistance = fmaxf((float)luaL_checknumber(L, 3), 0.0f);
+    return 0;
+}
+
+static int f_Mixer_GetStats(lua_State *L) {
+    Mixer *mixer = check_Mixer(L, 1);
+    int count = 0;
+    for (int i = 0; i < mixer->voiceCount; ++i)
+        count += !is_Mixer_slot_free(mixer, i);
+    lua_createtable(L, 0, 6);
+    lua_pushinteger(L, count);
+    lua_setfield(L, -2, "voices");
+    lua_pushinteger(L, mixer->stats.peak > count ? mixer->stats.peak : count);
+    lua_setfield(L, -2, "peak");
+    lua_pushinteger(L, mixer->stats.started);
+    lua_setfield(L, -2, "started");
+    lua_pushinteger(L, mixer->stats.stolen);
+    lua_setfield(L, -2, "stolen");
+    lua_pushinteger(L, mixer->stats.culled);
+    lua_setfield(L, -2, "culled");
+    lua_pushinteger(L, mixer->stats.rejected);
+    lua_setfield(L, -2, "rejected");
+    // counters cover the time since the last call, e.g. one frame
+    mixer->stats = (MixerStats){ 0 };
+    return 1;
+}
+
+static int f_Mixer_get_voices(lua_State *L) {
+    const Mixer *mixer = check_Mixer(L, 1);
+    int count = 0;
+    for (int i = 0; i < mixer->voiceCount; ++i)
+        count += !is_Mixer_slot_free(mixer, i);
+    lua_pushinteger(L, count);
+    return 1;
+}
+
+static int f_Mixer_get_stealPolicy(lua_State *L) {
+    lua_pushstring(L, mixer_steal_names[check_Mixer(L, 1)->stealPolicy]);
+    return 1;
+}
+
+static int f_Mixer_set_stealPolicy(lua_State *L) {
+    check_Mixer(L, 1)->stealPolicy = luaL_checkoption(L, 2, NULL, mixer_steal_names);
+    return 0;
+}
+
+static int f_Mixer_get_maxDistance(lua_State *L) {
+    lua_pushnumber(L, check_Mixer(L, 1)->maxDistance);
+    return 1;
+}
+
+static int f_Mixer_set_maxDistance(lua_State *L) {
+    check_Mixer(L, 1)->maxDistance = fmaxf((float)luaL_checknumber(L, 2), 0.0f);
+    return 0;
+}
+
+static int f_Mixer_get_capacity(lua_State *L) {
+    lua_pushinteger(L, check_Mixer(L, 1)->voiceCount);
+    return 1;
+}
+
+static int f_Mixer_get_buses(lua_State *L) {
+    lua_pushinteger(L, check_Mixer(L, 1)->busCount);
+    return 1;
+}
+
+static int f_Mixer_get_sampleRate(lua_State *L) {
+    lua_pushinteger(L, (lua_Integer)check_Mixer(L, 1)->sampleRate);
+    return 1;
+}
+
+
+//==[[ FilePathList object ]]===================================================
+
+static int push_FilePathList(lua_State *L, FilePathList list, void (*unload)(FilePathList)) {
+    lua_createtable(L, list.count, 0);
+    for (unsigned int i = 0; i < list.count; ++i) {
+        lua_pushstring(L, list.paths[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    (*unload)(list);
+    return 1;
+}
+
+
+//==[[ DrawList object ]]=======================================================
+
+enum {
+    DRAW_PIXEL, DRAW_LINE, DRAW_LINE_EX, DRAW_CIRCLE, DRAW_CIRCLE_LINES,
+    DRAW_RECTANGLE, DRAW_RECTANGLE_PRO, DRAW_RECTANGLE_LINES, DRAW_RECTANGLE_LINES_EX, DRAW_RECTANGLE_ROUNDED,
+    DRAW_TRIANGLE, DRAW_TRIANGLE_LINES, DRAW_POLY, DRAW_TEXT, DRAW_TEXT_EX,
+    DRAW_TEXTURE_EX, DRAW_TEXTURE_REC, DRAW_TEXTURE_PRO,
+};
+
+// One recorded call, 'type' selects the member of 'as'. Textures and fonts are
+// referenced, not copied: they point into the objects held by the anchor table.
+typedef struct DrawCommand {
+    int type;
+    Color color;
+    union {
+        struct { Vector2 points[3]; } shape;                                        // pixel, line, triangle
+        struct { Vector2 start, end; float thick; } line;
+        struct { Vector2 center; float radius, rotation; int sides; } circle;       // circle, polygon
+        struct { Rectangle rec; Vector2 origin; float value; int segments; } rect;  // value: rotation, line thickness or roundness
+        struct { const Font *font; const char *text; Vector2 position; float fontSize, spacing; } text;
+        struct { const Texture *texture; Vector2 position; float rotation, scale; } textureEx;
+        struct { const Texture *texture; Rectangle source; Vector2 position; } textureRec;
+        struct { const Texture *texture; Rectangle source, dest; Vector2 origin; float rotation; } texturePro;
+    } as;
+} DrawCommand;
+
+// Reads the arguments of a recording method starting at 'arg' into the command,
+// returns the index of the texture / font to anchor or 0
+typedef int (*DrawReader)(lua_State *L, const int arg, DrawCommand *command);
+
+// uservalue 1: command index -> anchored texture / font
+typedef struct DrawList {
+    int count;
+    int capacity;
+    DrawCommand *commands;
+} DrawList;
+
+static DrawList *check_DrawList(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "DrawList");
+}
+
+static void release_DrawCommand(DrawCommand *command) {
+    if (command->type == DRAW_TEXT || command->type == DRAW_TEXT_EX) free((void*)command->as.text.text);
+}
+
+static void truncate_DrawList(lua_State *L, DrawList *list, const int count) {
+    // release the text copies and the anchored textures / fonts of dropped commands
+    lua_getiuservalue(L, 1, 1);
+    for (int i = count; i < list->count; ++i) {
+        release_DrawCommand(&list->commands[i]);
+        lua_pushnil(L);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_pop(L, 1);
+    list->count = count;
+}
+
+// Stores the command at 'index', replacing a recorded one or appending at list->count
+static void record_DrawCommand(lua_State *L, DrawList *list, const int index, DrawCommand *command, const int anchor) {
+    // raise errors before the list changes
+    if (index == list->count && list->count >= list->capacity) {
+        if (list->capacity > INT_MAX / 2 / (int)sizeof(DrawCommand)) luaL_error(L, "DrawList too large");
+        const int capacity = list->capacity > 0 ? list->capacity * 2 : 64;
+        DrawCommand *commands = realloc(list->commands, sizeof(DrawCommand) * (size_t)capacity);
+        if (commands == NULL) luaL_error(L, "out of memory");
+        list->commands = commands;
+        list->capacity = capacity;
+    }
+    if (command->type == DRAW_TEXT || command->type == DRAW_TEXT_EX) {
+        // the reader left the Lua string, the command owns a copy
+        const size_t size = strlen(command->as.text.text) + 1;
+        char *text = malloc(size);
+        if (text == NULL) luaL_error(L, "out of memory");
+        memcpy(text, command->as.text.text, size);
+        command->as.text.text = text;
+    }
+    const bool replace = index < list->count;
+    if (replace) release_DrawCommand(&list->commands[index]);
+    else list->count++;
+    list->commands[index] = *command;
+    if (anchor > 0 || replace) {
+        // keep the referenced texture / font alive while the command exists
+        lua_getiuservalue(L, 1, 1);
+        if (anchor > 0) lua_pushvalue(L, anchor);
+        else lua_pushnil(L);
+        lua_rawseti(L, -2, index + 1);
+        lua_pop(L, 1);
+    }
+}
+
+static int append_DrawCommand(lua_State *L, const DrawReader read) {
+    DrawList *list = check_DrawList(L, 1);
+    DrawCommand command = { 0 };
+    const int anchor = read(L, 2, &command);
+    record_DrawCommand(L, list, list->count, &command, anchor);
+    return 0;
+}
+
+static void draw_DrawCommand(const DrawCommand *command) {
+    const Vector2 *p = command->as.shape.points;
+    const Rectangle rec = command->as.rect.rec;
+    const Color color = command->color;
+    switch (command->type) {
+        case DRAW_PIXEL: DrawPixelV(p[0], color); break;
+        case DRAW_LINE: DrawLineV(p[0], p[1], color); break;
+        case DRAW_LINE_EX: DrawLineEx(command->as.line.start, command->as.line.end, command->as.line.thick, color); break;
+        case DRAW_CIRCLE: DrawCircleV(command->as.circle.center, command->as.circle.radius, color); break;
+        case DRAW_CIRCLE_LINES: DrawCircleLines((int)command->as.circle.center.x, (int)command->as.circle.center.y, command->as.circle.radius, color); break;
+        case DRAW_RECTANGLE: DrawRectangleRec(rec, color); break;
+        case DRAW_RECTANGLE_PRO: DrawRectanglePro(rec, command->as.rect.origin, command->as.rect.value, color); break;
+        case DRAW_RECTANGLE_LINES: DrawRectangleLines((int)rec.x, (int)rec.y, (int)rec.width, (int)rec.height, color); break;
+        case DRAW_RECTANGLE_LINES_EX: DrawRectangleLinesEx(rec, command->as.rect.value, color); break;
+        case DRAW_RECTANGLE_ROUNDED: DrawRectangleRounded(rec, command->as.rect.value, command->as.rect.segments, color); break;
+        case DRAW_TRIANGLE: DrawTriangle(p[0], p[1], p[2], color); break;
+        case DRAW_TRIANGLE_LINES: DrawTriangleLines(p[0], p[1], p[2], color); break;
+        case DRAW_POLY: DrawPoly(command->as.circle.center, command->as.circle.sides, command->as.circle.radius, command->as.circle.rotation, color); break;
+        case DRAW_TEXT: DrawText(command->as.text.text, (int)command->as.text.position.x, (int)command->as.text.position.y, (int)command->as.text.fontSize, color); break;
+        case DRAW_TEXT_EX: DrawTextEx(*command->as.text.font, command->as.text.text, command->as.text.position, command->as.text.fontSize, command->as.text.spacing, color); break;
+        case DRAW_TEXTURE_EX: DrawTextureEx(*command->as.textureEx.texture, command->as.textureEx.position, command->as.textureEx.rotation, command->as.textureEx.scale, color); break;
+        case DRAW_TEXTURE_REC: DrawTextureRec(*command->as.textureRec.texture, command->as.textureRec.source, command->as.textureRec.position, color); break;
+        case DRAW_TEXTURE_PRO: DrawTexturePro(*command->as.texturePro.texture, command->as.texturePro.source, command->as.texturePro.dest, command->as.texturePro.origin, command->as.texturePro.rotation, color); break;
+    }
+}
+
+static int f_DrawList(lua_State *L) {
+    DrawList *list = push_object(L, "DrawList", sizeof(DrawList), 1);
+    *list = (DrawList){ 0 };
+    lua_newtable(L);
+    lua_setiuservalue(L, -2, 1);
+    return 1;
+}
+
+static int f_DrawList__gc(lua_State *L) {
+    DrawList *list = check_DrawList(L, 1);
+    for (int i = 0; i < list->count; ++i)
+        release_DrawCommand(&list->commands[i]);
+    free(list->commands);
+    *list = (DrawList){ 0 };
+    return 0;
+}
+
+static int f_DrawList__tostring(lua_State *L) {
+    lua_pushfstring(L, "DrawList(count = %d)", check_DrawList(L, 1)->count);
+    return 1;
+}
+
+static int f_DrawList__len(lua_State *L) {
+    lua_pushinteger(L, check_DrawList(L, 1)->count);
+    return 1;
+}
+
+static int f_DrawList_Draw(lua_State *L) {
+    const DrawList *list = check_DrawList(L, 1);
+    lua_Integer first = luaL_optinteger(L, 2, 1), last = luaL_optinteger(L, 3, list->count);
+    if (first < 1) first = 1;
+    if (last > list->count) last = list->count;
+    for (lua_Integer i = first - 1; i < last; ++i)
+        draw_DrawCommand(&list->commands[i]);
+    return 0;
+}
+
+static int f_DrawList_Clear(lua_State *L) {
+    truncate_DrawList(L, check_DrawList(L, 1), 0);
+    return 0;
+}
+
+static int f_DrawList_Truncate(lua_State *L) {
+    DrawList *list = check_DrawList(L, 1);
+    lua_Integer count = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, count >= 0 && count <= list->count, 2, "count out of range");
+    truncate_DrawList(L, list, (int)count);
+    return 0;
+}
+
+static int f_DrawList_Remove(lua_State *L) {
+    DrawList *list = check_DrawList(L, 1);
+    const lua_Integer first = luaL_checkinteger(L, 2), last = luaL_optinteger(L, 3, first);
+    luaL_argcheck(L, first >= 1 && first <= list->count + 1, 2, "index out of range");
+    luaL_argcheck(L, last >= first - 1 && last <= list->count, 3, "index out of range");
+    const int removed = (int)(last - first + 1);
+    if (removed == 0) return 0;
+    for (lua_Integer i = first - 1; i < last; ++i)
+        release_DrawCommand(&list->commands[i]);
+    memmove(&list->commands[first - 1], &list->commands[last], sizeof(DrawCommand) * (size_t)(list->count - last));
+    // shift the anchors of the following commands down
+    lua_getiuservalue(L, 1, 1);
+    for (int i = (int)last + 1; i <= list->count; ++i) {
+        lua_rawgeti(L, -1, i);
+        lua_rawseti(L, -2, i - removed);
+    }
+    for (int i = list->count - removed + 1; i <= list->count; ++i) {
+        lua_pushnil(L);
+        lua_rawseti(L, -2, i);
+    }
+    lua_pop(L, 1);
+    list->count -= removed;
+    return 0;
+}
+
+static Vector2 check_DrawList_point(lua_State *L, const int arg) {
+    // integer coordinates like the int overloads of raylib
+    return (Vector2){ (float)(int)luaL_checknumber(L, arg), (float)(int)luaL_checknumber(L, arg + 1) };
+}
+
+static Rectangle check_DrawList_rectangle(lua_State *L, const int arg) {
+    return (Rectangle){
+        (float)(int)luaL_checknumber(L, arg), (float)(int)luaL_checknumber(L, arg + 1),
+        (float)(int)luaL_checknumber(L, arg + 2), (float)(int)luaL_checknumber(L, arg + 3)
+    };
+}
+
+static int read_DrawPixel(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_PIXEL;
+    command->as.shape.points[0] = check_DrawList_point(L, arg);
+    command->color = *check_Color(L, arg + 2);
+    return 0;
+}
+
+static int read_DrawPixelV(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_PIXEL;
+    command->as.shape.points[0] = *check_Vector2(L, arg);
+    command->color = *check_Color(L, arg + 1);
+    return 0;
+}
+
+static int read_DrawLine(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_LINE;
+    command->as.shape.points[0] = check_DrawList_point(L, arg);
+    command->as.shape.points[1] = check_DrawList_point(L, arg + 2);
+    command->color = *check_Color(L, arg + 4);
+    return 0;
+}
+
+static int read_DrawLineV(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_LINE;
+    command->as.shape.points[0] = *check_Vector2(L, arg);
+    command->as.shape.points[1] = *check_Vector2(L, arg + 1);
+    command->color = *check_Color(L, arg + 2);
+    return 0;
+}
+
+static int read_DrawLineEx(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_LINE_EX;
+    command->as.line.start = *check_Vector2(L, arg);
+    command->as.line.end = *check_Vector2(L, arg + 1);
+    command->as.line.thick = (float)luaL_checknumber(L, arg + 2);
+    command->color = *check_Color(L, arg + 3);
+    return 0;
+}
+
+static int read_DrawCircle(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_CIRCLE;
+    command->as.circle.center = check_DrawList_point(L, arg);
+    command->as.circle.radius = (float)luaL_checknumber(L, arg + 2);
+    command->color = *check_Color(L, arg + 3);
+    return 0;
+}
+
+static int read_DrawCircleV(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_CIRCLE;
+    command->as.circle.center = *check_Vector2(L, arg);
+    command->as.circle.radius = (float)luaL_checknumber(L, arg + 1);
+    command->color = *check_Color(L, arg + 2);
+    return 0;
+}
+
+static int read_DrawCircleLines(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_CIRCLE_LINES;
+    command->as.circle.center = check_DrawList_point(L, arg);
+    command->as.circle.radius = (float)luaL_checknumber(L, arg + 2);
+    command->color = *check_Color(L, arg + 3);
+    return 0;
+}
+
+static int read_DrawRectangle(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_RECTANGLE;
+    command->as.rect.rec = check_DrawList_rectangle(L, arg);
+    command->color = *check_Color(L, arg + 4);
+    return 0;
+}
+
+static int read_DrawRectangleV(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_RECTANGLE;
+    const Vector2 position = *check_Vector2(L, arg), size = *check_Vector2(L, arg + 1);
+    command->as.rect.rec = (Rectangle){ position.x, position.y, size.x, size.y };
+    command->color = *check_Color(L, arg + 2);
+    return 0;
+}
+
+static int read_DrawRectangleRec(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_RECTANGLE;
+    command->as.rect.rec = *check_Rectangle(L, arg);
+    command->color = *check_Color(L, arg + 1);
+    return 0;
+}
+
+static int read_DrawRectanglePro(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_RECTANGLE_PRO;
+    command->as.rect.rec = *check_Rectangle(L, arg);
+    command->as.rect.origin = *check_Vector2(L, arg + 1);
+    command->as.rect.value = (float)luaL_checknumber(L, arg + 2);
+    command->color = *check_Color(L, arg + 3);
+    return 0;
+}
+
+static int read_DrawRectangleLines(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_RECTANGLE_LINES;
+    command->as.rect.rec = check_DrawList_rectangle(L, arg);
+    command->color = *check_Color(L, arg + 4);
+    return 0;
+}
+
+static int read_DrawRectangleLinesEx(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_RECTANGLE_LINES_EX;
+    command->as.rect.rec = *check_Rectangle(L, arg);
+    command->as.rect.value = (float)luaL_checknumber(L, arg + 1);
+    command->color = *check_Color(L, arg + 2);
+    return 0;
+}
+
+static int read_DrawRectangleRounded(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_RECTANGLE_ROUNDED;
+    command->as.rect.rec = *check_Rectangle(L, arg);
+    command->as.rect.value = (float)luaL_checknumber(L, arg + 1);
+    command->as.rect.segments = (int)luaL_checkinteger(L, arg + 2);
+    command->color = *check_Color(L, arg + 3);
+    return 0;
+}
+
+static int read_DrawTriangle(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_TRIANGLE;
+    for (int i = 0; i < 3; ++i) command->as.shape.points[i] = *check_Vector2(L, arg + i);
+    command->color = *check_Color(L, arg + 3);
+    return 0;
+}
+
+static int read_DrawTriangleLines(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_TRIANGLE_LINES;
+    for (int i = 0; i < 3; ++i) command->as.shape.points[i] = *check_Vector2(L, arg + i);
+    command->color = *check_Color(L, arg + 3);
+    return 0;
+}
+
+static int read_DrawPoly(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_POLY;
+    command->as.circle.center = *check_Vector2(L, arg);
+    command->as.circle.sides = (int)luaL_checkinteger(L, arg + 1);
+    command->as.circle.radius = (float)luaL_checknumber(L, arg + 2);
+    command->as.circle.rotation = (float)luaL_checknumber(L, arg + 3);
+    command->color = *check_Color(L, arg + 4);
+    return 0;
+}
+
+// The text is left pointing at the Lua string, record_DrawCommand() copies it
+static int read_DrawText(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_TEXT;
+    command->as.text.text = luaL_checkstring(L, arg);
+    command->as.text.position = check_DrawList_point(L, arg + 1);
+    command->as.text.fontSize = (float)(int)luaL_checknumber(L, arg + 3);
+    command->color = *check_Color(L, arg + 4);
+    return 0;
+}
+
+static int read_DrawTextEx(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_TEXT_EX;
+    command->as.text.font = check_Font(L, arg);
+    command->as.text.text = luaL_checkstring(L, arg + 1);
+    command->as.text.position = *check_Vector2(L, arg + 2);
+    command->as.text.fontSize = (float)luaL_checknumber(L, arg + 3);
+    command->as.text.spacing = (float)luaL_checknumber(L, arg + 4);
+    command->color = *check_Color(L, arg + 5);
+    return arg;
+}
+
+static int read_DrawTexture(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_TEXTURE_EX;
+    command->as.textureEx.texture = check_Texture(L, arg);
+    command->as.textureEx.position = check_DrawList_point(L, arg + 1);
+    command->as.textureEx.scale = 1.0f;
+    command->color = *check_Color(L, arg + 3);
+    return arg;
+}
+
+static int read_DrawTextureV(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_TEXTURE_EX;
+    command->as.textureEx.texture = check_Texture(L, arg);
+    command->as.textureEx.position = *check_Vector2(L, arg + 1);
+    command->as.textureEx.scale = 1.0f;
+    command->color = *check_Color(L, arg + 2);
+    return arg;
+}
+
+static int read_DrawTextureEx(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_TEXTURE_EX;
+    command->as.textureEx.texture = check_Texture(L, arg);
+    command->as.textureEx.position = *check_Vector2(L, arg + 1);
+    command->as.textureEx.rotation = (float)luaL_checknumber(L, arg + 2);
+    command->as.textureEx.scale = (float)luaL_checknumber(L, arg + 3);
+    command->color = *check_Color(L, arg + 4);
+    return arg;
+}
+
+static int read_DrawTextureRec(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_TEXTURE_REC;
+    command->as.textureRec.texture = check_Texture(L, arg);
+    command->as.textureRec.source = *check_Rectangle(L, arg + 1);
+    command->as.textureRec.position = *check_Vector2(L, arg + 2);
+    command->color = *check_Color(L, arg + 3);
+    return arg;
+}
+
+static int read_DrawTexturePro(lua_State *L, const int arg, DrawCommand *command) {
+    command->type = DRAW_TEXTURE_PRO;
+    command->as.texturePro.texture = check_Texture(L, arg);
+    command->as.texturePro.source = *check_Rectangle(L, arg + 1);
+    command->as.texturePro.dest = *check_Rectangle(L, arg + 2);
+    command->as.texturePro.origin = *check_Vector2(L, arg + 3);
+    command->as.texturePro.rotation = (float)luaL_checknumber(L, arg + 4);
+    command->color = *check_Color(L, arg + 5);
+    return arg;
+}
+
+// recording methods by name, for DrawList:Set()
+static const struct {
+    const char *name;
+    DrawReader read;
+} draw_readers[] = {
+    { "DrawPixel", read_DrawPixel },
+    { "DrawPixelV", read_DrawPixelV },
+    { "DrawLine", read_DrawLine },
+    { "DrawLineV", read_DrawLineV },
+    { "DrawLineEx", read_DrawLineEx },
+    { "DrawCircle", read_DrawCircle },
+    { "DrawCircleV", read_DrawCircleV },
+    { "DrawCircleLines", read_DrawCircleLines },
+    { "DrawRectangle", read_DrawRectangle },
+    { "DrawRectangleV", read_DrawRectangleV },
+    { "DrawRectangleRec", read_DrawRectangleRec },
+    { "DrawRectanglePro", read_DrawRectanglePro },
+    { "DrawRectangleLines", read_DrawRectangleLines },
+    { "DrawRectangleLinesEx", read_DrawRectangleLinesEx },
+    { "DrawRectangleRounded", read_DrawRectangleRounded },
+    { "DrawTriangle", read_DrawTriangle },
+    { "DrawTriangleLines", read_DrawTriangleLines },
+    { "DrawPoly", read_DrawPoly },
+    { "DrawText", read_DrawText },
+    { "DrawTextEx", read_DrawTextEx },
+    { "DrawTexture", read_DrawTexture },
+    { "DrawTextureV", read_DrawTextureV },
+    { "DrawTextureEx", read_DrawTextureEx },
+    { "DrawTextureRec", read_DrawTextureRec },
+    { "DrawTexturePro", read_DrawTexturePro },
+};
+
+// Re-records command 'index', e.g. list:Set(3, 'DrawRectangleRec', rect, RED)
+static int f_DrawList_Set(lua_State *L) {
+    DrawList *list = check_DrawList(L, 1);
+    const lua_Integer index = luaL_checkinteger(L, 2);
+    const char *name = luaL_checkstring(L, 3);
+    luaL_argcheck(L, index >= 1 && index <= list->count, 2, "index out of range");
+    for (size_t i = 0; i < sizeof(draw_readers) / sizeof(draw_readers[0]); ++i) {
+        if (strcmp(draw_readers[i].name, name) != 0) continue;
+        DrawCommand command = { 0 };
+        const int anchor = draw_readers[i].read(L, 4, &command);
+        record_DrawCommand(L, list, (int)index - 1, &command, anchor);
+        return 0;
+    }
+    return luaL_argerror(L, 3, "not a recording method");
+}
+
+#define DRAW_LIST_METHOD(name) \
+    static int f_DrawList_##name(lua_State *L) { return append_DrawCommand(L, read_##name); }
+DRAW_LIST_METHOD(DrawPixel) DRAW_LIST_METHOD(DrawPixelV) DRAW_LIST_METHOD(DrawLine) DRAW_LIST_METHOD(DrawLineV)
+DRAW_LIST_METHOD(DrawLineEx) DRAW_LIST_METHOD(DrawCircle) DRAW_LIST_METHOD(DrawCircleV) DRAW_LIST_METHOD(DrawCircleLines)
+DRAW_LIST_METHOD(DrawRectangle) DRAW_LIST_METHOD(DrawRectangleV) DRAW_LIST_METHOD(DrawRectangleRec) DRAW_LIST_METHOD(DrawRectanglePro)
+DRAW_LIST_METHOD(DrawRectangleLines) DRAW_LIST_METHOD(DrawRectangleLinesEx) DRAW_LIST_METHOD(DrawRectangleRounded)
+DRAW_LIST_METHOD(DrawTriangle) DRAW_LIST_METHOD(DrawTriangleLines) DRAW_LIST_METHOD(DrawPoly)
+DRAW_LIST_METHOD(DrawText) DRAW_LIST_METHOD(DrawTextEx)
+DRAW_LIST_METHOD(DrawTexture) DRAW_LIST_METHOD(DrawTextureV) DRAW_LIST_METHOD(DrawTextureEx)
+DRAW_LIST_METHOD(DrawTextureRec) DRAW_LIST_METHOD(DrawTexturePro)
+
+
+//==[[ SpriteBatch object ]]====================================================
+
+typedef struct Sprite {
+    Rectangle source;
+    Rectangle dest;
+    Vector2 origin;
+    float rotation;
+    Color tint;
+} Sprite;
+
+typedef struct SpriteBatch {
+    Texture texture;
+    int count;
+    int capacity;
+    Sprite *sprites;
+} SpriteBatch;
+
+static SpriteBatch *check_SpriteBatch(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "SpriteBatch");
+}
+
+static void resize_SpriteBatch(lua_State *L, SpriteBatch *batch, const int count) {
+    if (count > batch->capacity) {
+        if (count > INT_MAX / (int)sizeof(Sprite)) luaL_error(L, "SpriteBatch too large");
+        int capacity = batch->capacity > 0 ? batch->capacity : 64;
+        while (capacity < count) capacity *= 2;
+        Sprite *sprites = realloc(batch->sprites, sizeof(Sprite) * (size_t)capacity);
+        if (sprites == NULL) luaL_error(L, "out of memory");
+        batch->sprites = sprites;
+        batch->capacity = capacity;
+    }
+    // new sprites show the whole texture at the origin
+    for (int i = batch->count; i < count; ++i) {
+        const Rectangle rect = { 0.0f, 0.0f, (float)batch->texture.width, (float)batch->texture.height };
+        batch->sprites[i] = (Sprite){ .source = rect, .dest = rect, .tint = WHITE };
+    }
+    batch->count = count;
+}
+
+static Sprite *check_Sprite(lua_State *L, const int idx) {
+    SpriteBatch *batch = check_SpriteBatch(L, 1);
+    lua_Integer i = luaL_checkinteger(L, idx);
+    luaL_argcheck(L, i >= 1 && i <= batch->count, idx, "index out of range");
+    return &batch->sprites[i - 1];
+}
+
+static void draw_Sprite(const Sprite *sprite, const float width, const float height) {
+    // same vertex layout as DrawTexturePro, but without the per-call texture switch
+    Rectangle source = sprite->source;
+    const Rectangle dest = sprite->dest;
+    const Vector2 origin = sprite->origin;
+    bool flipX = false;
+    if (source.width < 0) { flipX = true; source.width *= -1; }
+    if (source.height < 0) source.y -= source.height;
+    Vector2 topLeft, topRight, bottomLeft, bottomRight;
+    if (sprite->rotation == 0.0f) {
+        const float x = dest.x - origin.x, y = dest.y - origin.y;
+        topLeft = (Vector2){ x, y };
+        topRight = (Vector2){ x + dest.width, y };
+        bottomLeft = (Vector2){ x, y + dest.height };
+        bottomRight = (Vector2){ x + dest.width, y + dest.height };
+    } else {
+        const float s = sinf(sprite->rotation * DEG2RAD), c = cosf(sprite->rotation * DEG2RAD);
+        const float x = dest.x, y = dest.y, dx = -origin.x, dy = -origin.y;
+        topLeft = (Vector2){ x + dx * c - dy * s, y + dx * s + dy * c };
+        topRight = (Vector2){ x + (dx + dest.width) * c - dy * s, y + (dx + dest.width) * s + dy * c };
+        bottomLeft = (Vector2){ x + dx * c - (dy + dest.height) * s, y + dx * s + (dy + dest.height) * c };
+        bottomRight = (Vector2){ x + (dx + dest.width) * c - (dy + dest.height) * s, y + (dx + dest.width) * s + (dy + dest.height) * c };
+    }
+    const float left = source.x / width, right = (source.x + source.width) / width;
+    const float top = source.y / height, bottom = (source.y + source.height) / height;
+    rlCheckRenderBatchLimit(4);
+    rlColor4ub(sprite->tint.r, sprite->tint.g, sprite->tint.b, sprite->tint.a);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    rlTexCoord2f(flipX ? right : left, top); rlVertex2f(topLeft.x, topLeft.y);
+    rlTexCoord2f(flipX ? right : left, bottom); rlVertex2f(bottomLeft.x, bottomLeft.y);
+    rlTexCoord2f(flipX ? left : right, bottom); rlVertex2f(bottomRight.x, bottomRight.y);
+    rlTexCoord2f(flipX ? left : right, top); rlVertex2f(topRight.x, topRight.y);
+}
+
+static int f_SpriteBatch(lua_State *L) {
+    const Texture texture = *check_Texture(L, 1);
+    lua_Integer count = luaL_optinteger(L, 2, 0);
+    luaL_argcheck(L, count >= 0 && count <= INT_MAX, 2, "invalid count");
+    SpriteBatch *batch = push_object(L, "SpriteBatch", sizeof(SpriteBatch), 1);
+    *batch = (SpriteBatch){ .texture = texture };
+    // the batch references the texture, so keep it alive
+    lua_pushvalue(L, 1);
+    lua_setiuservalue(L, -2, 1);
+    resize_SpriteBatch(L, batch, (int)count);
+    return 1;
+}
+
+static int f_SpriteBatch__gc(lua_State *L) {
+    SpriteBatch *batch = check_SpriteBatch(L, 1);
+    free(batch->sprites);
+    batch->sprites = NULL;
+    batch->count = batch->capacity = 0;
+    return 0;
+}
+
+static int f_SpriteBatch__tostring(lua_State *L) {
+    lua_pushfstring(L, "SpriteBatch(count = %d)", check_SpriteBatch(L, 1)->count);
+    return 1;
+}
+
+static int f_SpriteBatch__len(lua_State *L) {
+    lua_pushinteger(L, check_SpriteBatch(L, 1)->count);
+    return 1;
+}
+
+static int f_SpriteBatch_Add(lua_State *L) {
+    SpriteBatch *batch = check_SpriteBatch(L, 1);
+    const Sprite sprite = {
+        .source = *check_Rectangle(L, 2),
+        .dest = *check_Rectangle(L, 3),
+        .origin = lua_isnoneornil(L, 4) ? Vector2Zero() : *check_Vector2(L, 4),
+        .rotation = (float)luaL_optnumber(L, 5, 0.0),
+        .tint = lua_isnoneornil(L, 6) ? WHITE : *check_Color(L, 6),
+    };
+    resize_SpriteBatch(L, batch, batch->count + 1);
+    batch->sprites[batch->count - 1] = sprite;
+    lua_pushinteger(L, batch->count);
+    return 1;
+}
+
+static int f_SpriteBatch_Set(lua_State *L) {
+    Sprite *sprite = check_Sprite(L, 2);
+    *sprite = (Sprite){
+        .source = *check_Rectangle(L, 3),
+        .dest = *check_Rectangle(L, 4),
+        .origin = lua_isnoneornil(L, 5) ? Vector2Zero() : *check_Vector2(L, 5),
+        .rotation = (float)luaL_optnumber(L, 6, 0.0),
+        .tint = lua_isnoneornil(L, 7) ? WHITE : *check_Color(L, 7),
+    };
+    return 0;
+}
+
+static int f_SpriteBatch_SetSource(lua_State *L) {
+    check_Sprite(L, 2)->source = *check_Rectangle(L, 3);
+    return 0;
+}
+
+static int f_SpriteBatch_SetDest(lua_State *L) {
+    check_Sprite(L, 2)->dest = *check_Rectangle(L, 3);
+    return 0;
+}
+
+static int f_SpriteBatch_SetPosition(lua_State *L) {
+    Sprite *sprite = check_Sprite(L, 2);
+    const Vector2 position = check_Vector2_XY(L, 3);
+    sprite->dest.x = position.x;
+    sprite->dest.y = position.y;
+    return 0;
+}
+
+static int f_SpriteBatch_SetOrigin(lua_State *L) {
+    check_Sprite(L, 2)->origin = check_Vector2_XY(L, 3);
+    return 0;
+}
+
+static int f_SpriteBatch_SetRotation(lua_State *L) {
+    check_Sprite(L, 2)->rotation = (float)luaL_checknumber(L, 3);
+    return 0;
+}
+
+static int f_SpriteBatch_SetTint(lua_State *L) {
+    check_Sprite(L, 2)->tint = *check_Color(L, 3);
+    return 0;
+}
+
+static int f_SpriteBatch_GetPosition(lua_State *L) {
+    const Sprite *sprite = check_Sprite(L, 2);
+    lua_pushnumber(L, sprite->dest.x);
+    lua_pushnumber(L, sprite->dest.y);
+    return 2;
+}
+
+static int f_SpriteBatch_Resize(lua_State *L) {
+    lua_Integer count = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, count >= 0 && count <= INT_MAX, 2, "invalid count");
+    resize_SpriteBatch(L, check_SpriteBatch(L, 1), (int)count);
+    return 0;
+}
+
+static int f_SpriteBatch_Clear(lua_State *L) {
+    check_SpriteBatch(L, 1)->count = 0;
+    return 0;
+}
+
+static int f_SpriteBatch_Draw(lua_State *L) {
+    const SpriteBatch *batch = check_SpriteBatch(L, 1);
+    lua_Integer first = luaL_optinteger(L, 2, 1), last = luaL_optinteger(L, 3, batch->count);
+    if (first < 1) first = 1;
+    if (last > batch->count) last = batch->count;
+    if (batch->texture.id == 0 || first > last) return 0;
+    const float width = (float)batch->texture.width, height = (float)batch->texture.height;
+    rlSetTexture(batch->texture.id);
+    rlBegin(RL_QUADS);
+    for (lua_Integer i = first - 1; i < last; ++i)
+        draw_Sprite(&batch->sprites[i], width, height);
+    rlEnd();
+    rlSetTexture(0);
+    return 0;
+}
+
+static int f_SpriteBatch_get_texture(lua_State *L) {
+    check_SpriteBatch(L, 1);
+    lua_getiuservalue(L, 1, 1);
+    return 1;
+}
+
+
+//==[[ ParticleSystem object ]]=================================================
+
+typedef struct ParticleSystem {
+    int count;
+    int capacity;
+    // particle state as structure of arrays, all carved out of one allocation
+    float *x, *y, *vx, *vy, *age, *life;
+    // emitter parameters
+    Vector2 position;
+    Vector2 gravity;
+    float rate, accumulator;
+    float lifeMin, lifeMax;
+    float speedMin, speedMax;
+    float angle, spread;
+    float damping;
+    float sizeStart, sizeEnd;
+    Color colorStart, colorEnd;
+    Texture texture;
+    unsigned int seed;
+} ParticleSystem;
+
+static ParticleSystem *check_ParticleSystem(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "ParticleSystem");
+}
+
+static float random_ParticleSystem(ParticleSystem *ps, const float min, const float max) {
+    // xorshift32, cheap and good enough for visual effects
+    ps->seed ^= ps->seed << 13;
+    ps->seed ^= ps->seed >> 17;
+    ps->seed ^= ps->seed << 5;
+    return min + (max - min) * (float)(ps->seed >> 8) * (1.0f / 16777216.0f);
+}
+
+static void emit_ParticleSystem(ParticleSystem *ps, int count) {
+    if (count > ps->capacity - ps->count) count = ps->capacity - ps->count;
+    for (int i = ps->count; i < ps->count + count; ++i) {
+        const float angle = (ps->angle + random_ParticleSystem(ps, -0.5f, 0.5f) * ps->spread) * DEG2RAD;
+        const float speed = random_ParticleSystem(ps, ps->speedMin, ps->speedMax);
+        ps->x[i] = ps->position.x;
+        ps->y[i] = ps->position.y;
+        ps->vx[i] = cosf(angle) * speed;
+        ps->vy[i] = sinf(angle) * speed;
+        ps->age[i] = 0.0f;
+        ps->life[i] = fmaxf(random_ParticleSystem(ps, ps->lifeMin, ps->lifeMax), 1e-6f);
+    }
+    ps->count += count;
+}
+
+static void update_ParticleSystem(ParticleSystem *ps, const float dt) {
+    const int n = ps->count;
+    float *restrict x = ps->x, *restrict y = ps->y, *restrict vx = ps->vx, *restrict vy = ps->vy, *restrict age = ps->age;
+    const float gx = ps->gravity.x * dt, gy = ps->gravity.y * dt;
+    const float damping = 1.0f / (1.0f + ps->damping * dt);
+    // plain loops over independent arrays, so the compiler can vectorize them
+    for (int i = 0; i < n; ++i) vx[i] = (vx[i] + gx) * damping;
+    for (int i = 0; i < n; ++i) vy[i] = (vy[i] + gy) * damping;
+    for (int i = 0; i < n; ++i) x[i] += vx[i] * dt;
+    for (int i = 0; i < n; ++i) y[i] += vy[i] * dt;
+    for (int i = 0; i < n; ++i) age[i] += dt;
+    // remove expired particles by moving the last one into their slot
+    for (int i = 0; i < ps->count;) {
+        if (ps->age[i] < ps->life[i]) { ++i; continue; }
+        const int last = --ps->count;
+        ps->x[i] = ps->x[last]; ps->y[i] = ps->y[last];
+        ps->vx[i] = ps->vx[last]; ps->vy[i] = ps->vy[last];
+        ps->age[i] = ps->age[last]; ps->life[i] = ps->life[last];
+    }
+}
+
+static unsigned char lerp_color_component(const unsigned char a, const unsigned char b, const float t) {
+    return (unsigned char)((float)a + ((float)b - (float)a) * t);
+}
+
+static void check_ParticleSystem_config(lua_State *L, ParticleSystem *ps, const int idx) {
+    luaL_checktype(L, idx, LUA_TTABLE);
+    if (lua_getfield(L, idx, "position") != LUA_TNIL) ps->position = *check_Vector2(L, -1);
+    if (lua_getfield(L, idx, "gravity") != LUA_TNIL) ps->gravity = *check_Vector2(L, -1);
+    if (lua_getfield(L, idx, "colorStart") != LUA_TNIL) ps->colorStart = *check_Color(L, -1);
+    if (lua_getfield(L, idx, "colorEnd") != LUA_TNIL) ps->colorEnd = *check_Color(L, -1);
+    lua_pop(L, 4);
+    static const char *const names[] = { "rate", "lifeMin", "lifeMax", "speedMin", "speedMax", "angle", "spread", "damping", "sizeStart", "sizeEnd" };
+    float *const fields[] = { &ps->rate, &ps->lifeMin, &ps->lifeMax, &ps->speedMin, &ps->speedMax, &ps->angle, &ps->spread, &ps->damping, &ps->sizeStart, &ps->sizeEnd };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        if (lua_getfield(L, idx, names[i]) != LUA_TNIL) *fields[i] = (float)luaL_checknumber(L, -1);
+        lua_pop(L, 1);
+    }
+}
+
+static int f_ParticleSystem(lua_State *L) {
+    lua_Integer capacity = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, capacity > 0 && capacity <= INT_MAX / 6 / (int)sizeof(float), 1, "invalid capacity");
+    const Texture *texture = lua_isnoneornil(L, 2) ? NULL : check_Texture(L, 2);
+    ParticleSystem *ps = push_object(L, "ParticleSystem", sizeof(ParticleSystem), 1);
+    *ps = (ParticleSystem){
+        .capacity = (int)capacity,
+        .rate = 10.0f, .lifeMin = 1.0f, .lifeMax = 1.0f, .speedMin = 50.0f, .speedMax = 50.0f,
+        .angle = -90.0f, .spread = 360.0f, .sizeStart = 4.0f, .sizeEnd = 4.0f,
+        .colorStart = WHITE, .colorEnd = (Color){ 255, 255, 255, 0 },
+        .texture = texture != NULL ? *texture : (Texture){ 0 },
+        .seed = 0x9E3779B9u,
+    };
+    float *data = malloc(sizeof(float) * 6 * (size_t)capacity);
+    if (data == NULL) return luaL_error(L, "out of memory");
+    ps->x = data; ps->y = ps->x + capacity; ps->vx = ps->y + capacity;
+    ps->vy = ps->vx + capacity; ps->age = ps->vy + capacity; ps->life = ps->age + capacity;
+    if (texture != NULL) {
+        lua_pushvalue(L, 2);
+        lua_setiuservalue(L, -2, 1);
+    }
+    if (!lua_isnoneornil(L, 3))
+        check_ParticleSystem_config(L, ps, 3);
+    return 1;
+}
+
+static int f_ParticleSystem__gc(lua_State *L) {
+    ParticleSystem *ps = check_ParticleSystem(L, 1);
+    free(ps->x);
+    ps->x = ps->y = ps->vx = ps->vy = ps->age = ps->life = NULL;
+    ps->count = ps->capacity = 0;
+    return 0;
+}
+
+static int f_ParticleSystem__tostring(lua_State *L) {
+    const ParticleSystem *ps = check_ParticleSystem(L, 1);
+    lua_pushfstring(L, "ParticleSystem(count = %d, capacity = %d)", ps->count, ps->capacity);
+    return 1;
+}
+
+static int f_ParticleSystem_Configure(lua_State *L) {
+    check_ParticleSystem_config(L, check_ParticleSystem(L, 1), 2);
+    return 0;
+}
+
+static int f_ParticleSystem_Emit(lua_State *L) {
+    ParticleSystem *ps = check_ParticleSystem(L, 1);
+    lua_Integer count = luaL_checkinteger(L, 2);
+    if (count > 0) emit_ParticleSystem(ps, count < INT_MAX ? (int)count : INT_MAX);
+    return 0;
+}
+
+static int f_ParticleSystem_Update(lua_State *L) {
+    ParticleSystem *ps = check_ParticleSystem(L, 1);
+    const float dt = (float)luaL_checknumber(L, 2);
+    update_ParticleSystem(ps, dt);
+    ps->accumulator += ps->rate * dt;
+    // particles that do not fit are dropped anyway, this also keeps the int conversion defined
+    const float room = (float)(ps->capacity - ps->count);
+    if (!(ps->accumulator <= room)) ps->accumulator = room;
+    if (ps->accumulator >= 1.0f) {
+        const int count = (int)ps->accumulator;
+        ps->accumulator -= (float)count;
+        emit_ParticleSystem(ps, count);
+    }
+    return 0;
+}
+
+static int f_ParticleSystem_Clear(lua_State *L) {
+    ParticleSystem *ps = check_ParticleSystem(L, 1);
+    ps->count = 0;
+    ps->accumulator = 0.0f;
+    return 0;
+}
+
+static int f_ParticleSystem_Draw(lua_State *L) {
+    const ParticleSystem *ps = check_ParticleSystem(L, 1);
+    if (ps->count == 0) return 0;
+    const unsigned int texture = ps->texture.id != 0 ? ps->texture.id : rlGetTextureIdDefault();
+    const Color c0 = ps->colorStart, c1 = ps->colorEnd;
+    rlSetTexture(texture);
+    rlBegin(RL_QUADS);
+    for (int i = 0; i < ps->count; ++i) {
+        const float t = ps->age[i] / ps->life[i];
+        const float half = 0.5f * (ps->sizeStart + (ps->sizeEnd - ps->sizeStart) * t);
+        const float x = ps->x[i], y = ps->y[i];
+        rlCheckRenderBatchLimit(4);
+        rlColor4ub(lerp_color_component(c0.r, c1.r, t), lerp_color_component(c0.g, c1.g, t),
+            lerp_color_component(c0.b, c1.b, t), lerp_color_component(c0.a, c1.a, t));
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+        rlTexCoord2f(0.0f, 0.0f); rlVertex2f(x - half, y - half);
+        rlTexCoord2f(0.0f, 1.0f); rlVertex2f(x - half, y + half);
+        rlTexCoord2f(1.0f, 1.0f); rlVertex2f(x + half, y + half);
+        rlTexCoord2f(1.0f, 0.0f); rlVertex2f(x + half, y - half);
+    }
+    rlEnd();
+    rlSetTexture(0);
+    return 0;
+}
+
+static int f_ParticleSystem_get_count(lua_State *L) {
+    lua_pushinteger(L, check_ParticleSystem(L, 1)->count);
+    return 1;
+}
+
+static int f_ParticleSystem_get_position(lua_State *L) {
+    return push_Vector2_Ref(L, &check_ParticleSystem(L, 1)->position);
+}
+
+static int f_ParticleSystem_set_position(lua_State *L) {
+    check_ParticleSystem(L, 1)->position = *check_Vector2(L, 2);
+    return 0;
+}
+
+static int f_ParticleSystem_get_rate(lua_State *L) {
+    lua_pushnumber(L, check_ParticleSystem(L, 1)->rate);
+    return 1;
+}
+
+static int f_ParticleSystem_set_rate(lua_State *L) {
+    check_ParticleSystem(L, 1)->rate = (float)luaL_checknumber(L, 2);
+    return 0;
+}
+
+
+//==[[ SpatialHash object ]]====================================================
+
+typedef struct SpatialEntry {
+    lua_Integer id;
+    Rectangle bounds;
+    Vector2 center;
+    float radius;
+    bool circle;
+    unsigned int stamp;
+} SpatialEntry;
+
+typedef struct SpatialCell {
+    int entry;
+    int cx, cy;
+} SpatialCell;
+
+typedef struct SpatialHash {
+    float cellSize;
+    int bucketCount;
+    int count, capacity;
+    SpatialEntry *entries;
+    // open addressing map from id to entry index + 1, 0 marks an empty slot
+    int slotCapacity;
+    int *slots;
+    // grid rebuilt lazily before a query: cells of bucket b are cells[bucketStart[b] .. bucketStart[b + 1] - 1]
+    int *bucketStart;
+    SpatialCell *cells;
+    int cellCapacity;
+    bool dirty;
+    unsigned int stamp;
+} SpatialHash;
+
+static SpatialHash *check_SpatialHash(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "SpatialHash");
+}
+
+static unsigned int hash_SpatialId(const lua_Integer id) {
+    unsigned long long h = (unsigned long long)id * 0x9E3779B97F4A7C15ull;
+    return (unsigned int)(h >> 32);
+}
+
+static int bucket_SpatialHash(const SpatialHash *sh, const int cx, const int cy) {
+    const unsigned int h = ((unsigned int)cx * 73856093u) ^ ((unsigned int)cy * 19349663u);
+    return (int)(h % (unsigned int)sh->bucketCount);
+}
+
+static int cell_SpatialHash(const SpatialHash *sh, const float v) {
+    const float c = floorf(v / sh->cellSize);
+    if (c != c) return 0;
+    if (c < (float)-INT_MAX) return -INT_MAX;
+    if (c > (float)INT_MAX / 2) return INT_MAX / 2;
+    return (int)c;
+}
+
+static int find_SpatialHash_slot(const SpatialHash *sh, const lua_Integer id) {
+    const int mask = sh->slotCapacity - 1;
+    int i = (int)(hash_SpatialId(id) & (unsigned int)mask);
+    while (sh->slots[i] != 0 && sh->entries[sh->slots[i] - 1].id != id)
+        i = (i + 1) & mask;
+    return i;
+}
+
+static void rehash_SpatialHash(lua_State *L, SpatialHash *sh, const int slotCapacity) {
+    int *slots = calloc((size_t)slotCapacity, sizeof(int));
+    if (slots == NULL) luaL_error(L, "out of memory");
+    free(sh->slots);
+    sh->slots = slots;
+    sh->slotCapacity = slotCapacity;
+    for (int i = 0; i < sh->count; ++i)
+        sh->slots[find_SpatialHash_slot(sh, sh->entries[i].id)] = i + 1;
+}
+
+static void reserve_SpatialHash(lua_State *L, SpatialHash *sh, const int capacity) {
+    if (capacity <= sh->capacity) return;
+    if (capacity > INT_MAX / 4) luaL_error(L, "SpatialHash too large");
+    int new_capacity = sh->capacity > 0 ? sh->capacity : 64;
+    while (new_capacity < capacity) new_capacity *= 2;
+    SpatialEntry *entries = realloc(sh->entries, sizeof(SpatialEntry) * (size_t)new_capacity);
+    if (entries == NULL) luaL_error(L, "out of memory");
+    sh->entries = entries;
+    sh->capacity = new_capacity;
+    if (sh->slotCapacity < new_capacity * 2)
+        rehash_SpatialHash(L, sh, new_capacity * 2);
+}
+
+static void remove_SpatialHash_slot(SpatialHash *sh, int i) {
+    // backward shift deletion keeps probe sequences intact without tombstones
+    const int mask = sh->slotCapacity - 1;
+    for (int j = (i + 1) & mask; sh->slots[j] != 0; j = (j + 1) & mask) {
+        const int k = (int)(hash_SpatialId(sh->entries[sh->slots[j] - 1].id) & (unsigned int)mask);
+        if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j)) {
+            sh->slots[i] = sh->slots[j];
+            i = j;
+        }
+    }
+    sh->slots[i] = 0;
+}
+
+static void rebuild_SpatialHash(lua_State *L, SpatialHash *sh) {
+    if (!sh->dirty) return;
+    int *start = sh->bucketStart;
+    memset(start, 0, sizeof(int) * (size_t)(sh->bucketCount + 1));
+    size_t total = 0;
+    for (int i = 0; i < sh->count; ++i) {
+        const Rectangle b = sh->entries[i].bounds;
+        const int x0 = cell_SpatialHash(sh, b.x), x1 = cell_SpatialHash(sh, b.x + b.width);
+        const int y0 = cell_SpatialHash(sh, b.y), y1 = cell_SpatialHash(sh, b.y + b.height);
+        total += (size_t)((long long)x1 - x0 + 1) * (size_t)((long long)y1 - y0 + 1);
+        if (total > INT_MAX) luaL_error(L, "SpatialHash cell size too small for the inserted shapes");
+        for (int cy = y0; cy <= y1; ++cy)
+            for (int cx = x0; cx <= x1; ++cx)
+                ++start[bucket_SpatialHash(sh, cx, cy) + 1];
+    }
+    if ((int)total > sh->cellCapacity) {
+        SpatialCell *cells = realloc(sh->cells, sizeof(SpatialCell) * total);
+        if (cells == NULL) luaL_error(L, "out of memory");
+        sh->cells = cells;
+        sh->cellCapacity = (int)total;
+    }
+    for (int b = 0; b < sh->bucketCount; ++b) start[b + 1] += start[b];
+    // fill using start[b] as a cursor, which leaves it pointing at the next bucket; shift back afterwards
+    for (int i = 0; i < sh->count; ++i) {
+        const Rectangle b = sh->entries[i].bounds;
+        const int x0 = cell_SpatialHash(sh, b.x), x1 = cell_SpatialHash(sh, b.x + b.width);
+        const int y0 = cell_SpatialHash(sh, b.y), y1 = cell_SpatialHash(sh, b.y + b.height);
+        for (int cy = y0; cy <= y1; ++cy)
+            for (int cx = x0; cx <= x1; ++cx)
+                sh->cells[start[bucket_SpatialHash(sh, cx, cy)]++] = (SpatialCell){ i, cx, cy };
+    }
+    for (int b = sh->bucketCount; b > 0; --b) start[b] = start[b - 1];
+    start[0] = 0;
+    sh->dirty = false;
+}
+
+static unsigned int next_SpatialHash_stamp(SpatialHash *sh) {
+    if (++sh->stamp == 0) {
+        for (int i = 0; i < sh->count; ++i) sh->entries[i].stamp = 0;
+        sh->stamp = 1;
+    }
+    return sh->stamp;
+}
+
+static bool overlap_SpatialEntry(const SpatialEntry *a, const SpatialEntry *b) {
+    if (a->circle && b->circle) return CheckCollisionCircles(a->center, a->radius, b->center, b->radius);
+    if (a->circle) return CheckCollisionCircleRec(a->center, a->radius, b->bounds);
+    if (b->circle) return CheckCollisionCircleRec(b->center, b->radius, a->bounds);
+    return CheckCollisionRecs(a->bounds, b->bounds);
+}
+
+// Reads a shape at idx: either a Rectangle or a Vector2 center followed by a radius
+static SpatialEntry check_SpatialEntry(lua_State *L, const int idx) {
+    SpatialEntry entry = { 0 };
+    const Vector2 *center = test_Vector2(L, idx);
+    if (center != NULL) {
+        entry.circle = true;
+        entry.center = *center;
+        entry.radius = (float)luaL_checknumber(L, idx + 1);
+        luaL_argcheck(L, entry.radius >= 0.0f, idx + 1, "negative radius");
+        entry.bounds = (Rectangle){ center->x - entry.radius, center->y - entry.radius, 2.0f * entry.radius, 2.0f * entry.radius };
+    } else {
+        entry.bounds = *check_Rectangle(L, idx);
+    }
+    return entry;
+}
+
+// Prepares the optional output table at idx (or a new one) on top of the stack
+static void push_SpatialHash_out(lua_State *L, const int idx) {
+    if (lua_isnoneornil(L, idx)) lua_newtable(L);
+    else {
+        luaL_checktype(L, idx, LUA_TTABLE);
+        lua_pushvalue(L, idx);
+    }
+}
+
+// Clears stale entries of a reused output table past n and returns out, n
+static int finish_SpatialHash_out(lua_State *L, const lua_Integer n, const lua_Integer count) {
+    for (lua_Integer i = (lua_Integer)lua_rawlen(L, -1); i > n; --i) {
+        lua_pushnil(L);
+        lua_rawseti(L, -2, i);
+    }
+    lua_pushinteger(L, count);
+    return 2;
+}
+
+static int query_SpatialHash(lua_State *L, SpatialHash *sh, const SpatialEntry *query) {
+    rebuild_SpatialHash(L, sh);
+    const unsigned int stamp = next_SpatialHash_stamp(sh);
+    const Rectangle b = query->bounds;
+    const int x0 = cell_SpatialHash(sh, b.x), x1 = cell_SpatialHash(sh, b.x + b.width);
+    const int y0 = cell_SpatialHash(sh, b.y), y1 = cell_SpatialHash(sh, b.y + b.height);
+    lua_Integer n = 0;
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            const int bucket = bucket_SpatialHash(sh, cx, cy);
+            for (int c = sh->bucketStart[bucket]; c < sh->bucketStart[bucket + 1]; ++c) {
+                SpatialEntry *entry = &sh->entries[sh->cells[c].entry];
+                if (entry->stamp == stamp) continue;
+                entry->stamp = stamp;
+                if (!overlap_SpatialEntry(entry, query)) continue;
+                lua_pushinteger(L, entry->id);
+                lua_rawseti(L, -2, ++n);
+            }
+        }
+    }
+    return finish_SpatialHash_out(L, n, n);
+}
+
+static int f_SpatialHash(lua_State *L) {
+    const float cellSize = (float)luaL_checknumber(L, 1);
+    const lua_Integer buckets = luaL_optinteger(L, 2, 4096);
+    luaL_argcheck(L, cellSize > 0.0f, 1, "cell size must be positive");
+    luaL_argcheck(L, buckets > 0 && buckets < INT_MAX / (int)sizeof(int), 2, "invalid bucket count");
+    SpatialHash *sh = push_object(L, "SpatialHash", sizeof(SpatialHash), 0);
+    *sh = (SpatialHash){ .cellSize = cellSize, .bucketCount = (int)buckets };
+    sh->bucketStart = calloc((size_t)buckets + 1, sizeof(int));
+    if (sh->bucketStart == NULL) return luaL_error(L, "out of memory");
+    reserve_SpatialHash(L, sh, 1);
+    return 1;
+}
+
+static int f_SpatialHash__gc(lua_State *L) {
+    SpatialHash *sh = check_SpatialHash(L, 1);
+    free(sh->entries);
+    free(sh->slots);
+    free(sh->bucketStart);
+    free(sh->cells);
+    *sh = (SpatialHash){ 0 };
+    return 0;
+}
+
+static int f_SpatialHash__tostring(lua_State *L) {
+    const SpatialHash *sh = check_SpatialHash(L, 1);
+    lua_pushfstring(L, "SpatialHash(count = %d, cellSize = %f)", sh->count, (lua_Number)sh->cellSize);
+    return 1;
+}
+
+static int f_SpatialHash__len(lua_State *L) {
+    lua_pushinteger(L, check_SpatialHash(L, 1)->count);
+    return 1;
+}
+
+static int f_SpatialHash_Insert(lua_State *L) {
+    SpatialHash *sh = check_SpatialHash(L, 1);
+    const lua_Integer id = luaL_checkinteger(L, 2);
+    SpatialEntry entry = check_SpatialEntry(L, 3);
+    luaL_argcheck(L, sh->slots != NULL, 1, "SpatialHash has been released");
+    reserve_SpatialHash(L, sh, sh->count + 1);
+    const int slot = find_SpatialHash_slot(sh, id);
+    if (sh->slots[slot] != 0) return luaL_error(L, "id %I already in SpatialHash", id);
+    entry.id = id;
+    sh->entries[sh->count] = entry;
+    sh->slots[slot] = ++sh->count;
+    sh->dirty = true;
+    return 0;
+}
+
+static int f_SpatialHash_Update(lua_State *L) {
+    SpatialHash *sh = check_SpatialHash(L, 1);
+    const lua_Integer id = luaL_checkinteger(L, 2);
+    SpatialEntry entry = check_SpatialEntry(L, 3);
+    const int slot = sh->slots != NULL ? sh->slots[find_SpatialHash_slot(sh, id)] : 0;
+    if (slot == 0) return luaL_error(L, "id %I not in SpatialHash", id);
+    entry.id = id;
+    sh->entries[slot - 1] = entry;
+    sh->dirty = true;
+    return 0;
+}
+
+static int f_SpatialHash_Remove(lua_State *L) {
+    SpatialHash *sh = check_SpatialHash(L, 1);
+    const lua_Integer id = luaL_checkinteger(L, 2);
+    const int slot = sh->slots != NULL ? find_SpatialHash_slot(sh, id) : 0;
+    const int index = sh->slots != NULL ? sh->slots[slot] - 1 : -1;
+    if (index < 0) {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+    remove_SpatialHash_slot(sh, slot);
+    const int last = --sh->count;
+    if (index != last) {
+        sh->entries[index] = sh->entries[last];
+        sh->slots[find_SpatialHash_slot(sh, sh->entries[index].id)] = index + 1;
+    }
+    sh->dirty = true;
+    lua_pushboolean(L, true);
+    return 1;
+}
+
+static int f_SpatialHash_Has(lua_State *L) {
+    const SpatialHash *sh = check_SpatialHash(L, 1);
+    const lua_Integer id = luaL_checkinteger(L, 2);
+    lua_pushboolean(L, sh->slots != NULL && sh->slots[find_SpatialHash_slot(sh, id)] != 0);
+    return 1;
+}
+
+static int f_SpatialHash_Clear(lua_State *L) {
+    SpatialHash *sh = check_SpatialHash(L, 1);
+    if (sh->slots != NULL) memset(sh->slots, 0, sizeof(int) * (size_t)sh->slotCapacity);
+    sh->count = 0;
+    sh->dirty = true;
+    return 0;
+}
+
+static int f_SpatialHash_QueryRec(lua_State *L) {
+    SpatialHash *sh = check_SpatialHash(L, 1);
+    const SpatialEntry query = { .bounds = *check_Rectangle(L, 2) };
+    push_SpatialHash_out(L, 3);
+    return query_SpatialHash(L, sh, &query);
+}
+
+static int f_SpatialHash_QueryRadius(lua_State *L) {
+    SpatialHash *sh = check_SpatialHash(L, 1);
+    check_Vector2(L, 2);
+    const SpatialEntry query = check_SpatialEntry(L, 2);
+    push_SpatialHash_out(L, 4);
+    return query_SpatialHash(L, sh, &query);
+}
+
+static int f_SpatialHash_QueryPairs(lua_State *L) {
+    SpatialHash *sh = check_SpatialHash(L, 1);
+    push_SpatialHash_out(L, 2);
+    rebuild_SpatialHash(L, sh);
+    lua_Integer n = 0;
+    for (int bucket = 0; bucket < sh->bucketCount; ++bucket) {
+        const int first = sh->bucketStart[bucket], last = sh->bucketStart[bucket + 1];
+        for (int i = first; i < last; ++i) {
+            const SpatialCell ci = sh->cells[i];
+            const SpatialEntry *a = &sh->entries[ci.entry];
+            for (int j = i + 1; j < last; ++j) {
+                const SpatialCell cj = sh->cells[j];
+                if (cj.cx != ci.cx || cj.cy != ci.cy) continue;
+                const SpatialEntry *b = &sh->entries[cj.entry];
+                // a pair sharing several cells is reported only from the cell holding the top-left of the overlap
+                if (cell_SpatialHash(sh, fmaxf(a->bounds.x, b->bounds.x)) != ci.cx) continue;
+                if (cell_SpatialHash(sh, fmaxf(a->bounds.y, b->bounds.y)) != ci.cy) continue;
+                if (!overlap_SpatialEntry(a, b)) continue;
+                lua_pushinteger(L, a->id);
+                lua_rawseti(L, -2, ++n);
+                lua_pushinteger(L, b->id);
+                lua_rawseti(L, -2, ++n);
+            }
+        }
+    }
+    return finish_SpatialHash_out(L, n, n / 2);
+}
+
+static int f_SpatialHash_get_count(lua_State *L) {
+    lua_pushinteger(L, check_SpatialHash(L, 1)->count);
+    return 1;
+}
+
+static int f_SpatialHash_get_cellSize(lua_State *L) {
+    lua_pushnumber(L, check_SpatialHash(L, 1)->cellSize);
+    return 1;
+}
+
+
+//==[[ Memory statistics ]]=====================================================
+
+static struct {
+    lua_Alloc alloc;
+    void *ud;
+    lua_Integer allocated; // bytes requested from the allocator since startup
+    lua_Integer freed; // bytes returned to the allocator since startup
+} alloc_stats;
+
+static void *CountingAlloc(void *ud, void *ptr, size_t osize, size_t nsize) {
+    (void)ud;
+    // 'osize' encodes the object type when 'ptr' is NULL, so only count growth of real blocks
+    if (nsize > 0 && (ptr == NULL || nsize > osize))
+        alloc_stats.allocated += (lua_Integer)(ptr == NULL ? nsize : nsize - osize);
+    else if (ptr != NULL && nsize < osize)
+        alloc_stats.freed += (lua_Integer)(osize - nsize);
+    return alloc_stats.alloc(alloc_stats.ud, ptr, osize, nsize);
+}
+
+static int f_GetAllocatedBytes(lua_State *L) {
+    lua_pushinteger(L, alloc_stats.allocated);
+    return 1;
+}
+
+
+//==[[ Profiler ]]==============================================================
+
+// Opt-in via --profile or the RAYLUA_PROFILE environment variable. When disabled the bindings
+// are registered as plain C functions, so the profiler costs nothing.
+
+typedef struct ProfileCounter {
+    lua_Integer calls;
+    long long ns;
+} ProfileCounter;
+
+typedef struct ProfileFrame {
+    lua_Integer frame;
+    long long frameTime, cTime;
+    lua_Integer gcCycles, allocated, freed;
+} ProfileFrame;
+
+static struct {
+    bool requested;         // set by the --profile command line option
+    bool enabled;
+    int count;              // number of profiled bindings
+    int endDrawing;         // index of EndDrawing, which closes a frame
+    const char **names;
+    char *methodNames;      // "Type:Method" names of the profiled object methods
+    ProfileCounter *current, *last;
+    ProfileFrame frame, lastFrame;
+    int depth;              // nesting of profiled calls, only top level calls count as C time
+    long long frameStart;
+    lua_Integer allocated, freed;
+} profiler;
+
+static long long profiler_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + (long long)ts.tv_nsec;
+}
+
+static void end_profiler_frame(void) {
+    const long long now = profiler_now();
+    profiler.frame.frameTime = now - profiler.frameStart;
+    profiler.frame.allocated = alloc_stats.allocated - profiler.allocated;
+    profiler.frame.freed = alloc_stats.freed - profiler.freed;
+    profiler.lastFrame = profiler.frame;
+    ProfileCounter *counters = profiler.last;
+    profiler.last = profiler.current;
+    profiler.current = counters;
+    memset(counters, 0, sizeof(ProfileCounter) * (size_t)profiler.count);
+    profiler.frame = (ProfileFrame){ .frame = profiler.lastFrame.frame + 1 };
+    profiler.frameStart = now;
+    profiler.allocated = alloc_stats.allocated;
+    profiler.freed = alloc_stats.freed;
+    // a binding that raised an error never returned, so resynchronize here
+    profiler.depth = 0;
+}
+
+static int f_profiled(lua_State *L) {
+    const lua_CFunction func = lua_tocfunction(L, lua_upvalueindex(1));
+    const int index = (int)lua_tointeger(L, lua_upvalueindex(2));
+    ++profiler.depth;
+    const long long start = profiler_now();
+    const int results = func(L);
+    const long long ns = profiler_now() - start;
+    if (--profiler.depth == 0) profiler.frame.cTime += ns;
+    profiler.current[index].calls++;
+    profiler.current[index].ns += ns;
+    if (index == profiler.endDrawing) end_profiler_frame();
+    return results;
+}
+
+static int f_profiler_sentinel__gc(lua_State *L) {
+    // count the finished cycle and arm a new sentinel for the next one
+    profiler.frame.gcCycles++;
+    lua_newtable(L);
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_setmetatable(L, -2);
+    return 0;
+}
+
+// Metatables pushed several times (e.g. "Vector2" and "Vector2*") share one funcs array and its counters
+static bool is_first_meta(const ObjectMeta *metas, const int index) {
+    for (int i = 0; i < index; ++i)
+        if (metas[i].funcs == metas[index].funcs) return false;
+    return true;
+}
+
+// Returns the counter index of the first method of metas[index]
+static int get_profiler_meta_base(const ObjectMeta *metas, const int index, const int funcCount) {
+    int base = funcCount;
+    for (int i = 0; metas[i].name != NULL; ++i) {
+        if (!is_first_meta(metas, i)) continue;
+        if (metas[i].funcs == metas[index].funcs) break;
+        for (int j = 0; metas[i].funcs[j].name != NULL; ++j)
+            if (is_method_name(metas[i].funcs[j].name)) ++base;
+    }
+    return base;
+}
+
+static void InitProfiler(lua_State *L, const luaL_Reg *funcs, const ObjectMeta *metas) {
+    if (!profiler.requested && !env_flag("RAYLUA_PROFILE")) return;
+    int count = 0;
+    size_t nameSize = 0;
+    while (funcs[count].name != NULL) ++count;
+    for (int i = 0; metas[i].name != NULL; ++i) {
+        if (!is_first_meta(metas, i)) continue;
+        for (int j = 0; metas[i].funcs[j].name != NULL; ++j) {
+            if (!is_method_name(metas[i].funcs[j].name)) continue;
+            nameSize += strlen(metas[i].name) + strlen(metas[i].funcs[j].name) + 2;
+            ++count;
+        }
+    }
+    profiler.names = malloc(sizeof(const char*) * (size_t)count);
+    profiler.methodNames = malloc(nameSize + 1);
+    profiler.current = calloc((size_t)count, sizeof(ProfileCounter));
+    profiler.last = calloc((size_t)count, sizeof(ProfileCounter));
+    if (profiler.names == NULL || profiler.methodNames == NULL || profiler.current == NULL || profiler.last == NULL) {
+        free(profiler.names); free(profiler.methodNames); free(profiler.current); free(profiler.last);
+        luaL_error(L, "out of memory");
+    }
+    profiler.count = count;
+    profiler.endDrawing = -1;
+    int index = 0;
+    for (; funcs[index].name != NULL; ++index) {
+        profiler.names[index] = funcs[index].name;
+        if (strcmp(funcs[index].name, "EndDrawing") == 0) profiler.endDrawing = index;
+    }
+    char *name = profiler.methodNames;
+    for (int i = 0; metas[i].name != NULL; ++i) {
+        if (!is_first_meta(metas, i)) continue;
+        for (int j = 0; metas[i].funcs[j].name != NULL; ++j) {
+            if (!is_method_name(metas[i].funcs[j].name)) continue;
+            profiler.names[index++] = name;
+            name += sprintf(name, "%s:%s", metas[i].name, metas[i].funcs[j].name) + 1;
+        }
+    }
+    // the sentinel table gets finalized once per garbage collection cycle
+    lua_newtable(L);
+    lua_pushvalue(L, -1);
+    lua_pushcclosure(L, f_profiler_sentinel__gc, 1);
+    lua_setfield(L, -2, "__gc");
+    lua_newtable(L);
+    lua_insert(L, -2);
+    lua_setmetatable(L, -2);
+    lua_pop(L, 1);
+    profiler.frameStart = profiler_now();
+    profiler.allocated = alloc_stats.allocated;
+    profiler.freed = alloc_stats.freed;
+    profiler.enabled = true;
+}
+
+// Replaces the methods of a metatable pushed by push_meta() with profiled closures.
+// Getters and setters are called directly by f__index / f__newindex and stay unprofiled.
+static void profile_meta(lua_State *L, const ObjectMeta *metas, const int index, const int funcCount) {
+    int counter = get_profiler_meta_base(metas, index, funcCount);
+    luaL_getmetatable(L, metas[index].name);
+    lua_getfield(L, -1, "__index");
+    lua_getupvalue(L, -1, 1);
+    for (const luaL_Reg *func = metas[index].funcs; func->name != NULL; ++func) {
+        if (!is_method_name(func->name)) continue;
+        lua_pushcfunction(L, func->func);
+        lua_pushinteger(L, counter++);
+        lua_pushcclosure(L, f_profiled, 2);
+        lua_setfield(L, -2, func->name);
+    }
+    lua_pop(L, 3);
+}
+
+static void ReleaseProfiler(void) {
+    free(profiler.names);
+    free(profiler.methodNames);
+    free(profiler.current);
+    free(profiler.last);
+    profiler.names = NULL;
+    profiler.methodNames = NULL;
+    profiler.current = profiler.last = NULL;
+    profiler.enabled = false;
+}
+
+static const ProfileCounter *sort_profiler_counters;
+
+static int compare_profiler_index(const void *a, const void *b) {
+    const long long na = sort_profiler_counters[*(const int*)a].ns;
+    const long long nb = sort_profiler_counters[*(const int*)b].ns;
+    return (na < nb) - (na > nb);
+}
+
+// Collects the indices of the bindings called in the last frame, slowest first
+static int sort_profiler_last(int *order) {
+    int n = 0;
+    for (int i = 0; i < profiler.count; ++i)
+        if (profiler.last[i].calls > 0) order[n++] = i;
+    sort_profiler_counters = profiler.last;
+    qsort(order, (size_t)n, sizeof(int), compare_profiler_index);
+    return n;
+}
+
+static int f_IsProfilerEnabled(lua_State *L) {
+    lua_pushboolean(L, profiler.enabled);
+    return 1;
+}
+
+static int f_GetProfilerFrame(lua_State *L) {
+    if (!profiler.enabled) return 0;
+    const ProfileFrame *frame = &profiler.lastFrame;
+    int *order = malloc(sizeof(int) * (size_t)profiler.count);
+    if (order == NULL) return luaL_error(L, "out of memory");
+    const int n = sort_profiler_last(order);
+    lua_createtable(L, 0, 9);
+    lua_pushinteger(L, frame->frame); lua_setfield(L, -2, "frame");
+    lua_pushinteger(L, frame->frameTime); lua_setfield(L, -2, "frameTime");
+    lua_pushinteger(L, frame->cTime); lua_setfield(L, -2, "cTime");
+    lua_pushinteger(L, frame->frameTime - frame->cTime); lua_setfield(L, -2, "luaTime");
+    lua_pushinteger(L, frame->gcCycles); lua_setfield(L, -2, "gcCycles");
+    lua_pushinteger(L, frame->allocated); lua_setfield(L, -2, "allocated");
+    lua_pushinteger(L, frame->freed); lua_setfield(L, -2, "freed");
+    lua_pushinteger(L, (lua_Integer)lua_gc(L, LUA_GCCOUNT, 0) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0)); lua_setfield(L, -2, "memory");
+    lua_createtable(L, n, 0);
+    for (int i = 0; i < n; ++i) {
+        const ProfileCounter *counter = &profiler.last[order[i]];
+        lua_createtable(L, 0, 3);
+        lua_pushstring(L, profiler.names[order[i]]); lua_setfield(L, -2, "name");
+        lua_pushinteger(L, counter->calls); lua_setfield(L, -2, "calls");
+        lua_pushinteger(L, counter->ns); lua_setfield(L, -2, "time");
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_setfield(L, -2, "calls");
+    free(order);
+    return 1;
+}
+
+static bool write_profiler_frame(FILE *fp, const bool json, const bool header) {
+    const ProfileFrame *frame = &profiler.lastFrame;
+    int *order = malloc(sizeof(int) * (size_t)profiler.count);
+    if (order == NULL) return false;
+    const int n = sort_profiler_last(order);
+    if (json) {
+        // one JSON object per line, so appended frames form a JSON Lines file
+        fprintf(fp, "{\"frame\":%lld,\"frameTime\":%lld,\"cTime\":%lld,\"luaTime\":%lld,\"gcCycles\":%lld,\"allocated\":%lld,\"freed\":%lld,\"calls\":[",
+            (long long)frame->frame, frame->frameTime, frame->cTime, frame->frameTime - frame->cTime,
+            (long long)frame->gcCycles, (long long)frame->allocated, (long long)frame->freed);
+        for (int i = 0; i < n; ++i)
+            fprintf(fp, "%s{\"name\":\"%s\",\"calls\":%lld,\"time\":%lld}", i > 0 ? "," : "",
+                profiler.names[order[i]], (long long)profiler.last[order[i]].calls, profiler.last[order[i]].ns);
+        fprintf(fp, "]}\n");
+    } else {
+        // frame totals use the pseudo names <frame>, <c> and <lua>; <frame> carries the gc cycles as calls
+        if (header) fprintf(fp, "frame,name,calls,time\n");
+        fprintf(fp, "%lld,<frame>,%lld,%lld\n", (long long)frame->frame, (long long)frame->gcCycles, frame->frameTime);
+        fprintf(fp, "%lld,<c>,0,%lld\n", (long long)frame->frame, frame->cTime);
+        fprintf(fp, "%lld,<lua>,0,%lld\n", (long long)frame->frame, frame->frameTime - frame->cTime);
+        for (int i = 0; i < n; ++i)
+            fprintf(fp, "%lld,%s,%lld,%lld\n", (long long)frame->frame, profiler.names[order[i]],
+                (long long)profiler.last[order[i]].calls, profiler.last[order[i]].ns);
+    }
+    free(order);
+    return !ferror(fp);
+}
+
+static int f_ExportProfilerFrame(lua_State *L) {
+    const char *fileName = luaL_checkstring(L, 1);
+    const bool append = lua_toboolean(L, 2);
+    if (!profiler.enabled) return luaL_error(L, "profiler is disabled, set RAYLUA_PROFILE=1 to enable it");
+    const size_t len = strlen(fileName);
+    const bool json = len >= 5 && strcmp(fileName + len - 5, ".json") == 0;
+    FILE *fp = fopen(fileName, append ? "ab" : "wb");
+    if (fp == NULL) {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    const bool ok = write_profiler_frame(fp, json, ftell(fp) <= 0);
+    lua_pushboolean(L, fclose(fp) == 0 && ok);
+    return 1;
+}
+
+
+//==[[ Headless mode ]]=========================================================
+
+// Selected with --headless or the RAYLUA_HEADLESS environment variable. The
+// window stays hidden, frames are rendered into an offscreen render texture
+// and run without vsync or frame rate limit. raylib still creates its GL
+// context through GLFW, so a display server is required; machines without
+// one run raylua under Xvfb (xvfb-run).
+
+static struct {
+    bool enabled;
+    bool drawing;   // between BeginDrawing() and EndDrawing()
+    RenderTexture target;
+} headless;
+
+static void InitHeadless(void) {
+    headless.enabled = true;
+    // prefer Mesa's software rasterizer and disable its vblank sync, unless configured otherwise
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+    setenv("vblank_mode", "0", 0);
+}
+
+// Returns why the hidden window cannot be created or NULL
+static const char *get_headless_display_error(void) {
+#if !defined(_WIN32) && !defined(__APPLE__)
+    const char *x11 = getenv("DISPLAY"), *wayland = getenv("WAYLAND_DISPLAY");
+    if ((x11 == NULL || *x11 == '\0') && (wayland == NULL || *wayland == '\0'))
+        return "headless mode needs a display server for its hidden window, but DISPLAY is not set (run under Xvfb, e.g. xvfb-run raylua --headless script.lua)";
+#endif
+    return NULL;
+}
+
+static void begin_headless_window(void) {
+    headless.target = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
+    SetTargetFPS(0);
+}
+
+static void end_headless_window(void) {
+    if (headless.target.id != 0) UnloadRenderTexture(headless.target);
+    headless.target = (RenderTexture){ 0 };
+}
+
+static Image load_headless_screen(void) {
+    rlDrawRenderBatchActive();
+    Image image = LoadImageFromTexture(headless.target.texture);
+    // render textures are stored bottom-up
+    ImageFlipVertical(&image);
+    return image;
+}
+
+static int f_IsHeadless(lua_State *L) {
+    lua_pushboolean(L, headless.enabled);
+    return 1;
+}
+
+
+//==[[ Archive object ]]========================================================
+
+// Read-only asset archives as written by pack.lua. Mounted archives are memory
+// mapped and searched, most recently mounted first, before the disk by the file
+// loaders, by raylib's file callbacks and by 'require'.
+//
+// Layout (little endian):
+//   header   "RLPK", u32 version, u32 count, u32 bucketBits
+//   buckets  (1 << bucketBits) + 1 x u32, first entry of each bucket
+//   entries  count x { u32 hash, u32 nameOffset, u32 nameLength, u32 flags, u64 dataOffset, u64 dataSize }
+//   names and data
+// Entries are sorted by the FNV-1a hash of their path and bucketed by its top bits.
+
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_HEADER_SIZE 16
+#define ARCHIVE_ENTRY_SIZE 32
+#define ARCHIVE_MAX_BUCKET_BITS 24
+#define ARCHIVE_MAX_PATH 1024
+
+typedef struct Archive {
+    unsigned char *base;
+    size_t size;
+    unsigned int count;
+    unsigned int bucketBits;
+    const unsigned char *buckets;
+    const unsigned char *entries;
+    struct Archive *next;   // next mounted archive
+    bool mounted;
+} Archive;
+
+static Archive *mounted_archives;
+
+static Archive *check_Archive(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "Archive");
+}
+
+static unsigned int read_u32(const unsigned char *p) {
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static unsigned long long read_u64(const unsigned char *p) {
+    return (unsigned long long)read_u32(p) | ((unsigned long long)read_u32(p + 4) << 32);
+}
+
+static unsigned int hash_archive_path(const char *path, const size_t length) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i)
+        hash = (hash ^ (unsigned char)path[i]) * 16777619u;
+    return hash;
+}
+
+// Normalizes a path like pack.lua does: forward slashes and no leading "./"
+static size_t normalize_archive_path(const char *fileName, char *path) {
+    while (fileName[0] == '.' && (fileName[1] == '/' || fileName[1] == '\\')) fileName += 2;
+    size_t length = 0;
+    for (; fileName[length] != '\0'; ++length) {
+        if (length >= ARCHIVE_MAX_PATH) return 0;
+        path[length] = fileName[length] == '\\' ? '/' : fileName[length];
+    }
+    return length;
+}
+
+static const unsigned char *find_archive_entry(const Archive *archive, const char *path, const size_t length, const unsigned int hash) {
+    const unsigned int bucket = archive->bucketBits > 0 ? hash >> (32 - archive->bucketBits) : 0;
+    const unsigned int last = read_u32(archive->buckets + 4 * (bucket + 1));
+    for (unsigned int i = read_u32(archive->buckets + 4 * bucket); i < last; ++i) {
+        const unsigned char *entry = archive->entries + (size_t)ARCHIVE_ENTRY_SIZE * i;
+        if (read_u32(entry) == hash && read_u32(entry + 8) == length && memcmp(archive->base + read_u32(entry + 4), path, length) == 0)
+            return entry;
+    }
+    return NULL;
+}
+
+// Returns the mapped data of a file in the mounted archives or NULL
+static const unsigned char *find_archive_file(const char *fileName, size_t *size, Archive **owner) {
+    if (mounted_archives == NULL) return NULL;
+    char path[ARCHIVE_MAX_PATH];
+    const size_t length = normalize_archive_path(fileName, path);
+    if (length == 0) return NULL;
+    const unsigned int hash = hash_archive_path(path, length);
+    for (Archive *archive = mounted_archives; archive != NULL; archive = archive->next) {
+        const unsigned char *entry = find_archive_entry(archive, path, length, hash);
+        if (entry == NULL) continue;
+        *size = (size_t)read_u64(entry + 24);
+        if (owner != NULL) *owner = archive;
+        return archive->base + read_u64(entry + 16);
+    }
+    return NULL;
+}
+
+// Like find_archive_file for the *FromMemory loaders, which take an int size
+static const unsigned char *find_archive_asset(const char *fileName, int *size) {
+    size_t length;
+    const unsigned char *data = find_archive_file(fileName, &length, NULL);
+    if (data == NULL || length > INT_MAX) return NULL;
+    *size = (int)length;
+    return data;
+}
+
+// Reads a file from disk into memory owned by raylib, the default behaviour replaced by the callbacks
+static unsigned char *load_disk_file(const char *fileName, unsigned int *bytesRead, const bool text) {
+    unsigned char *data = NULL;
+    FILE *fp = fopen(fileName, "rb");
+    if (fp == NULL) {
+        TraceLog(LOG_WARNING, "FILEIO: [%s] Failed to open file", fileName);
+        return NULL;
+    }
+    long size = fseek(fp, 0, SEEK_END) == 0 ? ftell(fp) : -1;
+    if (size >= 0 && (unsigned long)size < UINT_MAX && fseek(fp, 0, SEEK_SET) == 0) {
+        data = RL_MALLOC((size_t)size + 1);
+        if (data != NULL && fread(data, 1, (size_t)size, fp) != (size_t)size) {
+            RL_FREE(data);
+            data = NULL;
+        }
+    }
+    fclose(fp);
+    if (data == NULL) {
+        TraceLog(LOG_WARNING, "FILEIO: [%s] Failed to read file", fileName);
+        return NULL;
+    }
+    if (text) data[size] = '\0';
+    *bytesRead = (unsigned int)size;
+    return data;
+}
+
+static unsigned char *load_archive_or_disk_file(const char *fileName, unsigned int *bytesRead, const bool text) {
+    size_t size;
+    *bytesRead = 0;
+    const unsigned char *data = find_archive_file(fileName, &size, NULL);
+    if (data == NULL) return load_disk_file(fileName, bytesRead, text);
+    if (size >= UINT_MAX) return NULL;
+    unsigned char *copy = RL_MALLOC(size + 1);
+    if (copy == NULL) return NULL;
+    memcpy(copy, data, size);
+    if (text) copy[size] = '\0';
+    *bytesRead = (unsigned int)size;
+    return copy;
+}
+
+static unsigned char *archive_LoadFileData(const char *fileName, unsigned int *bytesRead) {
+    return load_archive_or_disk_file(fileName, bytesRead, false);
+}
+
+static char *archive_LoadFileText(const char *fileName) {
+    unsigned int length;
+    return (char*)load_archive_or_disk_file(fileName, &length, true);
+}
+
+static const char *map_Archive(Archive *archive, const char *fileName) {
+    const int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return strerror(errno);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < ARCHIVE_HEADER_SIZE) {
+        close(fd);
+        return "not an archive";
+    }
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return strerror(errno);
+    archive->base = base;
+    archive->size = (size_t)st.st_size;
+    return NULL;
+}
+
+// Checks the index once, so lookups can trust every offset in it
+static const char *validate_Archive(Archive *archive) {
+    const unsigned char *base = archive->base;
+    const size_t size = archive->size;
+    if (memcmp(base, "RLPK", 4) != 0) return "not an archive";
+    if (read_u32(base + 4) != ARCHIVE_VERSION) return "unsupported archive version";
+    archive->count = read_u32(base + 8);
+    archive->bucketBits = read_u32(base + 12);
+    if (archive->bucketBits > ARCHIVE_MAX_BUCKET_BITS) return "corrupt archive index";
+    const size_t buckets = ((size_t)1 << archive->bucketBits) + 1;
+    const size_t index = ARCHIVE_HEADER_SIZE + 4 * buckets;
+    if (index > size || (size - index) / ARCHIVE_ENTRY_SIZE < archive->count) return "corrupt archive index";
+    archive->buckets = base + ARCHIVE_HEADER_SIZE;
+    archive->entries = base + index;
+    unsigned int previous = 0;
+    for (size_t b = 0; b < buckets; ++b) {
+        const unsigned int first = read_u32(archive->buckets + 4 * b);
+        if (first < previous || first > archive->count) return "corrupt archive index";
+        previous = first;
+    }
+    if (previous != archive->count) return "corrupt archive index";
+    for (unsigned int i = 0; i < archive->count; ++i) {
+        const unsigned char *entry = archive->entries + (size_t)ARCHIVE_ENTRY_SIZE * i;
+        const unsigned long long nameOffset = read_u32(entry + 4), nameLength = read_u32(entry + 8);
+        const unsigned long long dataOffset = read_u64(entry + 16), dataSize = read_u64(entry + 24);
+        if (nameOffset > size || nameLength > size - nameOffset) return "corrupt archive entry";
+        if (dataOffset > size || dataSize > size - dataOffset) return "corrupt archive entry";
+    }
+    return NULL;
+}
+
+static void unmount_Archive(Archive *archive) {
+    if (!archive->mounted) return;
+    for (Archive **it = &mounted_archives; *it != NULL; it = &(*it)->next) {
+        if (*it == archive) {
+            *it = archive->next;
+            break;
+        }
+    }
+    archive->next = NULL;
+    archive->mounted = false;
+    if (mounted_archives == NULL) {
+        SetLoadFileDataCallback(NULL);
+        SetLoadFileTextCallback(NULL);
+    }
+}
+
+// Pushes the registry table that keeps mounted archives alive, keyed by their address
+static void push_archive_registry(lua_State *L) {
+    if (lua_getfield(L, LUA_REGISTRYINDEX, "raylua.archives") == LUA_TTABLE) return;
+    lua_pop(L, 1);
+    lua_newtable(L);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, LUA_REGISTRYINDEX, "raylua.archives");
+}
+
+// Pushes the Lua object of a mounted archive
+static void push_Archive_owner(lua_State *L, const Archive *archive) {
+    push_archive_registry(L);
+    lua_rawgetp(L, -1, archive);
+    lua_remove(L, -2);
+}
+
+static Archive *mount_Archive(lua_State *L, const char *fileName) {
+    Archive *archive = push_object(L, "Archive", sizeof(Archive), 0);
+    *archive = (Archive){ 0 };
+    const char *error = map_Archive(archive, fileName);
+    if (error == NULL) error = validate_Archive(archive);
+    if (error != NULL) {
+        luaL_error(L, "cannot mount archive '%s': %s", fileName, error);
+        return NULL;
+    }
+    if (mounted_archives == NULL) {
+        SetLoadFileDataCallback(archive_LoadFileData);
+        SetLoadFileTextCallback(archive_LoadFileText);
+    }
+    archive->next = mounted_archives;
+    archive->mounted = true;
+    mounted_archives = archive;
+    push_archive_registry(L);
+    lua_pushvalue(L, -2);
+    lua_rawsetp(L, -2, archive);
+    lua_pop(L, 1);
+    return archive;
+}
+
+// A package.searchers entry that loads Lua modules from the mounted archives
+static int archive_searcher(lua_State *L) {
+    const char *name = luaL_checkstring(L, 1);
+    if (mounted_archives == NULL) {
+        lua_pushstring(L, "no mounted archive");
+        return 1;
+    }
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "path");
+    const char *templates = lua_tostring(L, -1);
+    if (templates == NULL) return luaL_error(L, "'package.path' must be a string");
+    name = luaL_gsub(L, name, ".", "/");
+    for (const char *t = templates; *t != '\0'; ) {
+        const char *end = strchr(t, ';');
+        if (end == NULL) end = t + strlen(t);
+        lua_pushlstring(L, t, (size_t)(end - t));
+        const char *fileName = luaL_gsub(L, lua_tostring(L, -1), "?", name);
+        size_t size;
+        const unsigned char *data = find_archive_file(fileName, &size, NULL);
+        if (data != NULL) {
+            lua_pushfstring(L, "@%s", fileName);
+            if (luaL_loadbufferx(L, (const char*)data, size, lua_tostring(L, -1), NULL) != LUA_OK)
+                return luaL_error(L, "error loading module '%s' from archive file '%s':\n\t%s", lua_tostring(L, 1), fileName, lua_tostring(L, -1));
+            lua_pushstring(L, fileName);
+            return 2;
+        }
+        lua_pop(L, 2);
+        t = *end == ';' ? end + 1 : end;
+    }
+    lua_pushfstring(L, "no file '%s' in the mounted archives", lua_tostring(L, 1));
+    return 1;
+}
+
+static void InitArchiveSearcher(lua_State *L) {
+    // insert right after the preload searcher, so archives win over loose files
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchers");
+    for (lua_Integer i = (lua_Integer)lua_rawlen(L, -1); i >= 2; --i) {
+        lua_rawgeti(L, -1, i);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_pushcfunction(L, archive_searcher);
+    lua_rawseti(L, -2, 2);
+    lua_pop(L, 2);
+}
+
+// Loads a Lua chunk from the mounted archives or the disk
+static int load_lua_file(lua_State *L, const char *fileName) {
+    size_t size;
+    const unsigned char *data = find_archive_file(fileName, &size, NULL);
+    if (data == NULL) return luaL_loadfile(L, fileName);
+    lua_pushfstring(L, "@%s", fileName);
+    const int status = luaL_loadbufferx(L, (const char*)data, size, lua_tostring(L, -1), NULL);
+    lua_remove(L, -2);
+    return status;
+}
+
+static int f_MountArchive(lua_State *L) {
+    mount_Archive(L, luaL_checkstring(L, 1));
+    return 1;
+}
+
+static int f_Archive__gc(lua_State *L) {
+    Archive *archive = check_Archive(L, 1);
+    unmount_Archive(archive);
+    if (archive->base != NULL) munmap(archive->base, archive->size);
+    *archive = (Archive){ 0 };
+    return 0;
+}
+
+static int f_Archive__tostring(lua_State *L) {
+    const Archive *archive = check_Archive(L, 1);
+    lua_pushfstring(L, "Archive(count = %d, mounted = %s)", (int)archive->count, archive->mounted ? "true" : "false");
+    return 1;
+}
+
+static int f_Archive_Unmount(lua_State *L) {
+    Archive *archive = check_Archive(L, 1);
+    if (archive->mounted) {
+        unmount_Archive(archive);
+        push_archive_registry(L);
+        lua_pushnil(L);
+        lua_rawsetp(L, -2, archive);
+    }
+    return 0;
+}
+
+static int f_Archive_Has(lua_State *L) {
+    const Archive *archive = check_Archive(L, 1);
+    char path[ARCHIVE_MAX_PATH];
+    const size_t length = normalize_archive_path(luaL_checkstring(L, 2), path);
+    lua_pushboolean(L, archive->base != NULL && length > 0 && find_archive_entry(archive, path, length, hash_archive_path(path, length)) != NULL);
+    return 1;
+}
+
+static int f_Archive_List(lua_State *L) {
+    const Archive *archive = check_Archive(L, 1);
+    lua_createtable(L, (int)archive->count, 0);
+    for (unsigned int i = 0; i < archive->count; ++i) {
+        const unsigned char *entry = archive->entries + (size_t)ARCHIVE_ENTRY_SIZE * i;
+        lua_pushlstring(L, (const char*)archive->base + read_u32(entry + 4), read_u32(entry + 8));
+        lua_rawseti(L, -2, (lua_Integer)i + 1);
+    }
+    return 1;
+}
+
+static int f_Archive_get_count(lua_State *L) {
+    lua_pushinteger(L, check_Archive(L, 1)->count);
+    return 1;
+}
+
+static int f_Archive_get_mounted(lua_State *L) {
+    lua_pushboolean(L, check_Archive(L, 1)->mounted);
+    return 1;
+}
+
+
+//==[[ Async loading ]]=========================================================
+
+// Files are read and decoded on a pool of worker threads, the Lua side gets a
+// Future to poll or wait on. Textures are decoded on the workers and uploaded
+// on the main thread after EndDrawing, limited by a per-frame byte budget.
+
+#define ASYNC_MAX_THREADS 16
+
+typedef enum { ASYNC_IMAGE, ASYNC_TEXTURE, ASYNC_WAVE, ASYNC_FILE_DATA } AsyncKind;
+typedef enum { ASYNC_QUEUED, ASYNC_RUNNING, ASYNC_UPLOAD, ASYNC_DONE } AsyncState;
+
+typedef struct AsyncJob {
+    AsyncKind kind;
+    AsyncState state;
+    // input: either a file read on the worker, or memory anchored by the Future
+    char *fileName;
+    char fileType[16];
+    const unsigned char *data;
+    size_t size;
+    // output, owned by the job until Get() hands it to Lua
+    Image image;
+    Texture texture;
+    Wave wave;
+    unsigned char *bytes;
+    unsigned int byteCount;
+    bool failed;
+    struct AsyncJob *next;
+} AsyncJob;
+
+typedef struct Future {
+    AsyncJob *job;
+} Future;
+
+// A parallel loop over 'count' items, split into tiles the workers and the main thread take in turn
+typedef struct ParallelTask {
+    void (*kernel)(void *context, int first, int last);
+    void *context;
+    int count, grain;
+    int next;       // first item of the next tile
+    int finished;   // number of processed items
+} ParallelTask;
+
+static struct {
+    bool started;
+    bool quit;
+    int threadCount;
+    pthread_t threads[ASYNC_MAX_THREADS];
+    pthread_mutex_t mutex;
+    pthread_cond_t work;    // signalled when a job is queued or the pool quits
+    pthread_cond_t done;    // broadcast when a job leaves the running state
+    AsyncJob *queueHead, *queueTail;
+    AsyncJob *uploadHead, *uploadTail;
+    int uploadBudget;       // bytes of texture data uploaded per frame
+    ParallelTask *task;     // the running parallel loop, if any
+} async_pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .work = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+    .uploadBudget = 8 * 1024 * 1024,
+};
+
+static Future *check_Future(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "Future");
+}
+
+static void append_async_job(AsyncJob **head, AsyncJob **tail, AsyncJob *job) {
+    job->next = NULL;
+    if (*tail != NULL) (*tail)->next = job;
+    else *head = job;
+    *tail = job;
+}
+
+static void remove_async_job(AsyncJob **head, AsyncJob **tail, AsyncJob *job) {
+    AsyncJob *previous = NULL;
+    for (AsyncJob *it = *head; it != NULL; previous = it, it = it->next) {
+        if (it != job) continue;
+        if (previous != NULL) previous->next = job->next;
+        else *head = job->next;
+        if (*tail == job) *tail = previous;
+        job->next = NULL;
+        return;
+    }
+}
+
+static void run_async_job(AsyncJob *job) {
+    unsigned int size = (unsigned int)job->size;
+    unsigned char *bytes = NULL;
+    const unsigned char *data = job->data;
+    if (data == NULL) {
+        data = bytes = load_disk_file(job->fileName, &size, false);
+        if (data == NULL) {
+            job->failed = true;
+            return;
+        }
+    }
+    switch (job->kind) {
+        case ASYNC_IMAGE:
+        case ASYNC_TEXTURE:
+            job->image = size <= INT_MAX ? LoadImageFromMemory(job->fileType, data, (int)size) : (Image){ 0 };
+            job->failed = job->image.data == NULL;
+            break;
+        case ASYNC_WAVE:
+            job->wave = size <= INT_MAX ? LoadWaveFromMemory(job->fileType, data, (int)size) : (Wave){ 0 };
+            job->failed = job->wave.data == NULL;
+            break;
+        case ASYNC_FILE_DATA:
+            if (bytes == NULL) break;   // mapped data is pushed directly by Get()
+            job->bytes = bytes;
+            job->byteCount = size;
+            return;
+    }
+    RL_FREE(bytes);
+}
+
+static bool has_parallel_tiles(void) {
+    return async_pool.task != NULL && async_pool.task->next < async_pool.task->count;
+}
+
+// Processes tiles of the running parallel loop, called and returns with the mutex held
+static void run_parallel_tiles(void) {
+    ParallelTask *task = async_pool.task;
+    while (task->next < task->count) {
+        const int first = task->next;
+        const int last = task->count - first > task->grain ? first + task->grain : task->count;
+        task->next = last;
+        pthread_mutex_unlock(&async_pool.mutex);
+        task->kernel(task->context, first, last);
+        pthread_mutex_lock(&async_pool.mutex);
+        task->finished += last - first;
+        if (task->finished == task->count) pthread_cond_broadcast(&async_pool.done);
+    }
+}
+
+static void *async_worker(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&async_pool.mutex);
+    for (;;) {
+        while (!async_pool.quit && async_pool.queueHead == NULL && !has_parallel_tiles())
+            pthread_cond_wait(&async_pool.work, &async_pool.mutex);
+        // queued jobs are left to the next pool, quit is never set during parallel_for()
+        if (async_pool.quit) break;
+        // parallel loops block the main thread, so they go before queued loads
+        if (has_parallel_tiles()) {
+            run_parallel_tiles();
+            continue;
+        }
+        AsyncJob *job = async_pool.queueHead;
+        if (job == NULL) break;
+        remove_async_job(&async_pool.queueHead, &async_pool.queueTail, job);
+        job->state = ASYNC_RUNNING;
+        pthread_mutex_unlock(&async_pool.mutex);
+        run_async_job(job);
+        pthread_mutex_lock(&async_pool.mutex);
+        if (job->kind == ASYNC_TEXTURE && !job->failed) {
+            job->state = ASYNC_UPLOAD;
+            append_async_job(&async_pool.uploadHead, &async_pool.uploadTail, job);
+        } else {
+            job->state = ASYNC_DONE;
+        }
+        pthread_cond_broadcast(&async_pool.done);
+    }
+    pthread_mutex_unlock(&async_pool.mutex);
+    return NULL;
+}
+
+static int default_thread_count(void) {
+    // leave one core to the main thread
+    const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores <= 2) return 1;
+    return cores - 1 < ASYNC_MAX_THREADS ? (int)cores - 1 : ASYNC_MAX_THREADS;
+}
+
+static void start_async_pool(lua_State *L) {
+    if (async_pool.started) return;
+    if (async_pool.threadCount <= 0) async_pool.threadCount = default_thread_count();
+    async_pool.quit = false;
+    for (int i = 0; i < async_pool.threadCount; ++i) {
+        if (pthread_create(&async_pool.threads[i], NULL, async_worker, NULL) != 0) {
+            if (i == 0) luaL_error(L, "cannot start loader threads");
+            async_pool.threadCount = i;
+            break;
+        }
+    }
+    async_pool.started = true;
+}
+
+// Stops the worker threads after their running jobs, queued jobs stay queued
+static void ReleaseAsyncPool(void) {
+    if (!async_pool.started) return;
+    pthread_mutex_lock(&async_pool.mutex);
+    async_pool.quit = true;
+    pthread_cond_broadcast(&async_pool.work);
+    pthread_mutex_unlock(&async_pool.mutex);
+    for (int i = 0; i < async_pool.threadCount; ++i)
+        pthread_join(async_pool.threads[i], NULL);
+    async_pool.started = false;
+}
+
+// Runs kernel over [0, count) on the worker threads and the calling thread. Loops
+// with less than 'minWork' work units (count * cost) run inline.
+static void parallel_for(lua_State *L, void (*kernel)(void*, int, int), void *context, const int count, const long long cost) {
+    static const long long minWork = 1 << 16;
+    if (count <= 0) return;
+    if (count < 2 || (long long)count * cost < minWork) {
+        kernel(context, 0, count);
+        return;
+    }
+    start_async_pool(L);
+    // a few tiles per thread balance uneven progress without much locking
+    const int tiles = (async_pool.threadCount + 1) * 4;
+    ParallelTask task = { .kernel = kernel, .context = context, .count = count, .grain = count > tiles ? count / tiles : 1 };
+    pthread_mutex_lock(&async_pool.mutex);
+    async_pool.task = &task;
+    pthread_cond_broadcast(&async_pool.work);
+    run_parallel_tiles();
+    while (task.finished < task.count)
+        pthread_cond_wait(&async_pool.done, &async_pool.mutex);
+    async_pool.task = NULL;
+    pthread_mutex_unlock(&async_pool.mutex);
+}
+
+static int f_SetWorkerThreadCount(lua_State *L) {
+    const lua_Integer count = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, count >= 0 && count <= ASYNC_MAX_THREADS, 1, "invalid thread count");
+    // 0 selects one thread per core minus one
+    // restart the pool with the new size, queued loads are kept
+    const bool started = async_pool.started;
+    ReleaseAsyncPool();
+    async_pool.threadCount = count > 0 ? (int)count : default_thread_count();
+    if (started) start_async_pool(L);
+    return 0;
+}
+
+static int f_GetWorkerThreadCount(lua_State *L) {
+    lua_pushinteger(L, async_pool.threadCount > 0 ? async_pool.threadCount : default_thread_count());
+    return 1;
+}
+
+static void upload_async_job(AsyncJob *job) {
+    job->texture = LoadTextureFromImage(job->image);
+    UnloadImage(job->image);
+    job->image = (Image){ 0 };
+    job->failed = job->texture.id == 0;
+    job->state = ASYNC_DONE;
+}
+
+// Uploads decoded textures until the frame's byte budget is spent, called after EndDrawing
+static void ProcessAsyncUploads(void) {
+    if (!async_pool.started) return;
+    int spent = 0;
+    for (;;) {
+        pthread_mutex_lock(&async_pool.mutex);
+        AsyncJob *job = async_pool.uploadHead;
+        // always upload at least one texture per frame, so big ones make progress
+        if (job != NULL && (spent == 0 || spent < async_pool.uploadBudget))
+            remove_async_job(&async_pool.uploadHead, &async_pool.uploadTail, job);
+        else
+            job = NULL;
+        pthread_mutex_unlock(&async_pool.mutex);
+        if (job == NULL) break;
+        spent += GetPixelDataSize(job->image.width, job->image.height, job->image.format);
+        upload_async_job(job);
+    }
+}
+
+// Blocks until the job is decoded, textures are uploaded right away
+static void wait_async_job(AsyncJob *job) {
+    pthread_mutex_lock(&async_pool.mutex);
+    while (job->state == ASYNC_QUEUED || job->state == ASYNC_RUNNING)
+        pthread_cond_wait(&async_pool.done, &async_pool.mutex);
+    const bool upload = job->state == ASYNC_UPLOAD;
+    if (upload) remove_async_job(&async_pool.uploadHead, &async_pool.uploadTail, job);
+    pthread_mutex_unlock(&async_pool.mutex);
+    if (upload) upload_async_job(job);
+}
+
+static AsyncState get_async_state(const AsyncJob *job) {
+    pthread_mutex_lock(&async_pool.mutex);
+    const AsyncState state = job->state;
+    pthread_mutex_unlock(&async_pool.mutex);
+    return state;
+}
+
+// Creates a Future for a file, which is served from a mounted archive if possible
+static AsyncJob *push_Future(lua_State *L, const AsyncKind kind, const char *fileName) {
+    Future *future = push_object(L, "Future", sizeof(Future), 2);
+    future->job = calloc(1, sizeof(AsyncJob));
+    if (future->job == NULL) luaL_error(L, "out of memory");
+    AsyncJob *job = future->job;
+    job->kind = kind;
+    job->state = ASYNC_DONE;
+    if (fileName != NULL) {
+        const char *ext = GetFileExtension(fileName);
+        if (ext != NULL && strlen(ext) < sizeof(job->fileType)) strcpy(job->fileType, ext);
+        Archive *archive;
+        job->data = find_archive_file(fileName, &job->size, &archive);
+        if (job->data != NULL) {
+            push_Archive_owner(L, archive);
+            lua_setiuservalue(L, -2, 1);
+        } else {
+            job->fileName = malloc(strlen(fileName) + 1);
+            if (job->fileName == NULL) luaL_error(L, "out of memory");
+            strcpy(job->fileName, fileName);
+        }
+    }
+    return job;
+}
+
+// Same for data in a Lua string at idx
+static AsyncJob *push_Future_String(lua_State *L, const AsyncKind kind, const int idx) {
+    const char *type = luaL_checkstring(L, idx);
+    luaL_checktype(L, idx + 1, LUA_TSTRING);
+    AsyncJob *job = push_Future(L, kind, NULL);
+    luaL_argcheck(L, strlen(type) < sizeof(job->fileType), idx, "invalid file type");
+    strcpy(job->fileType, type);
+    job->data = (const unsigned char*)lua_tolstring(L, idx + 1, &job->size);
+    lua_pushvalue(L, idx + 1);
+    lua_setiuservalue(L, -2, 1);
+    return job;
+}
+
+static int queue_Future(lua_State *L, AsyncJob *job) {
+    start_async_pool(L);
+    pthread_mutex_lock(&async_pool.mutex);
+    job->state = ASYNC_QUEUED;
+    append_async_job(&async_pool.queueHead, &async_pool.queueTail, job);
+    pthread_cond_signal(&async_pool.work);
+    pthread_mutex_unlock(&async_pool.mutex);
+    return 1;
+}
+
+static int f_LoadImageAsync(lua_State *L) {
+    return queue_Future(L, push_Future(L, ASYNC_IMAGE, luaL_checkstring(L, 1)));
+}
+
+static int f_LoadImageFromStringAsync(lua_State *L) {
+    return queue_Future(L, push_Future_String(L, ASYNC_IMAGE, 1));
+}
+
+static int f_LoadTextureAsync(lua_State *L) {
+    return queue_Future(L, push_Future(L, ASYNC_TEXTURE, luaL_checkstring(L, 1)));
+}
+
+static int f_LoadWaveAsync(lua_State *L) {
+    return queue_Future(L, push_Future(L, ASYNC_WAVE, luaL_checkstring(L, 1)));
+}
+
+static int f_LoadWaveFromStringAsync(lua_State *L) {
+    return queue_Future(L, push_Future_String(L, ASYNC_WAVE, 1));
+}
+
+static int f_LoadFileDataAsync(lua_State *L) {
+    return queue_Future(L, push_Future(L, ASYNC_FILE_DATA, luaL_checkstring(L, 1)));
+}
+
+static int f_SetAsyncUploadBudget(lua_State *L) {
+    const lua_Integer budget = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, budget >= 0, 1, "negative budget");
+    async_pool.uploadBudget = budget < INT_MAX ? (int)budget : INT_MAX;
+    return 0;
+}
+
+static int f_Future__gc(lua_State *L) {
+    Future *future = check_Future(L, 1);
+    AsyncJob *job = future->job;
+    if (job == NULL) return 0;
+    // the job may not outlive the anchored input, so take it back from the pool first
+    pthread_mutex_lock(&async_pool.mutex);
+    while (job->state == ASYNC_RUNNING)
+        pthread_cond_wait(&async_pool.done, &async_pool.mutex);
+    if (job->state == ASYNC_QUEUED) remove_async_job(&async_pool.queueHead, &async_pool.queueTail, job);
+    if (job->state == ASYNC_UPLOAD) remove_async_job(&async_pool.uploadHead, &async_pool.uploadTail, job);
+    pthread_mutex_unlock(&async_pool.mutex);
+    if (job->image.data != NULL) UnloadImage(job->image);
+    if (job->texture.id != 0) UnloadTexture(job->texture);
+    if (job->wave.data != NULL) UnloadWave(job->wave);
+    RL_FREE(job->bytes);
+    free(job->fileName);
+    free(job);
+    future->job = NULL;
+    return 0;
+}
+
+static int f_Future__tostring(lua_State *L) {
+    const Future *future = check_Future(L, 1);
+    static const char *const states[] = { "queued", "running", "uploading", "done" };
+    lua_pushfstring(L, "Future(%s)", future->job != NULL ? states[get_async_state(future->job)] : "released");
+    return 1;
+}
+
+// Pushes the result of a finished job, handing ownership to the Lua object
+static int push_Future_result(lua_State *L, AsyncJob *job) {
+    if (lua_getiuservalue(L, 1, 2) != LUA_TNIL) return 1;
+    lua_pop(L, 1);
+    switch (job->kind) {
+        case ASYNC_IMAGE: push_Image(L, job->image); job->image = (Image){ 0 }; break;
+        case ASYNC_TEXTURE: push_Texture(L, job->texture); job->texture = (Texture){ 0 }; break;
+        case ASYNC_WAVE: push_Wave(L, job->wave); job->wave = (Wave){ 0 }; break;
+        case ASYNC_FILE_DATA:
+            if (job->bytes != NULL) lua_pushlstring(L, (const char*)job->bytes, job->byteCount);
+            else if (job->data != NULL) lua_pushlstring(L, (const char*)job->data, job->size);
+            else lua_pushliteral(L, "");
+            RL_FREE(job->bytes);
+            job->bytes = NULL;
+            break;
+    }
+    lua_pushvalue(L, -1);
+    lua_setiuservalue(L, 1, 2);
+    return 1;
+}
+
+static int f_Future_IsDone(lua_State *L) {
+    const Future *future = check_Future(L, 1);
+    lua_pushboolean(L, future->job != NULL && get_async_state(future->job) == ASYNC_DONE);
+    return 1;
+}
+
+static int f_Future_Get(lua_State *L) {
+    Future *future = check_Future(L, 1);
+    if (future->job == NULL || get_async_state(future->job) != ASYNC_DONE) return 0;
+    return push_Future_result(L, future->job);
+}
+
+static int f_Future_Wait(lua_State *L) {
+    Future *future = check_Future(L, 1);
+    luaL_argcheck(L, future->job != NULL, 1, "Future has been released");
+    wait_async_job(future->job);
+    return push_Future_result(L, future->job);
+}
+
+static int f_Future_get_failed(lua_State *L) {
+    const Future *future = check_Future(L, 1);
+    lua_pushboolean(L, future->job != NULL && get_async_state(future->job) == ASYNC_DONE && future->job->failed);
+    return 1;
+}
+
+
+//==[[ TextureAtlas object ]]===================================================
+
+// Packs many Images into a few texture pages with a skyline bottom-left packer.
+// AtlasRegion handles reference a rectangle of a page and are accepted by the
+// DrawTexture* functions in place of a Texture. A built atlas can be saved to a
+// cache file and loaded back later without packing again.
+//
+// Cache layout (little endian):
+//   header  "RLAT", u32 version, u32 pageWidth, u32 pageHeight, u32 pageCount, u32 count, u32 keyLength, key
+//   entries count x { u32 nameLength, name, u32 page, u32 x, u32 y, u32 width, u32 height }
+//   pages   pageCount x pageWidth * pageHeight RGBA8 pixels
+
+#define ATLAS_VERSION 1
+
+typedef struct AtlasEntry {
+    Rectangle source;
+    int page;
+} AtlasEntry;
+
+// uservalues: 1 = name -> index, 2 = index -> name, 3 = index -> Image until built, 4 = page Textures
+typedef struct TextureAtlas {
+    int pageWidth, pageHeight;
+    int padding;
+    int count, capacity;
+    AtlasEntry *entries;
+    int pageCount;
+    bool built;
+} TextureAtlas;
+
+// uservalue 1 = page Texture
+typedef struct AtlasRegion {
+    Texture texture;
+    Rectangle source;
+} AtlasRegion;
+
+typedef struct SkylineNode {
+    int x, y, width;
+} SkylineNode;
+
+typedef struct AtlasPage {
+    int count;
+    SkylineNode *nodes;     // room for one node per packed image plus one
+    unsigned char *pixels;
+} AtlasPage;
+
+typedef struct AtlasItem {
+    int index;
+    int width, height;
+} AtlasItem;
+
+static TextureAtlas *check_TextureAtlas(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "TextureAtlas");
+}
+
+static AtlasRegion *check_AtlasRegion(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "AtlasRegion");
+}
+
+// Returns the Texture or the page of the AtlasRegion at idx, 'region' is set to the region's rectangle or NULL
+static const Texture *check_Texture_Region(lua_State *L, const int idx, const Rectangle **region) {
+    const AtlasRegion *atlas_region = luaL_testudata(L, idx, "AtlasRegion");
+    if (atlas_region != NULL) {
+        *region = &atlas_region->source;
+        return &atlas_region->texture;
+    }
+    *region = NULL;
+    return check_Texture(L, idx);
+}
+
+// Returns the y position for an item at skyline node 'index' or -1 if it does not fit
+static int fit_skyline(const AtlasPage *page, const int index, const int width, const int height, const int pageWidth, const int pageHeight) {
+    if (page->nodes[index].x + width > pageWidth) return -1;
+    int y = 0;
+    for (int i = index, left = width; left > 0 && i < page->count; ++i) {
+        if (page->nodes[i].y > y) y = page->nodes[i].y;
+        left -= page->nodes[i].width;
+    }
+    return y + height <= pageHeight ? y : -1;
+}
+
+static void remove_skyline_node(AtlasPage *page, const int index) {
+    memmove(&page->nodes[index], &page->nodes[index + 1], sizeof(SkylineNode) * (size_t)(page->count - index - 1));
+    page->count--;
+}
+
+static bool insert_skyline(AtlasPage *page, const int width, const int height, const int pageWidth, const int pageHeight, int *x, int *y) {
+    int best = -1, bestBottom = INT_MAX, bestWidth = INT_MAX;
+    for (int i = 0; i < page->count; ++i) {
+        const int top = fit_skyline(page, i, width, height, pageWidth, pageHeight);
+        if (top < 0) continue;
+        // lowest bottom edge first, then the narrowest node to keep wide gaps for wide items
+        if (top + height < bestBottom || (top + height == bestBottom && page->nodes[i].width < bestWidth)) {
+            best = i;
+            bestBottom = top + height;
+            bestWidth = page->nodes[i].width;
+        }
+    }
+    if (best < 0) return false;
+    *x = page->nodes[best].x;
+    *y = bestBottom - height;
+    memmove(&page->nodes[best + 1], &page->nodes[best], sizeof(SkylineNode) * (size_t)(page->count - best));
+    page->nodes[best] = (SkylineNode){ *x, bestBottom, width };
+    page->count++;
+    // cut the nodes now below the new one
+    const int end = *x + width;
+    for (int i = best + 1; i < page->count && page->nodes[i].x < end; ) {
+        SkylineNode *node = &page->nodes[i];
+        if (node->x + node->width <= end) {
+            remove_skyline_node(page, i);
+            continue;
+        }
+        node->width -= end - node->x;
+        node->x = end;
+        break;
+    }
+    // and merge neighbours of the same height
+    for (int i = 0; i + 1 < page->count; ) {
+        if (page->nodes[i].y == page->nodes[i + 1].y) {
+            page->nodes[i].width += page->nodes[i + 1].width;
+            remove_skyline_node(page, i + 1);
+        } else {
+            ++i;
+        }
+    }
+    return true;
+}
+
+static int compare_AtlasItem(const void *a, const void *b) {
+    // tallest first, then widest, then insertion order to stay deterministic
+    const AtlasItem *ia = a, *ib = b;
+    if (ia->height != ib->height) return ib->height - ia->height;
+    if (ia->width != ib->width) return ib->width - ia->width;
+    return ia->index - ib->index;
+}
+
+static void copy_atlas_image(const TextureAtlas *atlas, AtlasPage *page, const Image *image, const int x, const int y) {
+    Color *colors = image->format == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 ? image->data : LoadImageColors(*image);
+    if (colors == NULL) return;
+    for (int row = 0; row < image->height; ++row)
+        memcpy(page->pixels + 4 * ((size_t)(y + row) * (size_t)atlas->pageWidth + (size_t)x), &colors[(size_t)row * (size_t)image->width], 4 * (size_t)image->width);
+    if (colors != image->data) UnloadImageColors(colors);
+}
+
+static void free_atlas_pages(AtlasPage *pages, const int count) {
+    for (int i = 0; i < count; ++i) {
+        free(pages[i].nodes);
+        free(pages[i].pixels);
+    }
+    free(pages);
+}
+
+// Packs the images into pages, returns the number of pages or -1 when out of memory
+static int pack_TextureAtlas(TextureAtlas *atlas, Image **images, AtlasPage **out) {
+    AtlasItem *items = malloc(sizeof(AtlasItem) * (size_t)atlas->count);
+    AtlasPage *pages = calloc((size_t)atlas->count, sizeof(AtlasPage));
+    int pageCount = 0;
+    if (items == NULL || pages == NULL) goto fail;
+    for (int i = 0; i < atlas->count; ++i) {
+        // the padding is kept right and below each image, clipped at the page border
+        const int width = images[i]->width + atlas->padding, height = images[i]->height + atlas->padding;
+        items[i] = (AtlasItem){ i, width < atlas->pageWidth ? width : atlas->pageWidth, height < atlas->pageHeight ? height : atlas->pageHeight };
+    }
+    qsort(items, (size_t)atlas->count, sizeof(AtlasItem), compare_AtlasItem);
+    for (int i = 0; i < atlas->count; ++i) {
+        const AtlasItem *item = &items[i];
+        int x = 0, y = 0, p = 0;
+        while (p < pageCount && !insert_skyline(&pages[p], item->width, item->height, atlas->pageWidth, atlas->pageHeight, &x, &y)) ++p;
+        if (p == pageCount) {
+            AtlasPage *page = &pages[pageCount++];
+            page->nodes = malloc(sizeof(SkylineNode) * (size_t)(atlas->count + 1));
+            page->pixels = calloc((size_t)atlas->pageWidth * (size_t)atlas->pageHeight, 4);
+            if (page->nodes == NULL || page->pixels == NULL) goto fail;
+            page->nodes[0] = (SkylineNode){ 0, 0, atlas->pageWidth };
+            page->count = 1;
+            insert_skyline(page, item->width, item->height, atlas->pageWidth, atlas->pageHeight, &x, &y);
+        }
+        const Image *image = images[item->index];
+        atlas->entries[item->index] = (AtlasEntry){ { (float)x, (float)y, (float)image->width, (float)image->height }, p };
+        copy_atlas_image(atlas, &pages[p], image, x, y);
+    }
+    free(items);
+    *out = pages;
+    return pageCount;
+fail:
+    free(items);
+    if (pages != NULL) free_atlas_pages(pages, pageCount);
+    return -1;
+}
+
+// Creates the page Textures from RGBA8 pixels and stores them in uservalue 4 of the atlas at idx
+static void upload_atlas_page(lua_State *L, const int idx, const TextureAtlas *atlas, const int page, void *pixels) {
+    const Image image = { .data = pixels, .width = atlas->pageWidth, .height = atlas->pageHeight, .mipmaps = 1, .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    lua_getiuservalue(L, idx, 4);
+    push_Texture(L, LoadTextureFromImage(image));
+    lua_rawseti(L, -2, page + 1);
+    lua_pop(L, 1);
+}
+
+static TextureAtlas *push_TextureAtlas(lua_State *L, const int pageWidth, const int pageHeight, const int padding) {
+    TextureAtlas *atlas = push_object(L, "TextureAtlas", sizeof(TextureAtlas), 4);
+    *atlas = (TextureAtlas){ .pageWidth = pageWidth, .pageHeight = pageHeight, .padding = padding };
+    for (int i = 1; i <= 4; ++i) {
+        lua_newtable(L);
+        lua_setiuservalue(L, -2, i);
+    }
+    return atlas;
+}
+
+// Adds an entry, the name is at idx; returns its index
+static int add_AtlasEntry(lua_State *L, TextureAtlas *atlas, const int atlasIdx, const int idx) {
+    lua_getiuservalue(L, atlasIdx, 1);
+    lua_pushvalue(L, idx);
+    if (lua_rawget(L, -2) != LUA_TNIL) luaL_error(L, "duplicate atlas entry '%s'", lua_tostring(L, idx));
+    lua_pop(L, 1);
+    if (atlas->count == atlas->capacity) {
+        if (atlas->capacity > INT_MAX / 2 / (int)sizeof(AtlasEntry)) luaL_error(L, "TextureAtlas too large");
+        const int capacity = atlas->capacity > 0 ? atlas->capacity * 2 : 64;
+        AtlasEntry *entries = realloc(atlas->entries, sizeof(AtlasEntry) * (size_t)capacity);
+        if (entries == NULL) luaL_error(L, "out of memory");
+        atlas->entries = entries;
+        atlas->capacity = capacity;
+    }
+    const int index = atlas->count++;
+    atlas->entries[index] = (AtlasEntry){ 0 };
+    lua_pushvalue(L, idx);
+    lua_pushinteger(L, index + 1);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+    lua_getiuservalue(L, atlasIdx, 2);
+    lua_pushvalue(L, idx);
+    lua_rawseti(L, -2, index + 1);
+    lua_pop(L, 1);
+    return index;
+}
+
+static int f_TextureAtlas(lua_State *L) {
+    const lua_Integer pageWidth = luaL_checkinteger(L, 1), pageHeight = luaL_checkinteger(L, 2);
+    const lua_Integer padding = luaL_optinteger(L, 3, 1);
+    luaL_argcheck(L, pageWidth > 0 && pageWidth <= 16384, 1, "invalid page width");
+    luaL_argcheck(L, pageHeight > 0 && pageHeight <= 16384, 2, "invalid page height");
+    luaL_argcheck(L, padding >= 0 && padding <= 256, 3, "invalid padding");
+    push_TextureAtlas(L, (int)pageWidth, (int)pageHeight, (int)padding);
+    return 1;
+}
+
+static int f_TextureAtlas__gc(lua_State *L) {
+    TextureAtlas *atlas = check_TextureAtlas(L, 1);
+    free(atlas->entries);
+    atlas->entries = NULL;
+    atlas->count = atlas->capacity = 0;
+    return 0;
+}
+
+static int f_TextureAtlas__tostring(lua_State *L) {
+    const TextureAtlas *atlas = check_TextureAtlas(L, 1);
+    lua_pushfstring(L, "TextureAtlas(count = %d, pages = %d)", atlas->count, atlas->pageCount);
+    return 1;
+}
+
+static int f_TextureAtlas_Add(lua_State *L) {
+    TextureAtlas *atlas = check_TextureAtlas(L, 1);
+    luaL_checktype(L, 2, LUA_TSTRING);
+    const Image *image = check_Image(L, 3);
+    luaL_argcheck(L, !atlas->built, 1, "atlas already built");
+    luaL_argcheck(L, image->data != NULL && image->width > 0 && image->height > 0, 3, "empty image");
+    luaL_argcheck(L, image->width <= atlas->pageWidth && image->height <= atlas->pageHeight, 3, "image larger than an atlas page");
+    const int index = add_AtlasEntry(L, atlas, 1, 2);
+    lua_getiuservalue(L, 1, 3);
+    lua_pushvalue(L, 3);
+    lua_rawseti(L, -2, index + 1);
+    return 0;
+}
+
+static int f_TextureAtlas_Build(lua_State *L) {
+    TextureAtlas *atlas = check_TextureAtlas(L, 1);
+    luaL_argcheck(L, !atlas->built, 1, "atlas already built");
+    Image **images = lua_newuserdatauv(L, sizeof(Image*) * (size_t)(atlas->count > 0 ? atlas->count : 1), 0);
+    lua_getiuservalue(L, 1, 3);
+    for (int i = 0; i < atlas->count; ++i) {
+        lua_rawgeti(L, -1, i + 1);
+        images[i] = lua_touserdata(L, -1);
+        lua_pop(L, 1);
+        // Add checked the image, but it may have been resized or unloaded since
+        const Image *image = images[i];
+        if (image->data == NULL || image->width <= 0 || image->height <= 0 || image->width > atlas->pageWidth || image->height > atlas->pageHeight) {
+            lua_getiuservalue(L, 1, 2);
+            lua_rawgeti(L, -1, i + 1);
+            return luaL_error(L, "atlas image '%s' is empty or larger than an atlas page", lua_tostring(L, -1));
+        }
+    }
+    AtlasPage *pages = NULL;
+    const int pageCount = atlas->count > 0 ? pack_TextureAtlas(atlas, images, &pages) : 0;
+    if (pageCount < 0) return luaL_error(L, "out of memory");
+    atlas->pageCount = pageCount;
+    atlas->built = true;
+    for (int p = 0; p < pageCount; ++p) {
+        upload_atlas_page(L, 1, atlas, p, pages[p].pixels);
+        free(pages[p].pixels);
+        pages[p].pixels = NULL;
+    }
+    free_atlas_pages(pages, pageCount);
+    // the source images are no longer needed
+    lua_newtable(L);
+    lua_setiuservalue(L, 1, 3);
+    lua_pushinteger(L, pageCount);
+    return 1;
+}
+
+static int f_TextureAtlas_Get(lua_State *L) {
+    const TextureAtlas *atlas = check_TextureAtlas(L, 1);
+    luaL_checktype(L, 2, LUA_TSTRING);
+    luaL_argcheck(L, atlas->built, 1, "atlas not built");
+    lua_getiuservalue(L, 1, 1);
+    lua_pushvalue(L, 2);
+    if (lua_rawget(L, -2) == LUA_TNIL) return 0;
+    const AtlasEntry *entry = &atlas->entries[lua_tointeger(L, -1) - 1];
+    lua_getiuservalue(L, 1, 4);
+    lua_rawgeti(L, -1, entry->page + 1);
+    AtlasRegion *region = push_object(L, "AtlasRegion", sizeof(AtlasRegion), 1);
+    region->texture = *check_Texture(L, -2);
+    region->source = entry->source;
+    lua_pushvalue(L, -2);
+    lua_setiuservalue(L, -2, 1);
+    return 1;
+}
+
+static int f_TextureAtlas_GetPage(lua_State *L) {
+    const TextureAtlas *atlas = check_TextureAtlas(L, 1);
+    const lua_Integer page = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, page >= 1 && page <= atlas->pageCount, 2, "index out of range");
+    lua_getiuservalue(L, 1, 4);
+    lua_rawgeti(L, -1, page);
+    return 1;
+}
+
+static bool write_u32(FILE *fp, const unsigned int value) {
+    const unsigned char bytes[4] = { value & 0xff, (value >> 8) & 0xff, (value >> 16) & 0xff, value >> 24 };
+    return fwrite(bytes, 1, 4, fp) == 4;
+}
+
+static int f_TextureAtlas_Save(lua_State *L) {
+    const TextureAtlas *atlas = check_TextureAtlas(L, 1);
+    const char *fileName = luaL_checkstring(L, 2);
+    size_t keyLength = 0;
+    const char *key = luaL_optlstring(L, 3, "", &keyLength);
+    luaL_argcheck(L, atlas->built, 1, "atlas not built");
+    FILE *fp = fopen(fileName, "wb");
+    if (fp == NULL) {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+    bool ok = fwrite("RLAT", 1, 4, fp) == 4 && write_u32(fp, ATLAS_VERSION)
+        && write_u32(fp, (unsigned int)atlas->pageWidth) && write_u32(fp, (unsigned int)atlas->pageHeight)
+        && write_u32(fp, (unsigned int)atlas->pageCount) && write_u32(fp, (unsigned int)atlas->count)
+        && write_u32(fp, (unsigned int)keyLength) && fwrite(key, 1, keyLength, fp) == keyLength;
+    lua_getiuservalue(L, 1, 2);
+    for (int i = 0; ok && i < atlas->count; ++i) {
+        const AtlasEntry *entry = &atlas->entries[i];
+        size_t length;
+        lua_rawgeti(L, -1, i + 1);
+        const char *name = lua_tolstring(L, -1, &length);
+        ok = write_u32(fp, (unsigned int)length) && fwrite(name, 1, length, fp) == length && write_u32(fp, (unsigned int)entry->page)
+            && write_u32(fp, (unsigned int)entry->source.x) && write_u32(fp, (unsigned int)entry->source.y)
+            && write_u32(fp, (unsigned int)entry->source.width) && write_u32(fp, (unsigned int)entry->source.height);
+        lua_pop(L, 1);
+    }
+    // read the pages back from the GPU, which keeps no CPU copy around after Build
+    lua_getiuservalue(L, 1, 4);
+    for (int p = 0; ok && p < atlas->pageCount; ++p) {
+        lua_rawgeti(L, -1, p + 1);
+        Image image = LoadImageFromTexture(*check_Texture(L, -1));
+        const size_t size = (size_t)atlas->pageWidth * (size_t)atlas->pageHeight * 4;
+        ok = image.data != NULL && image.format == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+            && image.width == atlas->pageWidth && image.height == atlas->pageHeight && fwrite(image.data, 1, size, fp) == size;
+        UnloadImage(image);
+        lua_pop(L, 1);
+    }
+    lua_pushboolean(L, fclose(fp) == 0 && ok);
+    return 1;
+}
+
+static int f_TextureAtlas__len(lua_State *L) {
+    lua_pushinteger(L, check_TextureAtlas(L, 1)->count);
+    return 1;
+}
+
+static int f_TextureAtlas_get_pageCount(lua_State *L) {
+    lua_pushinteger(L, check_TextureAtlas(L, 1)->pageCount);
     return 1;
 }
 
-static int f_Camera2D__index(lua_State *L) {
-    return push_index(L, "Camera2D");
+static int f_TextureAtlas_get_built(lua_State *L) {
+    lua_pushboolean(L, check_TextureAtlas(L, 1)->built);
+    return 1;
 }
 
-static int f_Camera2D__newindex(lua_State *L) {
-    return push_newindex(L, "Camera2D");
+typedef struct AtlasReader {
+    const unsigned char *p, *end;
+} AtlasReader;
+
+static bool read_atlas_bytes(AtlasReader *reader, const size_t size, const unsigned char **bytes) {
+    if ((size_t)(reader->end - reader->p) < size) return false;
+    *bytes = reader->p;
+    reader->p += size;
+    return true;
 }
 
-static int f_Camera2D_get_offset(lua_State *L) {
-    return push_Vector2_Ref(L, &check_Camera2D(L, 1)->offset);
+static bool read_atlas_u32(AtlasReader *reader, unsigned int *value) {
+    const unsigned char *bytes;
+    if (!read_atlas_bytes(reader, 4, &bytes)) return false;
+    *value = read_u32(bytes);
+    return true;
 }
 
-static int f_Camera2D_set_offset(lua_State *L) {
-    check_Camera2D(L, 1)->offset = *check_Vector2(L, 2);
-    return 0;
+// Builds an atlas from cache data, leaves it on the stack or returns false if the data is invalid or the key differs
+static bool load_TextureAtlas(lua_State *L, const unsigned char *data, const size_t size, const char *key, const size_t keyLength) {
+    AtlasReader reader = { data, data + size };
+    const unsigned char *magic, *fileKey;
+    unsigned int version, pageWidth, pageHeight, pageCount, count, fileKeyLength;
+    if (!read_atlas_bytes(&reader, 4, &magic) || memcmp(magic, "RLAT", 4) != 0) return false;
+    if (!read_atlas_u32(&reader, &version) || version != ATLAS_VERSION) return false;
+    if (!read_atlas_u32(&reader, &pageWidth) || !read_atlas_u32(&reader, &pageHeight) || !read_atlas_u32(&reader, &pageCount)
+        || !read_atlas_u32(&reader, &count) || !read_atlas_u32(&reader, &fileKeyLength)) return false;
+    if (pageWidth == 0 || pageWidth > 16384 || pageHeight == 0 || pageHeight > 16384 || count > INT_MAX / 2 / sizeof(AtlasEntry)) return false;
+    if (!read_atlas_bytes(&reader, fileKeyLength, &fileKey) || fileKeyLength != keyLength || memcmp(fileKey, key, keyLength) != 0) return false;
+    const size_t pageSize = (size_t)pageWidth * pageHeight * 4;
+    if (pageCount > size / pageSize) return false;
+    const int atlasIdx = lua_gettop(L) + 1;
+    TextureAtlas *atlas = push_TextureAtlas(L, (int)pageWidth, (int)pageHeight, 0);
+    for (unsigned int i = 0; i < count; ++i) {
+        const unsigned char *name;
+        unsigned int nameLength, page, rect[4];
+        if (!read_atlas_u32(&reader, &nameLength) || !read_atlas_bytes(&reader, nameLength, &name) || !read_atlas_u32(&reader, &page)) break;
+        if (!read_atlas_u32(&reader, &rect[0]) || !read_atlas_u32(&reader, &rect[1]) || !read_atlas_u32(&reader, &rect[2]) || !read_atlas_u32(&reader, &rect[3])) break;
+        if (page >= pageCount || rect[0] > pageWidth || rect[2] > pageWidth - rect[0] || rect[1] > pageHeight || rect[3] > pageHeight - rect[1]) break;
+        lua_pushlstring(L, (const char*)name, nameLength);
+        const int index = add_AtlasEntry(L, atlas, atlasIdx, lua_gettop(L));
+        lua_pop(L, 1);
+        atlas->entries[index] = (AtlasEntry){ { (float)rect[0], (float)rect[1], (float)rect[2], (float)rect[3] }, (int)page };
+    }
+    if ((unsigned int)atlas->count != count || (size_t)(reader.end - reader.p) < pageSize * pageCount) {
+        lua_settop(L, atlasIdx - 1);
+        return false;
+    }
+    for (unsigned int p = 0; p < pageCount; ++p)
+        upload_atlas_page(L, atlasIdx, atlas, (int)p, (void*)(reader.p + pageSize * p));
+    atlas->pageCount = (int)pageCount;
+    atlas->built = true;
+    return true;
+}
+
+static int f_LoadTextureAtlas(lua_State *L) {
+    const char *fileName = luaL_checkstring(L, 1);
+    size_t keyLength = 0;
+    const char *key = luaL_optlstring(L, 2, "", &keyLength);
+    size_t size;
+    const unsigned char *mapped = find_archive_file(fileName, &size, NULL);
+    if (mapped != NULL) return load_TextureAtlas(L, mapped, size, key, keyLength) ? 1 : 0;
+    if (!FileExists(fileName)) return 0;
+    unsigned int length = 0;
+    unsigned char *data = LoadFileData(fileName, &length);
+    if (data == NULL) return 0;
+    // keep the file data in a Lua string so errors while loading do not leak it
+    lua_pushlstring(L, (const char*)data, length);
+    UnloadFileData(data);
+    const unsigned char *bytes = (const unsigned char*)lua_tostring(L, -1);
+    return load_TextureAtlas(L, bytes, length, key, keyLength) ? 1 : 0;
 }
 
-static int f_Camera2D_get_target(lua_State *L) {
-    return push_Vector2_Ref(L, &check_Camera2D(L, 1)->target);
+static int f_AtlasRegion__tostring(lua_State *L) {
+    const AtlasRegion *region = check_AtlasRegion(L, 1);
+    lua_pushfstring(L, "AtlasRegion(texture = %d, x = %d, y = %d, width = %d, height = %d)", region->texture.id,
+        (int)region->source.x, (int)region->source.y, (int)region->source.width, (int)region->source.height);
+    return 1;
 }
 
-static int f_Camera2D_set_target(lua_State *L) {
-    check_Camera2D(L, 1)->target = *check_Vector2(L, 2);
-    return 0;
+static int f_AtlasRegion_get_texture(lua_State *L) {
+    check_AtlasRegion(L, 1);
+    lua_getiuservalue(L, 1, 1);
+    return 1;
 }
 
-static int f_Camera2D_get_rotation(lua_State *L) {
-     lua_pushnumber(L, check_Camera2D(L, 1)->rotation);
-     return 1;
+static int f_AtlasRegion_get_source(lua_State *L) {
+    return push_Rectangle(L, check_AtlasRegion(L, 1)->source);
 }
 
-static int f_Camera2D_set_rotation(lua_State *L) {
-    check_Camera2D(L, 1)->rotation = (float)luaL_checknumber(L, 2);
-    return 0;
+static int f_AtlasRegion_get_width(lua_State *L) {
+    lua_pushnumber(L, check_AtlasRegion(L, 1)->source.width);
+    return 1;
 }
 
-static int f_Camera2D_get_zoom(lua_State *L) {
-     lua_pushnumber(L, check_Camera2D(L, 1)->zoom);
-     return 1;
+static int f_AtlasRegion_get_height(lua_State *L) {
+    lua_pushnumber(L, check_AtlasRegion(L, 1)->source.height);
+    return 1;
 }
 
-static int f_Camera2D_set_zoom(lua_State *L) {
-    check_Camera2D(L, 1)->zoom = (float)luaL_checknumber(L, 2);
-    return 0;
+
+//==[[ TextLayout object ]]=====================================================
+
+// Decodes a string once into positioned glyph quads, so static labels draw
+// without UTF-8 decoding, glyph lookups or measuring every frame. Glyph
+// placement matches DrawTextEx(). Changing the text, size or wrapping marks
+// the layout dirty, it is rebuilt on the next draw or query.
+
+// indexed by raygui's TEXT_ALIGN_* values
+static const char *const text_align_names[] = { "left", "center", "right", NULL };
+
+typedef struct TextGlyph {
+    Rectangle source;
+    Rectangle dest;
+} TextGlyph;
+
+typedef struct TextCodepoint {
+    int index;          // glyph index, -1 for a line break
+    bool space;         // breaks lines and draws nothing
+    float advance;
+} TextCodepoint;
+
+typedef struct TextLine {
+    int first, last;    // codepoint range [first, last)
+    float width;
+} TextLine;
+
+// uservalues: 1 = Font, 2 = text
+typedef struct TextLayout {
+    Font font;
+    float fontSize, spacing;
+    float wrapWidth;    // 0 disables wrapping
+    int align;
+    bool dirty;
+    int count, capacity;
+    TextGlyph *glyphs;
+    int lineCount;
+    Vector2 size;
+    // scratch space kept between layouts, also 'capacity' entries
+    TextCodepoint *codepoints;
+    TextLine *lines;
+} TextLayout;
+
+static TextLayout *check_TextLayout(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "TextLayout");
 }
 
+static void reserve_TextLayout(lua_State *L, TextLayout *layout, const int count) {
+    if (count <= layout->capacity) return;
+    if (count > INT_MAX / 2 / (int)sizeof(TextGlyph)) luaL_error(L, "text too long");
+    int capacity = layout->capacity > 0 ? layout->capacity : 32;
+    while (capacity < count) capacity *= 2;
+    // grow one array at a time, so a failure leaves each with its recorded capacity
+    TextCodepoint *codepoints = realloc(layout->codepoints, sizeof(TextCodepoint) * (size_t)capacity);
+    if (codepoints == NULL) luaL_error(L, "out of memory");
+    layout->codepoints = codepoints;
+    TextLine *lines = realloc(layout->lines, sizeof(TextLine) * (size_t)(capacity + 1));
+    if (lines == NULL) luaL_error(L, "out of memory");
+    layout->lines = lines;
+    TextGlyph *glyphs = realloc(layout->glyphs, sizeof(TextGlyph) * (size_t)capacity);
+    if (glyphs == NULL) luaL_error(L, "out of memory");
+    layout->glyphs = glyphs;
+    layout->capacity = capacity;
+}
 
-//==[[ Wave object ]]===========================================================
+static int decode_TextLayout(TextLayout *layout, const char *text, const size_t length) {
+    const Font *font = &layout->font;
+    const float scale = layout->fontSize / (float)font->baseSize;
+    int count = 0;
+    for (size_t i = 0; i < length; ) {
+        int bytes = 0;
+        const int codepoint = GetCodepoint(&text[i], &bytes);
+        // like DrawTextEx(), a malformed sequence decodes to '?' and only skips one byte
+        if (codepoint == 0x3f) bytes = 1;
+        i += bytes > 0 ? (size_t)bytes : 1;
+        TextCodepoint *cp = &layout->codepoints[count++];
+        if (codepoint == '\n') {
+            *cp = (TextCodepoint){ .index = -1 };
+            continue;
+        }
+        const int index = GetGlyphIndex(*font, codepoint);
+        const float advance = font->glyphs[index].advanceX == 0 ? font->recs[index].width : (float)font->glyphs[index].advanceX;
+        *cp = (TextCodepoint){ index, codepoint == ' ' || codepoint == '\t', advance * scale + layout->spacing };
+    }
+    return count;
+}
 
-static int push_Wave(lua_State *L, const Wave wave) {
-    *((Wave*)push_object(L, "Wave", sizeof(Wave), 0)) = wave;
-    return 1;
+// Greedy word wrap, a word longer than the wrap width is broken between glyphs
+static int break_TextLayout(TextLayout *layout, const int count) {
+    const float spacing = layout->spacing, wrap = layout->wrapWidth;
+    int lineCount = 0, first = 0, wordStart = -1;
+    float pen = 0.0f, width = 0.0f, wordPen = 0.0f, widthBeforeWord = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        const TextCodepoint *cp = &layout->codepoints[i];
+        if (cp->index < 0) {
+            layout->lines[lineCount++] = (TextLine){ first, i, width };
+            first = i + 1;
+            wordStart = -1;
+            pen = width = 0.0f;
+            continue;
+        }
+        if (cp->space) {
+            pen += cp->advance;
+            wordStart = i + 1;
+            wordPen = pen;
+            widthBeforeWord = width;
+            continue;
+        }
+        if (wrap > 0.0f && i > first && pen + cp->advance - spacing > wrap) {
+            if (wordStart > first) {
+                layout->lines[lineCount++] = (TextLine){ first, wordStart, widthBeforeWord };
+                first = wordStart;
+                pen -= wordPen;
+            } else {
+                layout->lines[lineCount++] = (TextLine){ first, i, width };
+                first = i;
+                pen = 0.0f;
+            }
+            width = pen > 0.0f ? pen - spacing : 0.0f;
+            wordStart = -1;
+        }
+        pen += cp->advance;
+        width = pen - spacing;
+    }
+    layout->lines[lineCount++] = (TextLine){ first, count, width };
+    return lineCount;
 }
 
-static Wave *check_Wave(lua_State *L, const int idx) {
-    return luaL_checkudata(L, idx, "Wave");
+static void update_TextLayout(lua_State *L, TextLayout *layout, const int idx) {
+    if (!layout->dirty) return;
+    size_t length;
+    lua_getiuservalue(L, idx, 2);
+    const char *text = lua_tolstring(L, -1, &length);
+    // every byte decodes to at most one codepoint
+    if (length > INT_MAX) luaL_error(L, "text too long");
+    reserve_TextLayout(L, layout, (int)length + 1);
+    lua_pop(L, 1);
+
+    const Font *font = &layout->font;
+    const float scale = layout->fontSize / (float)font->baseSize;
+    const float padding = (float)font->glyphPadding;
+    // truncated like the line offset of DrawTextEx()
+    const float lineAdvance = (float)(int)((font->baseSize + font->baseSize / 2.0f) * scale);
+    const int count = decode_TextLayout(layout, text, length);
+    const int lineCount = break_TextLayout(layout, count);
+    float boxWidth = layout->wrapWidth;
+    if (boxWidth <= 0.0f) {
+        boxWidth = 0.0f;
+        for (int l = 0; l < lineCount; ++l)
+            if (layout->lines[l].width > boxWidth) boxWidth = layout->lines[l].width;
+    }
+    int glyphCount = 0;
+    for (int l = 0; l < lineCount; ++l) {
+        const TextLine *line = &layout->lines[l];
+        float x = layout->align == TEXT_ALIGN_LEFT ? 0.0f : (boxWidth - line->width) * (layout->align == TEXT_ALIGN_CENTER ? 0.5f : 1.0f);
+        const float y = lineAdvance * (float)l;
+        for (int i = line->first; i < line->last; ++i) {
+            const TextCodepoint *cp = &layout->codepoints[i];
+            if (!cp->space && cp->index >= 0) {
+                // same quad as DrawTextCodepoint()
+                const Rectangle rec = font->recs[cp->index];
+                const GlyphInfo *glyph = &font->glyphs[cp->index];
+                layout->glyphs[glyphCount++] = (TextGlyph){
+                    { rec.x - padding, rec.y - padding, rec.width + 2.0f * padding, rec.height + 2.0f * padding },
+                    { x + ((float)glyph->offsetX - padding) * scale, y + ((float)glyph->offsetY - padding) * scale,
+                      (rec.width + 2.0f * padding) * scale, (rec.height + 2.0f * padding) * scale },
+                };
+            }
+            x += cp->advance;
+        }
+    }
+    layout->count = glyphCount;
+    layout->lineCount = lineCount;
+    // the height spans the lines as DrawTextEx() places them, MeasureTextEx() does not truncate the line advance
+    layout->size = (Vector2){ boxWidth, layout->fontSize + lineAdvance * (float)(lineCount - 1) };
+    layout->dirty = false;
+}
+
+static int f_TextLayout(lua_State *L) {
+    const Font font = *check_Font(L, 1);
+    luaL_checkstring(L, 2);
+    const float fontSize = (float)luaL_optnumber(L, 3, font.baseSize);
+    const float spacing = (float)luaL_optnumber(L, 4, 0.0);
+    const float wrapWidth = (float)luaL_optnumber(L, 5, 0.0);
+    const int align = luaL_checkoption(L, 6, "left", text_align_names);
+    luaL_argcheck(L, font.baseSize > 0 && font.recs != NULL && font.glyphs != NULL, 1, "font not loaded");
+    luaL_argcheck(L, fontSize > 0.0f, 3, "invalid font size");
+    TextLayout *layout = push_object(L, "TextLayout", sizeof(TextLayout), 2);
+    *layout = (TextLayout){ .font = font, .fontSize = fontSize, .spacing = spacing, .wrapWidth = wrapWidth, .align = align, .dirty = true };
+    lua_pushvalue(L, 1);
+    lua_setiuservalue(L, -2, 1);
+    lua_pushvalue(L, 2);
+    lua_setiuservalue(L, -2, 2);
+    return 1;
 }
 
-static int f_Wave__gc(lua_State *L) {
-    UnloadWave(*check_Wave(L, 1));
+static int f_TextLayout__gc(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    free(layout->glyphs);
+    free(layout->codepoints);
+    free(layout->lines);
+    layout->glyphs = NULL;
+    layout->codepoints = NULL;
+    layout->lines = NULL;
+    layout->count = layout->capacity = 0;
     return 0;
 }
 
-static int f_Wave__tostring(lua_State *L) {
-    const Wave *wave = check_Wave(L, 1);
-    lua_pushfstring(L, "Wave(%p)", wave);
+static int f_TextLayout__tostring(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    update_TextLayout(L, layout, 1);
+    lua_pushfstring(L, "TextLayout(glyphs = %d, lines = %d)", layout->count, layout->lineCount);
     return 1;
 }
 
-static int f_Wave_get_frameCount(lua_State *L) {
-     lua_pushinteger(L, check_Wave(L, 1)->frameCount);
-     return 1;
+static int f_TextLayout_SetText(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    luaL_checkstring(L, 2);
+    lua_getiuservalue(L, 1, 2);
+    // raw equality compares strings by content, an unchanged text keeps the layout
+    if (!lua_rawequal(L, 2, -1)) {
+        lua_pushvalue(L, 2);
+        lua_setiuservalue(L, 1, 2);
+        layout->dirty = true;
+    }
+    return 0;
 }
 
-static int f_Wave_get_sampleRate(lua_State *L) {
-     lua_pushinteger(L, check_Wave(L, 1)->sampleRate);
-     return 1;
+static int f_TextLayout_Draw(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    const Vector2 position = *check_Vector2(L, 2);
+    const Color tint = *check_Color(L, 3);
+    update_TextLayout(L, layout, 1);
+    if (layout->count == 0 || layout->font.texture.id == 0) return 0;
+    const float width = (float)layout->font.texture.width, height = (float)layout->font.texture.height;
+    rlSetTexture(layout->font.texture.id);
+    rlBegin(RL_QUADS);
+    rlColor4ub(tint.r, tint.g, tint.b, tint.a);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    for (int i = 0; i < layout->count; ++i) {
+        const Rectangle source = layout->glyphs[i].source, dest = layout->glyphs[i].dest;
+        const float x = position.x + dest.x, y = position.y + dest.y;
+        const float left = source.x / width, right = (source.x + source.width) / width;
+        const float top = source.y / height, bottom = (source.y + source.height) / height;
+        rlCheckRenderBatchLimit(4);
+        rlTexCoord2f(left, top); rlVertex2f(x, y);
+        rlTexCoord2f(left, bottom); rlVertex2f(x, y + dest.height);
+        rlTexCoord2f(right, bottom); rlVertex2f(x + dest.width, y + dest.height);
+        rlTexCoord2f(right, top); rlVertex2f(x + dest.width, y);
+    }
+    rlEnd();
+    rlSetTexture(0);
+    return 0;
 }
 
-static int f_Wave_get_sampleSize(lua_State *L) {
-     lua_pushinteger(L, check_Wave(L, 1)->sampleSize);
-     return 1;
+static int f_TextLayout__len(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    update_TextLayout(L, layout, 1);
+    lua_pushinteger(L, layout->count);
+    return 1;
 }
 
-static int f_Wave_get_channels(lua_State *L) {
-     lua_pushinteger(L, check_Wave(L, 1)->channels);
-     return 1;
+static int f_TextLayout_get_text(lua_State *L) {
+    check_TextLayout(L, 1);
+    lua_getiuservalue(L, 1, 2);
+    return 1;
 }
 
+static int f_TextLayout_set_text(lua_State *L) {
+    return f_TextLayout_SetText(L);
+}
 
-//==[[ Sound object ]]===========================================================
-
-static int push_Sound(lua_State *L, const Sound sound) {
-    *((Sound*)push_object(L, "Sound", sizeof(Sound), 0)) = sound;
+static int f_TextLayout_get_font(lua_State *L) {
+    check_TextLayout(L, 1);
+    lua_getiuservalue(L, 1, 1);
     return 1;
 }
 
-static Sound *check_Sound(lua_State *L, const int idx) {
-    return luaL_checkudata(L, idx, "Sound");
+static int f_TextLayout_get_fontSize(lua_State *L) {
+    lua_pushnumber(L, check_TextLayout(L, 1)->fontSize);
+    return 1;
 }
 
-static int f_Sound__gc(lua_State *L) {
-    UnloadSound(*check_Sound(L, 1));
+static int f_TextLayout_set_fontSize(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    const float fontSize = (float)luaL_checknumber(L, 2);
+    luaL_argcheck(L, fontSize > 0.0f, 2, "invalid font size");
+    layout->dirty |= fontSize != layout->fontSize;
+    layout->fontSize = fontSize;
     return 0;
 }
 
-static int f_Sound__tostring(lua_State *L) {
-    const Sound *sound = check_Sound(L, 1);
-    lua_pushfstring(L, "Sound(%p)", sound);
+static int f_TextLayout_get_spacing(lua_State *L) {
+    lua_pushnumber(L, check_TextLayout(L, 1)->spacing);
     return 1;
 }
 
+static int f_TextLayout_set_spacing(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    const float spacing = (float)luaL_checknumber(L, 2);
+    layout->dirty |= spacing != layout->spacing;
+    layout->spacing = spacing;
+    return 0;
+}
 
-//==[[ Music object ]]===========================================================
-
-static int push_Music(lua_State *L, const Music music) {
-    *((Music*)push_object(L, "Music", sizeof(Music), 1)) = music;
+static int f_TextLayout_get_wrapWidth(lua_State *L) {
+    lua_pushnumber(L, check_TextLayout(L, 1)->wrapWidth);
     return 1;
 }
 
-static Music *check_Music(lua_State *L, const int idx) {
-    return luaL_checkudata(L, idx, "Music");
+static int f_TextLayout_set_wrapWidth(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    const float wrapWidth = (float)luaL_checknumber(L, 2);
+    layout->dirty |= wrapWidth != layout->wrapWidth;
+    layout->wrapWidth = wrapWidth;
+    return 0;
 }
 
-static int f_Music__gc(lua_State *L) {
-    UnloadMusicStream(*check_Music(L, 1));
+static int f_TextLayout_get_align(lua_State *L) {
+    lua_pushstring(L, text_align_names[check_TextLayout(L, 1)->align]);
+    return 1;
+}
+
+static int f_TextLayout_set_align(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    const int align = luaL_checkoption(L, 2, NULL, text_align_names);
+    layout->dirty |= align != layout->align;
+    layout->align = align;
     return 0;
 }
 
-static int f_Music__tostring(lua_State *L) {
-    const Music *music = check_Music(L, 1);
-    lua_pushfstring(L, "Music(%p)", music);
-    return 1;
+static int f_TextLayout_get_size(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    update_TextLayout(L, layout, 1);
+    return push_Vector2(L, layout->size);
 }
 
+static int f_TextLayout_get_width(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    update_TextLayout(L, layout, 1);
+    lua_pushnumber(L, layout->size.x);
+    return 1;
+}
 
-//==[[ FilePathList object ]]===================================================
+static int f_TextLayout_get_height(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    update_TextLayout(L, layout, 1);
+    lua_pushnumber(L, layout->size.y);
+    return 1;
+}
 
-static int push_FilePathList(lua_State *L, FilePathList list, void (*unload)(FilePathList)) {
-    lua_createtable(L, list.count, 0);
-    for (unsigned int i = 0; i < list.count; ++i) {
-        lua_pushstring(L, list.paths[i]);
-        lua_rawseti(L, -2, i + 1);
-    }
-    (*unload)(list);
+static int f_TextLayout_get_lineCount(lua_State *L) {
+    TextLayout *layout = check_TextLayout(L, 1);
+    update_TextLayout(L, layout, 1);
+    lua_pushinteger(L, layout->lineCount);
     return 1;
 }
 
@@ -901,7 +6025,18 @@ static int push_FilePathList(lua_State *L, FilePathList list, void (*unload)(Fil
 // Window-related functions ----------------------------------------------------
 
 static int f_InitWindow(lua_State *L) {
-    InitWindow(luaL_checkinteger(L, 1), luaL_checkinteger(L, 2), luaL_checkstring(L, 3));
+    const int width = luaL_checkinteger(L, 1), height = luaL_checkinteger(L, 2);
+    const char *title = luaL_checkstring(L, 3);
+    if (!headless.enabled) {
+        InitWindow(width, height, title);
+        return 0;
+    }
+    const char *error = get_headless_display_error();
+    if (error != NULL) return luaL_error(L, "%s", error);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(width, height, title);
+    if (!IsWindowReady()) return luaL_error(L, "headless mode could not create its hidden window");
+    begin_headless_window();
     return 0;
 }
 
@@ -912,6 +6047,8 @@ static int f_WindowShouldClose(lua_State *L) {
 
 static int f_CloseWindow(lua_State *L) {
     (void)L;
+    end_headless_window();
+    ReleaseRenderTexturePool();
     CloseWindow();
     return 0;
 }
@@ -957,7 +6094,9 @@ static int f_IsWindowState(lua_State *L) {
 }
 
 static int f_SetWindowState(lua_State *L) {
-    SetWindowState(luaL_checkinteger(L, 1));
+    unsigned int flags = (unsigned int)luaL_checkinteger(L, 1);
+    if (headless.enabled) flags &= ~(unsigned int)(FLAG_VSYNC_HINT | FLAG_FULLSCREEN_MODE);
+    SetWindowState(flags);
     return 0;
 }
 
@@ -1146,11 +6285,18 @@ static int f_ClearBackground(lua_State *L) {
 
 static int f_BeginDrawing(lua_State *L) {
     (void)L; BeginDrawing();
+    headless.drawing = true;
+    if (headless.target.id != 0) BeginTextureMode(headless.target);
     return 0;
 }
 
 static int f_EndDrawing(lua_State *L) {
-    (void)L; EndDrawing();
+    (void)L;
+    if (headless.target.id != 0) EndTextureMode();
+    headless.drawing = false;
+    EndDrawing();
+    ProcessAsyncUploads();
+    TrimRenderTexturePool();
     return 0;
 }
 
@@ -1174,6 +6320,18 @@ static int f_EndMode3D(lua_State *L) {
     return 0;
 }
 
+static int f_BeginTextureMode(lua_State *L) {
+    BeginTextureMode(*check_RenderTexture_loaded(L, 1));
+    return 0;
+}
+
+static int f_EndTextureMode(lua_State *L) {
+    (void)L; EndTextureMode();
+    // back to the offscreen framebuffer standing in for the window
+    if (headless.target.id != 0 && headless.drawing) BeginTextureMode(headless.target);
+    return 0;
+}
+
 static int f_BeginBlendMode(lua_State *L) {
     BeginBlendMode(luaL_checkinteger(L, 1));
     return 0;
@@ -1198,7 +6356,8 @@ static int f_EndScissorMode(lua_State *L) {
 // Timing-related functions ----------------------------------------------------
 
 static int f_SetTargetFPS(lua_State *L) {
-    SetTargetFPS(luaL_checkinteger(L, 1));
+    // headless runs are never throttled
+    SetTargetFPS(headless.enabled ? 0 : luaL_checkinteger(L, 1));
     return 0;
 }
 
@@ -1221,8 +6380,15 @@ static int f_GetTime(lua_State *L) {
 // Files management functions --------------------------------------------------
 
 static int f_LoadFileData(lua_State *L) {
+    size_t size;
+    const char *fileName = luaL_checkstring(L, 1);
+    const unsigned char *mapped = find_archive_file(fileName, &size, NULL);
+    if (mapped != NULL) {
+        lua_pushlstring(L, (const char*)mapped, size);
+        return 1;
+    }
     unsigned int length;
-    unsigned char *data = LoadFileData(luaL_checkstring(L, 1), &length);
+    unsigned char *data = LoadFileData(fileName, &length);
     lua_pushlstring(L, (const char*)data, length);
     UnloadFileData(data);
     return 1;
@@ -1237,7 +6403,9 @@ static int f_SaveFileData(lua_State *L) {
 }
 
 static int f_FileExists(lua_State *L) {
-    lua_pushboolean(L, FileExists(luaL_checkstring(L, 1)));
+    size_t size;
+    const char *fileName = luaL_checkstring(L, 1);
+    lua_pushboolean(L, find_archive_file(fileName, &size, NULL) != NULL || FileExists(fileName));
     return 1;
 }
 
@@ -1252,7 +6420,10 @@ static int f_IsFileExtension(lua_State *L) {
 }
 
 static int f_GetFileLength(lua_State *L) {
-    lua_pushinteger(L, GetFileLength(luaL_checkstring(L, 1)));
+    size_t size;
+    const char *fileName = luaL_checkstring(L, 1);
+    if (find_archive_file(fileName, &size, NULL) != NULL) lua_pushinteger(L, (lua_Integer)size);
+    else lua_pushinteger(L, GetFileLength(fileName));
     return 1;
 }
 
@@ -1864,7 +7035,11 @@ static int f_GetCollisionRec(lua_State *L) {
 // Image loading functions -----------------------------------------------------
 
 static int f_LoadImage(lua_State *L) {
-    return push_Image(L, LoadImage(luaL_checkstring(L, 1)));
+    int size;
+    const char *fileName = luaL_checkstring(L, 1);
+    const unsigned char *data = find_archive_asset(fileName, &size);
+    if (data != NULL) return push_Image(L, LoadImageFromMemory(GetFileExtension(fileName), data, size));
+    return push_Image(L, LoadImage(fileName));
 }
 
 static int f_LoadImageRaw(lua_State *L) {
@@ -1891,7 +7066,7 @@ static int f_LoadImageFromTexture(lua_State *L) {
 }
 
 static int f_LoadImageFromScreen(lua_State *L) {
-    return push_Image(L, LoadImageFromScreen());
+    return push_Image(L, headless.target.id != 0 ? load_headless_screen() : LoadImageFromScreen());
 }
 
 static int f_ExportImage(lua_State *L) {
@@ -1931,6 +7106,207 @@ static int f_GenImageCellular(lua_State *L) {
 }
 
 
+// Parallel image kernels ------------------------------------------------------
+
+// Fast paths for uncompressed images without mipmaps: rows are split across the
+// worker threads and every pixel gets exactly raylib's math, so the result does
+// not depend on the thread count. Other images go through raylib.
+
+typedef struct ImageJob {
+    Image *image;
+    unsigned char *output;
+    int bytesPerPixel;
+    int width, height;      // output size of resizes and rotations
+    int xRatio, yRatio;
+    Color color, replace;
+    float factors[4];
+    int amount;
+} ImageJob;
+
+static bool is_parallel_image(const Image *image, const bool rgba) {
+    if (image->data == NULL || image->width <= 0 || image->height <= 0 || image->mipmaps != 1) return false;
+    if (rgba) return image->format == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    return image->format >= PIXELFORMAT_UNCOMPRESSED_GRAYSCALE && image->format <= PIXELFORMAT_UNCOMPRESSED_R32G32B32A32;
+}
+
+static Color *image_rows(const ImageJob *job, const int first, int *width) {
+    *width = job->image->width;
+    return (Color*)job->image->data + (size_t)first * (size_t)*width;
+}
+
+static void kernel_ImageColorTint(void *context, const int first, const int last) {
+    const ImageJob *job = context;
+    int width;
+    Color *pixels = image_rows(job, first, &width);
+    const float cR = job->factors[0], cG = job->factors[1], cB = job->factors[2], cA = job->factors[3];
+    for (int i = 0, n = (last - first) * width; i < n; ++i) {
+        pixels[i].r = (unsigned char)(((float)pixels[i].r/255*cR)*255.0f);
+        pixels[i].g = (unsigned char)(((float)pixels[i].g/255*cG)*255.0f);
+        pixels[i].b = (unsigned char)(((float)pixels[i].b/255*cB)*255.0f);
+        pixels[i].a = (unsigned char)(((float)pixels[i].a/255*cA)*255.0f);
+    }
+}
+
+static void kernel_ImageColorInvert(void *context, const int first, const int last) {
+    const ImageJob *job = context;
+    int width;
+    Color *pixels = image_rows(job, first, &width);
+    for (int i = 0, n = (last - first) * width; i < n; ++i) {
+        pixels[i].r = 255 - pixels[i].r;
+        pixels[i].g = 255 - pixels[i].g;
+        pixels[i].b = 255 - pixels[i].b;
+    }
+}
+
+static float contrast_channel(const unsigned char value, const float contrast) {
+    // keeps raylib's double precision constants
+    float p = (float)value/255.0f;
+    p -= 0.5;
+    p *= contrast;
+    p += 0.5;
+    p *= 255;
+    if (p < 0) p = 0;
+    if (p > 255) p = 255;
+    return p;
+}
+
+static void kernel_ImageColorContrast(void *context, const int first, const int last) {
+    const ImageJob *job = context;
+    int width;
+    Color *pixels = image_rows(job, first, &width);
+    const float contrast = job->factors[0];
+    for (int i = 0, n = (last - first) * width; i < n; ++i) {
+        pixels[i].r = (unsigned char)contrast_channel(pixels[i].r, contrast);
+        pixels[i].g = (unsigned char)contrast_channel(pixels[i].g, contrast);
+        pixels[i].b = (unsigned char)contrast_channel(pixels[i].b, contrast);
+    }
+}
+
+static unsigned char brightness_channel(const unsigned char value, const int brightness) {
+    int c = value + brightness;
+    // raylib clamps negative values to 1, not 0
+    if (c < 0) c = 1;
+    if (c > 255) c = 255;
+    return (unsigned char)c;
+}
+
+static void kernel_ImageColorBrightness(void *context, const int first, const int last) {
+    const ImageJob *job = context;
+    int width;
+    Color *pixels = image_rows(job, first, &width);
+    for (int i = 0, n = (last - first) * width; i < n; ++i) {
+        pixels[i].r = brightness_channel(pixels[i].r, job->amount);
+        pixels[i].g = brightness_channel(pixels[i].g, job->amount);
+        pixels[i].b = brightness_channel(pixels[i].b, job->amount);
+    }
+}
+
+static void kernel_ImageColorReplace(void *context, const int first, const int last) {
+    const ImageJob *job = context;
+    int width;
+    Color *pixels = image_rows(job, first, &width);
+    const Color color = job->color, replace = job->replace;
+    for (int i = 0, n = (last - first) * width; i < n; ++i) {
+        if (pixels[i].r == color.r && pixels[i].g == color.g && pixels[i].b == color.b && pixels[i].a == color.a)
+            pixels[i] = replace;
+    }
+}
+
+static void kernel_ImageAlphaPremultiply(void *context, const int first, const int last) {
+    const ImageJob *job = context;
+    int width;
+    Color *pixels = image_rows(job, first, &width);
+    for (int i = 0, n = (last - first) * width; i < n; ++i) {
+        if (pixels[i].a == 0) {
+            pixels[i].r = pixels[i].g = pixels[i].b = 0;
+        } else if (pixels[i].a < 255) {
+            const float alpha = (float)pixels[i].a/255.0f;
+            pixels[i].r = (unsigned char)((float)pixels[i].r*alpha);
+            pixels[i].g = (unsigned char)((float)pixels[i].g*alpha);
+            pixels[i].b = (unsigned char)((float)pixels[i].b*alpha);
+        }
+    }
+}
+
+// Output rows y of the nearest neighbor resize
+static void kernel_ImageResizeNN(void *context, const int first, const int last) {
+    const ImageJob *job = context;
+    const Color *pixels = job->image->data;
+    Color *output = (Color*)job->output;
+    for (int y = first; y < last; ++y) {
+        const Color *row = &pixels[(size_t)((y*job->yRatio) >> 16) * (size_t)job->image->width];
+        for (int x = 0; x < job->width; ++x)
+            output[(size_t)y * (size_t)job->width + (size_t)x] = row[(x*job->xRatio) >> 16];
+    }
+}
+
+// Swaps the row pairs (y, height - 1 - y) for y in [first, last)
+static void kernel_ImageFlipVertical(void *context, const int first, const int last) {
+    const ImageJob *job = context;
+    const size_t size = (size_t)job->image->width * (size_t)job->bytesPerPixel;
+    unsigned char *data = job->image->data;
+    unsigned char *tmp = job->output + size * (size_t)first;
+    for (int y = first; y < last; ++y, tmp += size) {
+        unsigned char *top = data + size * (size_t)y;
+        unsigned char *bottom = data + size * (size_t)(job->image->height - 1 - y);
+        memcpy(tmp, top, size);
+        memcpy(top, bottom, size);
+        memcpy(bottom, tmp, size);
+    }
+}
+
+static void kernel_ImageFlipHorizontal(void *context, const int first, const int last) {
+    const ImageJob *job = context;
+    const int bpp = job->bytesPerPixel, width = job->image->width;
+    unsigned char tmp[16];
+    for (int y = first; y < last; ++y) {
+        unsigned char *row = (unsigned char*)job->image->data + (size_t)y * (size_t)width * (size_t)bpp;
+        for (int x = 0; x < width / 2; ++x) {
+            unsigned char *left = row + (size_t)x * (size_t)bpp, *right = row + (size_t)(width - 1 - x) * (size_t)bpp;
+            memcpy(tmp, left, (size_t)bpp);
+            memcpy(left, right, (size_t)bpp);
+            memcpy(right, tmp, (size_t)bpp);
+        }
+    }
+}
+
+// Output rows of a rotation, output row x is the source column x
+static void kernel_ImageRotate(void *context, const int first, const int last) {
+    const ImageJob *job = context;
+    const size_t bpp = (size_t)job->bytesPerPixel;
+    const int width = job->image->width, height = job->image->height;
+    const unsigned char *data = job->image->data;
+    for (int x = first; x < last; ++x) {
+        unsigned char *out = job->output + (size_t)x * (size_t)height * bpp;
+        if (job->amount > 0) {
+            // clockwise: output (x, y) comes from source (x, height - 1 - y)
+            for (int y = 0; y < height; ++y)
+                memcpy(out + (size_t)y * bpp, data + ((size_t)(height - 1 - y) * (size_t)width + (size_t)x) * bpp, bpp);
+        } else {
+            // counter clockwise: output (x, y) comes from source (width - 1 - x, y)
+            for (int y = 0; y < height; ++y)
+                memcpy(out + (size_t)y * bpp, data + ((size_t)y * (size_t)width + (size_t)(width - 1 - x)) * bpp, bpp);
+        }
+    }
+}
+
+static void rotate_parallel_image(lua_State *L, Image *image, const int direction) {
+    const int bpp = GetPixelDataSize(1, 1, image->format);
+    unsigned char *output = RL_MALLOC((size_t)image->width * (size_t)image->height * (size_t)bpp);
+    if (output == NULL) {
+        luaL_error(L, "out of memory");
+        return;
+    }
+    ImageJob job = { .image = image, .output = output, .bytesPerPixel = bpp, .amount = direction };
+    parallel_for(L, kernel_ImageRotate, &job, image->width, image->height);
+    RL_FREE(image->data);
+    image->data = output;
+    const int width = image->width;
+    image->width = image->height;
+    image->height = width;
+}
+
+
 // Image manipulation functions ------------------------------------------------
 
 static int f_ImageCopy(lua_State *L) {
@@ -1980,7 +7356,9 @@ static int f_ImageAlphaMask(lua_State *L) {
 }
 
 static int f_ImageAlphaPremultiply(lua_State *L) {
-    ImageAlphaPremultiply(check_Image(L, 1));
+    Image *image = check_Image(L, 1);
+    if (!is_parallel_image(image, true)) ImageAlphaPremultiply(image);
+    else parallel_for(L, kernel_ImageAlphaPremultiply, &(ImageJob){ .image = image }, image->height, image->width);
     return 0;
 }
 
@@ -1990,7 +7368,25 @@ static int f_ImageResize(lua_State *L) {
 }
 
 static int f_ImageResizeNN(lua_State *L) {
-    ImageResizeNN(check_Image(L, 1), (int)luaL_checknumber(L, 2), (int)luaL_checknumber(L, 3));
+    Image *image = check_Image(L, 1);
+    const int width = (int)luaL_checknumber(L, 2), height = (int)luaL_checknumber(L, 3);
+    if (!is_parallel_image(image, true) || width <= 0 || height <= 0) {
+        ImageResizeNN(image, width, height);
+        return 0;
+    }
+    Color *output = RL_MALLOC(sizeof(Color) * (size_t)width * (size_t)height);
+    if (output == NULL) return luaL_error(L, "out of memory");
+    ImageJob job = {
+        .image = image, .output = (unsigned char*)output, .width = width, .height = height,
+        // same fixed point ratios as raylib
+        .xRatio = (int)((image->width << 16)/width) + 1,
+        .yRatio = (int)((image->height << 16)/height) + 1,
+    };
+    parallel_for(L, kernel_ImageResizeNN, &job, height, width);
+    RL_FREE(image->data);
+    image->data = output;
+    image->width = width;
+    image->height = height;
     return 0;
 }
 
@@ -2010,32 +7406,58 @@ static int f_ImageDither(lua_State *L) {
 }
 
 static int f_ImageFlipVertical(lua_State *L) {
-    ImageFlipVertical(check_Image(L, 1));
+    Image *image = check_Image(L, 1);
+    if (!is_parallel_image(image, false)) {
+        ImageFlipVertical(image);
+        return 0;
+    }
+    const int bpp = GetPixelDataSize(1, 1, image->format);
+    // one scratch row per swapped row pair, so tiles never share one
+    unsigned char *scratch = RL_MALLOC((size_t)image->width * (size_t)bpp * (size_t)(image->height / 2 + 1));
+    if (scratch == NULL) return luaL_error(L, "out of memory");
+    ImageJob job = { .image = image, .output = scratch, .bytesPerPixel = bpp };
+    parallel_for(L, kernel_ImageFlipVertical, &job, image->height / 2, image->width);
+    RL_FREE(scratch);
     return 0;
 }
 
 static int f_ImageFlipHorizontal(lua_State *L) {
-    ImageFlipHorizontal(check_Image(L, 1));
+    Image *image = check_Image(L, 1);
+    if (!is_parallel_image(image, false)) ImageFlipHorizontal(image);
+    else parallel_for(L, kernel_ImageFlipHorizontal, &(ImageJob){ .image = image, .bytesPerPixel = GetPixelDataSize(1, 1, image->format) }, image->height, image->width);
     return 0;
 }
 
 static int f_ImageRotateCW(lua_State *L) {
-    ImageRotateCW(check_Image(L, 1));
+    Image *image = check_Image(L, 1);
+    if (!is_parallel_image(image, false)) ImageRotateCW(image);
+    else rotate_parallel_image(L, image, 1);
     return 0;
 }
 
 static int f_ImageRotateCCW(lua_State *L) {
-    ImageRotateCCW(check_Image(L, 1));
+    Image *image = check_Image(L, 1);
+    if (!is_parallel_image(image, false)) ImageRotateCCW(image);
+    else rotate_parallel_image(L, image, -1);
     return 0;
 }
 
 static int f_ImageColorTint(lua_State *L) {
-    ImageColorTint(check_Image(L, 1), *check_Color(L, 2));
+    Image *image = check_Image(L, 1);
+    const Color color = *check_Color(L, 2);
+    if (!is_parallel_image(image, true)) {
+        ImageColorTint(image, color);
+        return 0;
+    }
+    ImageJob job = { .image = image, .factors = { (float)color.r/255, (float)color.g/255, (float)color.b/255, (float)color.a/255 } };
+    parallel_for(L, kernel_ImageColorTint, &job, image->height, image->width);
     return 0;
 }
 
 static int f_ImageColorInvert(lua_State *L) {
-    ImageColorInvert(check_Image(L, 1));
+    Image *image = check_Image(L, 1);
+    if (!is_parallel_image(image, true)) ImageColorInvert(image);
+    else parallel_for(L, kernel_ImageColorInvert, &(ImageJob){ .image = image }, image->height, image->width);
     return 0;
 }
 
@@ -2045,50 +7467,345 @@ static int f_ImageColorGrayscale(lua_State *L) {
 }
 
 static int f_ImageColorContrast(lua_State *L) {
-    ImageColorContrast(check_Image(L, 1), (float)luaL_checknumber(L, 2));
+    Image *image = check_Image(L, 1);
+    float contrast = (float)luaL_checknumber(L, 2);
+    if (!is_parallel_image(image, true)) {
+        ImageColorContrast(image, contrast);
+        return 0;
+    }
+    if (contrast < -100) contrast = -100;
+    if (contrast > 100) contrast = 100;
+    contrast = (100.0f + contrast)/100.0f;
+    contrast *= contrast;
+    parallel_for(L, kernel_ImageColorContrast, &(ImageJob){ .image = image, .factors = { contrast } }, image->height, image->width);
     return 0;
 }
 
 static int f_ImageColorBrightness(lua_State *L) {
-    ImageColorBrightness(check_Image(L, 1), (int)luaL_checknumber(L, 2));
+    Image *image = check_Image(L, 1);
+    int brightness = (int)luaL_checknumber(L, 2);
+    if (!is_parallel_image(image, true)) {
+        ImageColorBrightness(image, brightness);
+        return 0;
+    }
+    if (brightness < -255) brightness = -255;
+    if (brightness > 255) brightness = 255;
+    parallel_for(L, kernel_ImageColorBrightness, &(ImageJob){ .image = image, .amount = brightness }, image->height, image->width);
     return 0;
 }
 
 static int f_ImageColorReplace(lua_State *L) {
-    ImageColorReplace(check_Image(L, 1), *check_Color(L, 2), *check_Color(L, 3));
+    Image *image = check_Image(L, 1);
+    const Color color = *check_Color(L, 2), replace = *check_Color(L, 3);
+    if (!is_parallel_image(image, true)) ImageColorReplace(image, color, replace);
+    else parallel_for(L, kernel_ImageColorReplace, &(ImageJob){ .image = image, .color = color, .replace = replace }, image->height, image->width);
     return 0;
 }
 
 static int f_LoadImageColors(lua_State *L) {
     const Image *image = check_Image(L, 1);
     Color *colors = LoadImageColors(*image);
-    lua_createtable(L, image->width * image->height, 0);
-    for (int i = 0; i < image->width * image->height; ++i) {
-        push_Color(L, colors[i]);
-        lua_rawseti(L, -2, i + 1);
-    }
+    push_ColorBuffer(L, image->width, image->height, colors);
     UnloadImageColors(colors);
     return 1;
 }
 
 static int f_LoadImagePalette(lua_State *L) {
     int count;
-    Color *colors = LoadImagePalette(*check_Image(L, 1), 256, &count);
-    lua_createtable(L, count, 0);
-    for (int i = 0; i < count; ++i) {
-        push_Color(L, colors[i]);
-        lua_rawseti(L, -2, i + 1);
-    }
+    const Image *image = check_Image(L, 1);
+    const lua_Integer size = luaL_optinteger(L, 2, 256);
+    luaL_argcheck(L, size > 0 && size <= INT_MAX / (int)sizeof(Color), 2, "invalid palette size");
+    Color *colors = LoadImagePalette(*image, (int)size, &count);
+    push_ColorBuffer(L, count, 1, colors);
     UnloadImagePalette(colors);
     return 1;
 }
 
-static int f_GetImageAlphaBorder(lua_State *L) {
-    return push_Rectangle(L, GetImageAlphaBorder(*check_Image(L, 1), (float)luaL_checknumber(L, 2)));
+static int f_LoadImageFromColors(lua_State *L) {
+    const ColorBuffer *buffer = check_ColorBuffer(L, 1);
+    const size_t size = sizeof(Color) * (size_t)buffer->count;
+    void *data = RL_MALLOC(size > 0 ? size : 1);
+    if (data == NULL) return luaL_error(L, "out of memory");
+    memcpy(data, buffer->colors, size);
+    return push_Image(L, (Image){
+        .data = data,
+        .width = buffer->width,
+        .height = buffer->height,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    });
+}
+
+static int f_UpdateImageFromColors(lua_State *L) {
+    Image *image = check_Image(L, 1);
+    const ColorBuffer *buffer = check_ColorBuffer(L, 2);
+    const size_t size = sizeof(Color) * (size_t)buffer->count;
+    // reuse the pixel memory if the layout already matches, otherwise replace it
+    if (image->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 || image->mipmaps != 1 ||
+        image->width != buffer->width || image->height != buffer->height) {
+        void *data = RL_MALLOC(size > 0 ? size : 1);
+        if (data == NULL) return luaL_error(L, "out of memory");
+        UnloadImage(*image);
+        *image = (Image){
+            .data = data,
+            .width = buffer->width,
+            .height = buffer->height,
+            .mipmaps = 1,
+            .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+        };
+    }
+    memcpy(image->data, buffer->colors, size);
+    return 0;
+}
+
+static int f_GetImageAlphaBorder(lua_State *L) {
+    return push_Rectangle(L, GetImageAlphaBorder(*check_Image(L, 1), (float)luaL_checknumber(L, 2)));
+}
+
+static int f_GetImageColor(lua_State *L) {
+    return push_Color(L, GetImageColor(*check_Image(L, 1), (int)luaL_checknumber(L, 2), (int)luaL_checknumber(L, 3)));
+}
+
+
+// Image pipeline --------------------------------------------------------------
+
+// Records per-pixel Image operations and applies them in a single pass. Each
+// pixel goes through raylib's math for every operation, including the round
+// trip to grayscale raylib does after each operation on a grayscale image, so
+// the result matches calling the Image methods one after another.
+
+typedef enum { IMAGE_OP_TINT, IMAGE_OP_INVERT, IMAGE_OP_GRAYSCALE, IMAGE_OP_CONTRAST, IMAGE_OP_BRIGHTNESS, IMAGE_OP_REPLACE, IMAGE_OP_PREMULTIPLY } ImageOpType;
+
+typedef struct ImageOp {
+    ImageOpType type;
+    Color color, replace;
+    float factors[4];
+    int amount;
+} ImageOp;
+
+typedef struct ImagePipeline {
+    int count, capacity;
+    ImageOp *ops;
+} ImagePipeline;
+
+typedef struct ImagePipelineJob {
+    Image *image;
+    unsigned char *output;  // grayscale output of an RGBA image, NULL when done in place
+    const ImagePipeline *pipeline;
+} ImagePipelineJob;
+
+static ImagePipeline *check_ImagePipeline(lua_State *L, const int idx) {
+    return luaL_checkudata(L, idx, "ImagePipeline");
+}
+
+static unsigned char grayscale_pixel(const Color c) {
+    // as ImageFormat converts normalized RGBA to PIXELFORMAT_UNCOMPRESSED_GRAYSCALE
+    return (unsigned char)(((float)c.r/255.0f*0.299f + (float)c.g/255.0f*0.587f + (float)c.b/255.0f*0.114f)*255.0f);
+}
+
+static Color apply_ImageOp(const ImageOp *op, Color c) {
+    switch (op->type) {
+        case IMAGE_OP_TINT:
+            c.r = (unsigned char)(((float)c.r/255*op->factors[0])*255.0f);
+            c.g = (unsigned char)(((float)c.g/255*op->factors[1])*255.0f);
+            c.b = (unsigned char)(((float)c.b/255*op->factors[2])*255.0f);
+            c.a = (unsigned char)(((float)c.a/255*op->factors[3])*255.0f);
+            break;
+        case IMAGE_OP_INVERT:
+            c.r = 255 - c.r; c.g = 255 - c.g; c.b = 255 - c.b;
+            break;
+        case IMAGE_OP_GRAYSCALE: {
+            const unsigned char gray = grayscale_pixel(c);
+            c = (Color){ gray, gray, gray, 255 };
+        } break;
+        case IMAGE_OP_CONTRAST:
+            c.r = (unsigned char)contrast_channel(c.r, op->factors[0]);
+            c.g = (unsigned char)contrast_channel(c.g, op->factors[0]);
+            c.b = (unsigned char)contrast_channel(c.b, op->factors[0]);
+            break;
+        case IMAGE_OP_BRIGHTNESS:
+            c.r = brightness_channel(c.r, op->amount);
+            c.g = brightness_channel(c.g, op->amount);
+            c.b = brightness_channel(c.b, op->amount);
+            break;
+        case IMAGE_OP_REPLACE:
+            if (c.r == op->color.r && c.g == op->color.g && c.b == op->color.b && c.a == op->color.a) c = op->replace;
+            break;
+        case IMAGE_OP_PREMULTIPLY:
+            if (c.a == 0) {
+                c.r = c.g = c.b = 0;
+            } else if (c.a < 255) {
+                const float alpha = (float)c.a/255.0f;
+                c.r = (unsigned char)((float)c.r*alpha);
+                c.g = (unsigned char)((float)c.g*alpha);
+                c.b = (unsigned char)((float)c.b*alpha);
+            }
+            break;
+    }
+    return c;
+}
+
+static Color apply_ImagePipeline(const ImagePipeline *pipeline, Color c, bool gray) {
+    for (int i = 0; i < pipeline->count; ++i) {
+        const ImageOp *op = &pipeline->ops[i];
+        if (op->type == IMAGE_OP_GRAYSCALE) {
+            // converting a grayscale image to grayscale does nothing
+            if (!gray) c = apply_ImageOp(op, c);
+            gray = true;
+            continue;
+        }
+        c = apply_ImageOp(op, c);
+        if (gray) {
+            const unsigned char value = grayscale_pixel(c);
+            c = (Color){ value, value, value, 255 };
+        }
+    }
+    return c;
+}
+
+static void kernel_ImagePipeline(void *context, const int first, const int last) {
+    const ImagePipelineJob *job = context;
+    const size_t width = (size_t)job->image->width;
+    const size_t begin = (size_t)first * width, end = (size_t)last * width;
+    if (job->image->format == PIXELFORMAT_UNCOMPRESSED_GRAYSCALE) {
+        unsigned char *pixels = job->image->data;
+        for (size_t i = begin; i < end; ++i)
+            pixels[i] = apply_ImagePipeline(job->pipeline, (Color){ pixels[i], pixels[i], pixels[i], 255 }, true).r;
+    } else if (job->output != NULL) {
+        const Color *pixels = job->image->data;
+        for (size_t i = begin; i < end; ++i)
+            job->output[i] = apply_ImagePipeline(job->pipeline, pixels[i], false).r;
+    } else {
+        Color *pixels = job->image->data;
+        for (size_t i = begin; i < end; ++i)
+            pixels[i] = apply_ImagePipeline(job->pipeline, pixels[i], false);
+    }
+}
+
+// Applies the operations one by one through raylib, for formats the fused pass does not handle
+static void apply_ImagePipeline_unfused(const ImagePipeline *pipeline, Image *image) {
+    for (int i = 0; i < pipeline->count; ++i) {
+        const ImageOp *op = &pipeline->ops[i];
+        switch (op->type) {
+            case IMAGE_OP_TINT: ImageColorTint(image, op->color); break;
+            case IMAGE_OP_INVERT: ImageColorInvert(image); break;
+            case IMAGE_OP_GRAYSCALE: ImageColorGrayscale(image); break;
+            case IMAGE_OP_CONTRAST: ImageColorContrast(image, op->factors[1]); break;
+            case IMAGE_OP_BRIGHTNESS: ImageColorBrightness(image, op->amount); break;
+            case IMAGE_OP_REPLACE: ImageColorReplace(image, op->color, op->replace); break;
+            case IMAGE_OP_PREMULTIPLY: ImageAlphaPremultiply(image); break;
+        }
+    }
+}
+
+// Appends an operation and returns the pipeline at index 1 for chaining
+static int add_ImageOp(lua_State *L, const ImageOp op) {
+    ImagePipeline *pipeline = check_ImagePipeline(L, 1);
+    if (pipeline->count == pipeline->capacity) {
+        const int capacity = pipeline->capacity > 0 ? pipeline->capacity * 2 : 8;
+        ImageOp *ops = realloc(pipeline->ops, sizeof(ImageOp) * (size_t)capacity);
+        if (ops == NULL) return luaL_error(L, "out of memory");
+        pipeline->ops = ops;
+        pipeline->capacity = capacity;
+    }
+    pipeline->ops[pipeline->count++] = op;
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int f_ImagePipeline(lua_State *L) {
+    ImagePipeline *pipeline = push_object(L, "ImagePipeline", sizeof(ImagePipeline), 0);
+    *pipeline = (ImagePipeline){ 0 };
+    return 1;
+}
+
+static int f_ImagePipeline__gc(lua_State *L) {
+    ImagePipeline *pipeline = check_ImagePipeline(L, 1);
+    free(pipeline->ops);
+    *pipeline = (ImagePipeline){ 0 };
+    return 0;
+}
+
+static int f_ImagePipeline__tostring(lua_State *L) {
+    lua_pushfstring(L, "ImagePipeline(count = %d)", check_ImagePipeline(L, 1)->count);
+    return 1;
+}
+
+static int f_ImagePipeline__len(lua_State *L) {
+    lua_pushinteger(L, check_ImagePipeline(L, 1)->count);
+    return 1;
+}
+
+static int f_ImagePipeline_ColorTint(lua_State *L) {
+    const Color color = *check_Color(L, 2);
+    return add_ImageOp(L, (ImageOp){ .type = IMAGE_OP_TINT, .color = color,
+        .factors = { (float)color.r/255, (float)color.g/255, (float)color.b/255, (float)color.a/255 } });
+}
+
+static int f_ImagePipeline_ColorInvert(lua_State *L) {
+    return add_ImageOp(L, (ImageOp){ .type = IMAGE_OP_INVERT });
+}
+
+static int f_ImagePipeline_ColorGrayscale(lua_State *L) {
+    return add_ImageOp(L, (ImageOp){ .type = IMAGE_OP_GRAYSCALE });
+}
+
+static int f_ImagePipeline_ColorContrast(lua_State *L) {
+    // factors[0] is the prepared factor like ImageColorContrast computes it, factors[1] the argument
+    const float argument = (float)luaL_checknumber(L, 2);
+    float contrast = argument;
+    if (contrast < -100) contrast = -100;
+    if (contrast > 100) contrast = 100;
+    contrast = (100.0f + contrast)/100.0f;
+    contrast *= contrast;
+    return add_ImageOp(L, (ImageOp){ .type = IMAGE_OP_CONTRAST, .factors = { contrast, argument } });
+}
+
+static int f_ImagePipeline_ColorBrightness(lua_State *L) {
+    int brightness = (int)luaL_checknumber(L, 2);
+    if (brightness < -255) brightness = -255;
+    if (brightness > 255) brightness = 255;
+    return add_ImageOp(L, (ImageOp){ .type = IMAGE_OP_BRIGHTNESS, .amount = brightness });
 }
 
-static int f_GetImageColor(lua_State *L) {
-    return push_Color(L, GetImageColor(*check_Image(L, 1), (int)luaL_checknumber(L, 2), (int)luaL_checknumber(L, 3)));
+static int f_ImagePipeline_ColorReplace(lua_State *L) {
+    return add_ImageOp(L, (ImageOp){ .type = IMAGE_OP_REPLACE, .color = *check_Color(L, 2), .replace = *check_Color(L, 3) });
+}
+
+static int f_ImagePipeline_AlphaPremultiply(lua_State *L) {
+    return add_ImageOp(L, (ImageOp){ .type = IMAGE_OP_PREMULTIPLY });
+}
+
+static int f_ImagePipeline_Clear(lua_State *L) {
+    check_ImagePipeline(L, 1)->count = 0;
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int f_ImagePipeline_Apply(lua_State *L) {
+    const ImagePipeline *pipeline = check_ImagePipeline(L, 1);
+    Image *image = check_Image(L, 2);
+    if (pipeline->count == 0 || image->data == NULL || image->width <= 0 || image->height <= 0) return 0;
+    const bool rgba = image->format == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    if (image->mipmaps != 1 || (!rgba && image->format != PIXELFORMAT_UNCOMPRESSED_GRAYSCALE)) {
+        apply_ImagePipeline_unfused(pipeline, image);
+        return 0;
+    }
+    ImagePipelineJob job = { .image = image, .pipeline = pipeline };
+    bool grayscale = false;
+    for (int i = 0; i < pipeline->count; ++i)
+        grayscale = grayscale || pipeline->ops[i].type == IMAGE_OP_GRAYSCALE;
+    if (rgba && grayscale) {
+        job.output = RL_MALLOC((size_t)image->width * (size_t)image->height);
+        if (job.output == NULL) return luaL_error(L, "out of memory");
+    }
+    parallel_for(L, kernel_ImagePipeline, &job, image->height, (long long)image->width * pipeline->count);
+    if (job.output != NULL) {
+        RL_FREE(image->data);
+        image->data = job.output;
+        image->format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE;
+    }
+    return 0;
 }
 
 
@@ -2168,7 +7885,70 @@ static int f_ImageDrawTextEx(lua_State *L) {
 // Texture loading functions ---------------------------------------------------
 
 static int f_LoadTexture(lua_State *L) {
-    return push_Texture(L, LoadTexture(luaL_checkstring(L, 1)));
+    int size;
+    const char *fileName = luaL_checkstring(L, 1);
+    const unsigned char *data = find_archive_asset(fileName, &size);
+    if (data == NULL) return push_Texture(L, LoadTexture(fileName));
+    Image image = LoadImageFromMemory(GetFileExtension(fileName), data, size);
+    Texture texture = image.data != NULL ? LoadTextureFromImage(image) : (Texture){ 0 };
+    UnloadImage(image);
+    return push_Texture(L, texture);
+}
+
+static int f_LoadRenderTexture(lua_State *L) {
+    const lua_Integer width = luaL_checkinteger(L, 1), height = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, width > 0 && width <= INT_MAX, 1, "invalid width");
+    luaL_argcheck(L, height > 0 && height <= INT_MAX, 2, "invalid height");
+    return push_RenderTexture(L, LoadRenderTexture((int)width, (int)height), false);
+}
+
+static int f_AcquireRenderTexture(lua_State *L) {
+    const lua_Integer width = luaL_checkinteger(L, 1), height = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, width > 0 && width <= INT_MAX, 1, "invalid width");
+    luaL_argcheck(L, height > 0 && height <= INT_MAX, 2, "invalid height");
+    return push_RenderTexture(L, acquire_render_target((int)width, (int)height), true);
+}
+
+static int f_ReleaseRenderTexture(lua_State *L) {
+    RenderTexture *target = check_RenderTexture(L, 1);
+    release_render_target(*target);
+    *target = (RenderTexture){ 0 };
+    return 0;
+}
+
+static int f_LoadTextureFromImage(lua_State *L) {
+    return push_Texture(L, LoadTextureFromImage(*check_Image(L, 1)));
+}
+
+// Returns the pixels of the Image or ColorBuffer at idx, which must be width x height in the given format
+static const void *check_texture_pixels(lua_State *L, const int idx, const int width, const int height, const int format) {
+    const ColorBuffer *buffer = luaL_testudata(L, idx, "ColorBuffer");
+    if (buffer != NULL) {
+        luaL_argcheck(L, format == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, idx, "texture format is not R8G8B8A8");
+        luaL_argcheck(L, buffer->width == width && buffer->height == height, idx, "size does not match");
+        return buffer->colors;
+    }
+    const Image *image = check_Image(L, idx);
+    luaL_argcheck(L, image->format == format, idx, "format does not match");
+    luaL_argcheck(L, image->width == width && image->height == height, idx, "size does not match");
+    luaL_argcheck(L, image->data != NULL, idx, "empty image");
+    return image->data;
+}
+
+static int f_UpdateTexture(lua_State *L) {
+    // uploads straight from the Lua owned pixels, no intermediate copy
+    const Texture *texture = check_Texture(L, 1);
+    UpdateTexture(*texture, check_texture_pixels(L, 2, texture->width, texture->height, texture->format));
+    return 0;
+}
+
+static int f_UpdateTextureRec(lua_State *L) {
+    const Texture *texture = check_Texture(L, 1);
+    const Rectangle rec = *check_Rectangle(L, 2);
+    const int x = (int)rec.x, y = (int)rec.y, width = (int)rec.width, height = (int)rec.height;
+    luaL_argcheck(L, x >= 0 && y >= 0 && width > 0 && height > 0 && x <= texture->width - width && y <= texture->height - height, 2, "rectangle outside the texture");
+    UpdateTextureRec(*texture, (Rectangle){ (float)x, (float)y, (float)width, (float)height }, check_texture_pixels(L, 3, width, height, texture->format));
+    return 0;
 }
 
 
@@ -2193,22 +7973,50 @@ static int f_SetTextureWrap(lua_State *L) {
 // Texture drawing functions ---------------------------------------------------
 
 static int f_DrawTexture(lua_State *L) {
-    DrawTexture(*check_Texture(L, 1), (int)luaL_checknumber(L, 2), (int)luaL_checknumber(L, 3), *check_Color(L, 4));
+    const Rectangle *region;
+    const Texture *texture = check_Texture_Region(L, 1, &region);
+    const int x = (int)luaL_checknumber(L, 2), y = (int)luaL_checknumber(L, 3);
+    if (region != NULL)
+        DrawTextureRec(*texture, *region, (Vector2){ (float)x, (float)y }, *check_Color(L, 4));
+    else
+        DrawTexture(*texture, x, y, *check_Color(L, 4));
     return 0;
 }
 
 static int f_DrawTextureV(lua_State *L) {
-    DrawTextureV(*check_Texture(L, 1), *check_Vector2(L, 2), *check_Color(L, 3));
+    const Rectangle *region;
+    const Texture *texture = check_Texture_Region(L, 1, &region);
+    if (region != NULL)
+        DrawTextureRec(*texture, *region, *check_Vector2(L, 2), *check_Color(L, 3));
+    else
+        DrawTextureV(*texture, *check_Vector2(L, 2), *check_Color(L, 3));
     return 0;
 }
 
 static int f_DrawTextureEx(lua_State *L) {
-    DrawTextureEx(*check_Texture(L, 1), *check_Vector2(L, 2), (float)luaL_checknumber(L, 3), (float)luaL_checknumber(L, 4), *check_Color(L, 5));
+    const Rectangle *region;
+    const Texture *texture = check_Texture_Region(L, 1, &region);
+    const Vector2 position = *check_Vector2(L, 2);
+    const float rotation = (float)luaL_checknumber(L, 3), scale = (float)luaL_checknumber(L, 4);
+    if (region != NULL) {
+        const Rectangle dest = { position.x, position.y, region->width * scale, region->height * scale };
+        DrawTexturePro(*texture, *region, dest, (Vector2){ 0, 0 }, rotation, *check_Color(L, 5));
+    } else {
+        DrawTextureEx(*texture, position, rotation, scale, *check_Color(L, 5));
+    }
     return 0;
 }
 
 static int f_DrawTextureRec(lua_State *L) {
-    DrawTextureRec(*check_Texture(L, 1), *check_Rectangle(L, 2), *check_Vector2(L, 3), *check_Color(L, 4));
+    const Rectangle *region;
+    const Texture *texture = check_Texture_Region(L, 1, &region);
+    Rectangle source = *check_Rectangle(L, 2);
+    if (region != NULL) {
+        // the source rectangle is relative to the region
+        source.x += region->x;
+        source.y += region->y;
+    }
+    DrawTextureRec(*texture, source, *check_Vector2(L, 3), *check_Color(L, 4));
     return 0;
 }
 
@@ -2223,7 +8031,14 @@ static int f_DrawTextureTiled(lua_State *L) {
 }
 
 static int f_DrawTexturePro(lua_State *L) {
-    DrawTexturePro(*check_Texture(L, 1), *check_Rectangle(L, 2), *check_Rectangle(L, 3), *check_Vector2(L, 4), (float)luaL_checknumber(L, 5), *check_Color(L, 6));
+    const Rectangle *region;
+    const Texture *texture = check_Texture_Region(L, 1, &region);
+    Rectangle source = *check_Rectangle(L, 2);
+    if (region != NULL) {
+        source.x += region->x;
+        source.y += region->y;
+    }
+    DrawTexturePro(*texture, source, *check_Rectangle(L, 3), *check_Vector2(L, 4), (float)luaL_checknumber(L, 5), *check_Color(L, 6));
     return 0;
 }
 
@@ -2232,7 +8047,11 @@ static int f_DrawTextureNPatch(lua_State *L) {
 }
 
 static int f_DrawTexturePoly(lua_State *L) {
-    return luaL_error(L, "not implemented");
+    int count, texcoord_count;
+    Vector2 *points = check_Vector2_List(L, 3, &count);
+    Vector2 *texcoords = check_Vector2_List(L, 4, &texcoord_count);
+    DrawTexturePoly(*check_Texture(L, 1), *check_Vector2(L, 2), points, texcoords, count < texcoord_count ? count : texcoord_count, *check_Color(L, 5));
+    return 0;
 }
 
 
@@ -2245,7 +8064,16 @@ static int f_GetFontDefault(lua_State *L) {
 }
 
 static int f_LoadFont(lua_State *L) {
-    return push_Font(L, LoadFont(luaL_checkstring(L, 1)));
+    int size;
+    const char *fileName = luaL_checkstring(L, 1);
+    const unsigned char *data = find_archive_asset(fileName, &size);
+    // only TrueType fonts load from memory, the others go through the file callbacks
+    if (data != NULL && (IsFileExtension(fileName, ".ttf") || IsFileExtension(fileName, ".otf"))) {
+        // same defaults as LoadFont
+        Font font = LoadFontFromMemory(GetFileExtension(fileName), data, size, 32, NULL, 95);
+        return push_Font(L, font.texture.id != 0 ? font : GetFontDefault());
+    }
+    return push_Font(L, LoadFont(fileName));
 }
 
 static int f_LoadFontFromString(lua_State *L) {
@@ -2309,7 +8137,11 @@ static int f_InitAudioDevice(lua_State *L) {
 }
 
 static int f_CloseAudioDevice(lua_State *L) {
-    (void)L; CloseAudioDevice();
+    (void)L;
+    // not while the music thread is refilling a stream
+    pthread_mutex_lock(&music_worker.mutex);
+    CloseAudioDevice();
+    pthread_mutex_unlock(&music_worker.mutex);
     return 0;
 }
 
@@ -2327,7 +8159,11 @@ static int f_SetMasterVolume(lua_State *L) {
 // Wave/Sound loading/unloading functions --------------------------------------
 
 static int f_LoadWave(lua_State *L) {
-    return push_Wave(L, LoadWave(luaL_checkstring(L, 1)));
+    int size;
+    const char *fileName = luaL_checkstring(L, 1);
+    const unsigned char *data = find_archive_asset(fileName, &size);
+    if (data != NULL) return push_Wave(L, LoadWaveFromMemory(GetFileExtension(fileName), data, size));
+    return push_Wave(L, LoadWave(fileName));
 }
 
 static int f_LoadWaveFromString(lua_State *L) {
@@ -2346,7 +8182,13 @@ static int f_LoadSoundFromWave(lua_State *L) {
 }
 
 static int f_UpdateSound(lua_State *L) {
-    return luaL_error(L, "not implemented");
+    const Sound *sound = check_Sound(L, 1);
+    const SampleBuffer *buffer = check_SampleBuffer(L, 2);
+    luaL_argcheck(L, sound->stream.sampleSize == 32, 1, "sound is not in 32 bit float format");
+    luaL_argcheck(L, buffer->channels == (int)sound->stream.channels, 2, "channel count mismatch");
+    luaL_argcheck(L, buffer->frameCount <= (int)sound->frameCount, 2, "more frames than the sound can hold");
+    UpdateSound(*sound, pack_SampleBuffer(L, buffer), buffer->frameCount);
+    return 0;
 }
 
 static int f_ExportWave(lua_State *L) {
@@ -2355,6 +8197,359 @@ static int f_ExportWave(lua_State *L) {
 }
 
 
+// Wave processing kernels -----------------------------------------------------
+
+// Waves are processed as interleaved float samples and converted back to their
+// sample size at the end. A Wave method runs on the calling thread,
+// ProcessWaves() runs a list of operations over many waves with one wave per
+// worker thread at a time.
+
+#define WAVE_RESAMPLE_PHASES 1024
+#define WAVE_RESAMPLE_ROLLOFF 0.95
+
+typedef enum {
+    WAVE_RESAMPLE,
+    WAVE_MIXDOWN,
+    WAVE_NORMALIZE,
+    WAVE_TRIM_SILENCE,
+    WAVE_FADE,
+} WaveOpKind;
+
+static const char *wave_op_names[] = { "Resample", "Mixdown", "Normalize", "TrimSilence", "Fade", NULL };
+static const char *wave_normalize_modes[] = { "peak", "rms", NULL };
+
+typedef struct WaveOp {
+    WaveOpKind kind;
+    int sampleRate;         // Resample
+    int taps;               // Resample, filter taps on each side at the lower rate
+    int channels;           // Mixdown
+    float level;            // Normalize target, TrimSilence threshold
+    bool rms;               // Normalize by RMS instead of peak
+    float fadeIn, fadeOut;  // Fade, in seconds
+    float padding;          // TrimSilence, in seconds
+} WaveOp;
+
+typedef struct WaveSamples {
+    float *samples;
+    int frameCount;
+    int channels;
+    int sampleRate;
+} WaveSamples;
+
+typedef struct WaveJob {
+    Wave **waves;
+    const WaveOp *ops;
+    int opCount;
+    int failed;
+} WaveJob;
+
+static bool load_wave_samples(const Wave *wave, WaveSamples *out) {
+    const size_t count = (size_t)wave->frameCount * wave->channels;
+    float *samples = RL_MALLOC(count > 0 ? sizeof(float) * count : 1);
+    if (samples == NULL) return false;
+    if (wave->sampleSize == 8) {
+        const unsigned char *data = wave->data;
+        for (size_t i = 0; i < count; ++i) samples[i] = ((float)data[i] - 128.0f) / 128.0f;
+    } else if (wave->sampleSize == 16) {
+        const short *data = wave->data;
+        for (size_t i = 0; i < count; ++i) samples[i] = (float)data[i] / 32768.0f;
+    } else if (count > 0) {
+        memcpy(samples, wave->data, sizeof(float) * count);
+    }
+    *out = (WaveSamples){ samples, (int)wave->frameCount, (int)wave->channels, (int)wave->sampleRate };
+    return true;
+}
+
+// Converts the samples back to the wave's sample size, frees them and replaces the wave's data;
+// the scales match load_wave_samples() so unchanged samples convert back exactly
+static bool store_wave_samples(Wave *wave, WaveSamples *samples) {
+    const size_t count = (size_t)samples->frameCount * samples->channels;
+    void *data = samples->samples;
+    if (wave->sampleSize == 8) {
+        unsigned char *out = RL_MALLOC(count > 0 ? count : 1);
+        if (out != NULL) {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = (unsigned char)(lrintf(Clamp(samples->samples[i] * 128.0f, -128.0f, 127.0f)) + 128);
+        }
+        data = out;
+    } else if (wave->sampleSize == 16) {
+        short *out = RL_MALLOC(count > 0 ? sizeof(short) * count : 1);
+        if (out != NULL) {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = (short)lrintf(Clamp(samples->samples[i] * 32768.0f, -32768.0f, 32767.0f));
+        }
+        data = out;
+    }
+    if (data == NULL) {
+        RL_FREE(samples->samples);
+        return false;
+    }
+    if (data != samples->samples) RL_FREE(samples->samples);
+    RL_FREE(wave->data);
+    wave->data = data;
+    wave->frameCount = (unsigned int)samples->frameCount;
+    wave->channels = (unsigned int)samples->channels;
+    wave->sampleRate = (unsigned int)samples->sampleRate;
+    return true;
+}
+
+static double sinc(const double x) {
+    return x == 0.0 ? 1.0 : sin((double)PI * x) / ((double)PI * x);
+}
+
+static long long gcd(long long a, long long b) {
+    while (b != 0) {
+        const long long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Polyphase resampling with a Blackman windowed sinc. The rate ratio is reduced
+// to up / down, with up phases (at most WAVE_RESAMPLE_PHASES, interpolated
+// between) of 2 * half taps each. Frames outside the wave count as silence.
+static bool resample_wave(WaveSamples *s, const int sampleRate, const int taps) {
+    if (s->sampleRate == sampleRate || s->frameCount == 0) {
+        s->sampleRate = sampleRate;
+        return true;
+    }
+    const long long divisor = gcd(s->sampleRate, sampleRate);
+    const long long up = sampleRate / divisor, down = s->sampleRate / divisor;
+    const int phases = up < WAVE_RESAMPLE_PHASES ? (int)up : WAVE_RESAMPLE_PHASES;
+    // downsampling lowers the cutoff to the output rate, which widens the filter
+    const double scale = up < down ? (double)up / (double)down : 1.0;
+    const double cutoff = scale * WAVE_RESAMPLE_ROLLOFF;
+    const int half = (int)ceil(taps / scale), width = 2 * half;
+    const long long frameCount = ((long long)s->frameCount * up + down - 1) / down;
+    const int channels = s->channels;
+    if (frameCount > INT_MAX / channels) return false;
+
+    float *table = RL_MALLOC(sizeof(float) * (size_t)(phases + 1) * (size_t)width);
+    float *coefs = RL_MALLOC(sizeof(float) * (size_t)width);
+    float *output = RL_CALLOC((size_t)frameCount * (size_t)channels, sizeof(float));
+    if (table == NULL || coefs == NULL || output == NULL) {
+        RL_FREE(table);
+        RL_FREE(coefs);
+        RL_FREE(output);
+        return false;
+    }
+    // row p holds the taps for an output frame p / phases past an input frame,
+    // the extra last row lets the interpolation reach the next input frame
+    for (int p = 0; p <= phases; ++p) {
+        float *row = &table[p * width];
+        double sum = 0.0;
+        for (int k = 0; k < width; ++k) {
+            const double x = (double)p / phases + half - 1 - k, t = x / half;
+            double h = 0.0;
+            if (fabs(t) < 1.0)
+                h = cutoff * sinc(cutoff * x) * (0.42 + 0.5 * cos((double)PI * t) + 0.08 * cos(2.0 * (double)PI * t));
+            row[k] = (float)h;
+            sum += h;
+        }
+        // unity gain for DC at every phase
+        if (sum != 0.0) for (int k = 0; k < width; ++k) row[k] = (float)(row[k] / sum);
+    }
+
+    for (long long n = 0; n < frameCount; ++n) {
+        const long long position = n * down;
+        const double phase = (double)(position % up) * phases / up;
+        const int p = (int)phase;
+        const float w = (float)(phase - p);
+        const float *row0 = &table[p * width], *row1 = row0 + width;
+        for (int k = 0; k < width; ++k) coefs[k] = row0[k] + (row1[k] - row0[k]) * w;
+        const long long first = position / up - (half - 1);
+        const int k0 = first < 0 ? (int)-first : 0;
+        const int k1 = first + width > s->frameCount ? (int)(s->frameCount - first) : width;
+        float *out = &output[n * channels];
+        for (int k = k0; k < k1; ++k) {
+            const float *in = &s->samples[(first + k) * channels];
+            for (int c = 0; c < channels; ++c) out[c] += in[c] * coefs[k];
+        }
+    }
+    RL_FREE(table);
+    RL_FREE(coefs);
+    RL_FREE(s->samples);
+    s->samples = output;
+    s->frameCount = (int)frameCount;
+    s->sampleRate = sampleRate;
+    return true;
+}
+
+// Output channel c averages the input channels c, c + channels, ... in place
+static void mixdown_wave(WaveSamples *s, const int channels) {
+    if (channels >= s->channels) return;
+    for (int f = 0; f < s->frameCount; ++f) {
+        const float *in = &s->samples[f * s->channels];
+        float *out = &s->samples[f * channels];
+        for (int c = 0; c < channels; ++c) {
+            float sum = 0.0f;
+            int count = 0;
+            for (int i = c; i < s->channels; i += channels, ++count) sum += in[i];
+            out[c] = sum / count;
+        }
+    }
+    s->channels = channels;
+}
+
+static float normalize_wave(WaveSamples *s, const float level, const bool rms) {
+    const size_t count = (size_t)s->frameCount * s->channels;
+    float *samples = s->samples;
+    float measure = 0.0f;
+    if (rms) {
+        double sum = 0.0;
+        for (size_t i = 0; i < count; ++i) sum += (double)samples[i] * samples[i];
+        measure = count > 0 ? (float)sqrt(sum / count) : 0.0f;
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            const float value = fabsf(samples[i]);
+            if (value > measure) measure = value;
+        }
+    }
+    if (measure > 0.0f) {
+        const float gain = level / measure;
+        for (size_t i = 0; i < count; ++i) samples[i] *= gain;
+    }
+    return measure;
+}
+
+static bool is_silent_frame(const float *frame, const int channels, const float threshold) {
+    for (int c = 0; c < channels; ++c)
+        if (fabsf(frame[c]) >= threshold) return false;
+    return true;
+}
+
+static void trim_wave_silence(WaveSamples *s, const float threshold, const float padding) {
+    int first = 0, last = s->frameCount;
+    while (first < last && is_silent_frame(&s->samples[first * s->channels], s->channels, threshold)) ++first;
+    while (last > first && is_silent_frame(&s->samples[(last - 1) * s->channels], s->channels, threshold)) --last;
+    if (first < last) {
+        const int pad = (int)lrintf(padding * s->sampleRate);
+        first = first > pad ? first - pad : 0;
+        last = s->frameCount - last > pad ? last + pad : s->frameCount;
+    }
+    memmove(s->samples, &s->samples[first * s->channels], sizeof(float) * (size_t)(last - first) * s->channels);
+    s->frameCount = last - first;
+}
+
+static void fade_wave(WaveSamples *s, const float fadeIn, const float fadeOut) {
+    const int frames = s->frameCount, channels = s->channels;
+    const int in = (int)fminf(fadeIn * s->sampleRate, (float)frames), out = (int)fminf(fadeOut * s->sampleRate, (float)frames);
+    for (int f = 0; f < in; ++f) {
+        const float gain = (float)f / in;
+        for (int c = 0; c < channels; ++c) s->samples[f * channels + c] *= gain;
+    }
+    for (int f = frames - out; f < frames; ++f) {
+        const float gain = (float)(frames - 1 - f) / out;
+        for (int c = 0; c < channels; ++c) s->samples[f * channels + c] *= gain;
+    }
+}
+
+// Runs an operation, 'measure' receives the level before normalizing
+static bool run_WaveOp(WaveSamples *s, const WaveOp *op, float *measure) {
+    switch (op->kind) {
+        case WAVE_RESAMPLE:
+            return resample_wave(s, op->sampleRate, op->taps);
+        case WAVE_MIXDOWN:
+            mixdown_wave(s, op->channels);
+            break;
+        case WAVE_NORMALIZE:
+            *measure = normalize_wave(s, op->level, op->rms);
+            break;
+        case WAVE_TRIM_SILENCE:
+            trim_wave_silence(s, op->level, op->padding);
+            break;
+        case WAVE_FADE:
+            fade_wave(s, op->fadeIn, op->fadeOut);
+            break;
+    }
+    return true;
+}
+
+static bool process_Wave(Wave *wave, const WaveOp *ops, const int count, float *measure) {
+    WaveSamples samples;
+    if (!load_wave_samples(wave, &samples)) return false;
+    for (int i = 0; i < count; ++i) {
+        if (!run_WaveOp(&samples, &ops[i], measure)) {
+            RL_FREE(samples.samples);
+            return false;
+        }
+    }
+    return store_wave_samples(wave, &samples);
+}
+
+static void kernel_ProcessWaves(void *context, const int first, const int last) {
+    WaveJob *job = context;
+    float measure;
+    for (int i = first; i < last; ++i) {
+        if (!process_Wave(job->waves[i], job->ops, job->opCount, &measure))
+            ATOMIC_STORE(&job->failed, 1);
+    }
+}
+
+// Returns why the kernels cannot process a wave or NULL
+static const char *get_wave_format_error(const Wave *wave) {
+    if (wave->sampleSize != 8 && wave->sampleSize != 16 && wave->sampleSize != 32) return "unsupported sample size";
+    if (wave->channels == 0 || wave->channels > 64) return "unsupported channel count";
+    if (wave->sampleRate == 0) return "invalid sample rate";
+    return NULL;
+}
+
+static Wave *check_Wave_processable(lua_State *L, const int idx) {
+    Wave *wave = check_Wave(L, idx);
+    const char *error = get_wave_format_error(wave);
+    luaL_argcheck(L, error == NULL, idx, error);
+    return wave;
+}
+
+// Reads the arguments of an operation starting at 'idx'
+static void check_WaveOp(lua_State *L, const int kind, const int idx, WaveOp *op) {
+    *op = (WaveOp){ .kind = (WaveOpKind)kind };
+    switch (op->kind) {
+        case WAVE_RESAMPLE: {
+            const lua_Integer sampleRate = luaL_checkinteger(L, idx), taps = luaL_optinteger(L, idx + 1, 16);
+            luaL_argcheck(L, sampleRate > 0 && sampleRate <= 1000000, idx, "invalid sample rate");
+            luaL_argcheck(L, taps >= 2 && taps <= 128, idx + 1, "invalid tap count");
+            op->sampleRate = (int)sampleRate;
+            op->taps = (int)taps;
+            break;
+        }
+        case WAVE_MIXDOWN: {
+            const lua_Integer channels = luaL_optinteger(L, idx, 1);
+            luaL_argcheck(L, channels >= 1 && channels <= 64, idx, "invalid channel count");
+            op->channels = (int)channels;
+            break;
+        }
+        case WAVE_NORMALIZE:
+            op->level = (float)luaL_optnumber(L, idx, 1.0);
+            op->rms = luaL_checkoption(L, idx + 1, "peak", wave_normalize_modes) == 1;
+            break;
+        case WAVE_TRIM_SILENCE:
+            op->level = (float)luaL_optnumber(L, idx, 0.001);
+            op->padding = (float)luaL_optnumber(L, idx + 1, 0.0);
+            luaL_argcheck(L, op->padding >= 0.0f, idx + 1, "invalid padding");
+            break;
+        case WAVE_FADE:
+            op->fadeIn = (float)luaL_checknumber(L, idx);
+            op->fadeOut = (float)luaL_optnumber(L, idx + 1, 0.0);
+            luaL_argcheck(L, op->fadeIn >= 0.0f, idx, "invalid fade time");
+            luaL_argcheck(L, op->fadeOut >= 0.0f, idx + 1, "invalid fade time");
+            break;
+    }
+}
+
+static int run_Wave_method(lua_State *L, const WaveOpKind kind) {
+    Wave *wave = check_Wave_processable(L, 1);
+    WaveOp op;
+    check_WaveOp(L, kind, 2, &op);
+    float measure = 0.0f;
+    if (!process_Wave(wave, &op, 1, &measure)) return luaL_error(L, "out of memory");
+    if (kind != WAVE_NORMALIZE) return 0;
+    lua_pushnumber(L, measure);
+    return 1;
+}
+
+
 // Wave/Sound management functions ---------------------------------------------
 
 static int f_PlaySound(lua_State *L) {
@@ -2422,86 +8617,274 @@ static int f_WaveCrop(lua_State *L) {
 }
 
 static int f_WaveFormat(lua_State *L) {
-    WaveFormat(check_Wave(L, 1), luaL_checkinteger(L, 1), luaL_checkinteger(L, 2), luaL_checkinteger(L, 3));
+    Wave *wave = check_Wave(L, 1);
+    const lua_Integer sampleRate = luaL_checkinteger(L, 2), sampleSize = luaL_checkinteger(L, 3), channels = luaL_checkinteger(L, 4);
+    luaL_argcheck(L, sampleRate > 0 && sampleRate <= INT_MAX, 2, "invalid sample rate");
+    luaL_argcheck(L, sampleSize == 8 || sampleSize == 16 || sampleSize == 32, 3, "invalid sample size");
+    luaL_argcheck(L, channels >= 1 && channels <= 64, 4, "invalid channel count");
+    WaveFormat(wave, (int)sampleRate, (int)sampleSize, (int)channels);
+    return 0;
+}
+
+static int f_WaveResample(lua_State *L) {
+    return run_Wave_method(L, WAVE_RESAMPLE);
+}
+
+static int f_WaveMixdown(lua_State *L) {
+    return run_Wave_method(L, WAVE_MIXDOWN);
+}
+
+static int f_WaveNormalize(lua_State *L) {
+    return run_Wave_method(L, WAVE_NORMALIZE);
+}
+
+static int f_WaveTrimSilence(lua_State *L) {
+    return run_Wave_method(L, WAVE_TRIM_SILENCE);
+}
+
+static int f_WaveFade(lua_State *L) {
+    return run_Wave_method(L, WAVE_FADE);
+}
+
+// Appends the other waves, which must match the sample rate and channel count
+static int f_WaveConcat(lua_State *L) {
+    Wave *wave = check_Wave(L, 1);
+    const int top = lua_gettop(L);
+    const size_t frameSize = (size_t)wave->sampleSize / 8 * wave->channels;
+    const unsigned int frameCount = wave->frameCount;
+    size_t total = frameCount;
+    for (int i = 2; i <= top; ++i) {
+        const Wave *other = check_Wave(L, i);
+        luaL_argcheck(L, other->sampleRate == wave->sampleRate, i, "sample rate mismatch");
+        luaL_argcheck(L, other->channels == wave->channels, i, "channel count mismatch");
+        total += other->frameCount;
+    }
+    luaL_argcheck(L, total <= UINT_MAX / (frameSize > 0 ? frameSize : 1), top, "wave too long");
+    unsigned char *data = RL_REALLOC(wave->data, total * frameSize > 0 ? total * frameSize : 1);
+    if (data == NULL) return luaL_error(L, "out of memory");
+    wave->data = data;
+    size_t offset = (size_t)frameCount * frameSize;
+    for (int i = 2; i <= top; ++i) {
+        const Wave *other = check_Wave(L, i);
+        // appending a wave to itself copies its original frames
+        const size_t size = (size_t)(other == wave ? frameCount : other->frameCount) * frameSize;
+        if (other == wave) {
+            memcpy(data + offset, data, size);
+        } else if (other->sampleSize == wave->sampleSize) {
+            memcpy(data + offset, other->data, size);
+        } else {
+            Wave copy = WaveCopy(*other);
+            if (copy.data != NULL) WaveFormat(&copy, (int)wave->sampleRate, (int)wave->sampleSize, (int)wave->channels);
+            if (copy.data == NULL) {
+                wave->frameCount = (unsigned int)(offset / frameSize);
+                return luaL_error(L, "out of memory");
+            }
+            memcpy(data + offset, copy.data, size);
+            UnloadWave(copy);
+        }
+        offset += size;
+    }
+    wave->frameCount = (unsigned int)total;
+    return 0;
+}
+
+// Runs a list of operations, e.g. { 'Resample', 22050 }, over every wave of a
+// table, spreading the waves across the worker threads
+static int f_ProcessWaves(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    luaL_checktype(L, 2, LUA_TTABLE);
+    lua_settop(L, 2);
+    const int waveCount = (int)luaL_len(L, 1), opCount = (int)luaL_len(L, 2);
+    Wave **waves = lua_newuserdatauv(L, sizeof(Wave*) * (size_t)waveCount + 1, 0);
+    WaveOp *ops = lua_newuserdatauv(L, sizeof(WaveOp) * (size_t)opCount + 1, 0);
+    lua_newtable(L);    // waves seen, a wave must not be processed twice at once
+    long long samples = 0;
+    for (int i = 0; i < waveCount; ++i) {
+        lua_rawgeti(L, 1, i + 1);
+        waves[i] = luaL_testudata(L, -1, "Wave");
+        if (waves[i] == NULL) return luaL_error(L, "wave %d is not a Wave", i + 1);
+        const char *error = get_wave_format_error(waves[i]);
+        if (error != NULL) return luaL_error(L, "wave %d: %s", i + 1, error);
+        lua_pushvalue(L, -1);
+        if (lua_rawget(L, 5) != LUA_TNIL) return luaL_error(L, "wave %d appears twice", i + 1);
+        lua_pop(L, 1);
+        lua_pushboolean(L, true);
+        lua_rawset(L, 5);
+        samples += (long long)waves[i]->frameCount * waves[i]->channels;
+    }
+    for (int i = 0; i < opCount; ++i) {
+        if (lua_rawgeti(L, 2, i + 1) != LUA_TTABLE) return luaL_error(L, "operation %d is not a table", i + 1);
+        // unpack { name, args... } onto the stack to check it like method arguments
+        const int count = (int)lua_rawlen(L, 6);
+        luaL_checkstack(L, count, "too many operation arguments");
+        for (int j = 1; j <= count; ++j) lua_rawgeti(L, 6, j);
+        check_WaveOp(L, luaL_checkoption(L, 7, NULL, wave_op_names), 8, &ops[i]);
+        lua_settop(L, 5);
+    }
+    WaveJob job = { .waves = waves, .ops = ops, .opCount = opCount };
+    const long long cost = waveCount > 0 ? samples / waveCount * (opCount + 1) + 1 : 1;
+    parallel_for(L, kernel_ProcessWaves, &job, waveCount, cost);
+    if (job.failed) return luaL_error(L, "out of memory");
     return 0;
 }
 
 static int f_LoadWaveSamples(lua_State *L) {
     const Wave *wave = check_Wave(L, 1);
     float *samples = LoadWaveSamples(*wave);
-    lua_createtable(L, wave->frameCount, 0);
-    for (unsigned int i = 0; i < wave->frameCount; ++i) {
-        lua_pushnumber(L, samples[i]);
-        lua_rawseti(L, -2, i + 1);
-    }
+    SampleBuffer *buffer = push_SampleBuffer(L, (int)wave->frameCount, (int)wave->channels, (int)wave->sampleRate);
+    memcpy(buffer->data, samples, sizeof(float) * wave->frameCount * wave->channels);
     UnloadWaveSamples(samples);
     return 1;
 }
 
+static int f_LoadWaveFromSamples(lua_State *L) {
+    const SampleBuffer *buffer = check_SampleBuffer(L, 1);
+    const size_t size = sizeof(float) * (size_t)buffer->frameCount * (size_t)buffer->channels;
+    float *data = RL_MALLOC(size > 0 ? size : 1);
+    if (data == NULL) return luaL_error(L, "out of memory");
+    for (int f = 0; f < buffer->frameCount; ++f)
+        memcpy(&data[f * buffer->channels], &buffer->samples[f * buffer->stride], sizeof(float) * (size_t)buffer->channels);
+    return push_Wave(L, (Wave){
+        .frameCount = (unsigned int)buffer->frameCount,
+        .sampleRate = (unsigned int)buffer->sampleRate,
+        .sampleSize = 32,
+        .channels = (unsigned int)buffer->channels,
+        .data = data,
+    });
+}
 
 // Music management functions --------------------------------------------------
 
+// Optional sub-buffer size in frames, larger buffers ride out longer stalls
+static int check_music_prefetch(lua_State *L, const int idx) {
+    const lua_Integer frames = luaL_optinteger(L, idx, 0);
+    luaL_argcheck(L, frames >= 0 && frames <= AUDIO_RING_MAX_FRAMES, idx, "invalid prefetch size");
+    if (frames > 0) SetAudioStreamBufferSizeDefault((int)frames);
+    return (int)frames;
+}
+
+static void restore_music_prefetch(const int frames) {
+    if (frames > 0) SetAudioStreamBufferSizeDefault(audio_buffer_size_default);
+}
+
 static int f_LoadMusicStream(lua_State *L) {
-    return push_Music(L, LoadMusicStream(luaL_checkstring(L, 1)));
+    size_t size;
+    Archive *archive;
+    const char *fileName = luaL_checkstring(L, 1);
+    const unsigned char *data = find_archive_file(fileName, &size, &archive);
+    const int frames = check_music_prefetch(L, 2);
+    if (data == NULL || size > INT_MAX) {
+        const Music music = LoadMusicStream(fileName);
+        restore_music_prefetch(frames);
+        return push_Music(L, music, frames);
+    }
+    // music streams from the mapped data, so the archive must outlive it
+    const Music music = LoadMusicStreamFromMemory(GetFileExtension(fileName), data, (int)size);
+    restore_music_prefetch(frames);
+    push_Music(L, music, frames);
+    push_Archive_owner(L, archive);
+    lua_setiuservalue(L, -2, 1);
+    return 1;
 }
 
 static int f_LoadMusicStreamFromString(lua_State *L) {
     size_t length;
     const char *type = luaL_checkstring(L, 1);
     const char *data = luaL_checklstring(L, 2, &length);
-    push_Music(L, LoadMusicStreamFromMemory(type, (const unsigned char*)data, (int)length));
+    luaL_argcheck(L, length <= INT_MAX, 2, "data too large");
+    const int frames = check_music_prefetch(L, 3);
+    const Music music = LoadMusicStreamFromMemory(type, (const unsigned char*)data, (int)length);
+    restore_music_prefetch(frames);
+    push_Music(L, music, frames);
     lua_pushvalue(L, 2);
     lua_setiuservalue(L, -2, 1);
     return 1;
 }
 
 static int f_PlayMusicStream(lua_State *L) {
-    PlayMusicStream(*check_Music(L, 1));
+    MusicObject *object = check_MusicObject(L, 1);
+    lock_Music(object);
+    cancel_Music_fade(object);
+    PlayMusicStream(object->music);
+    unlock_Music(object);
     return 0;
 }
 
 static int f_IsMusicStreamPlaying(lua_State *L) {
-     lua_pushboolean(L, IsMusicStreamPlaying(*check_Music(L, 1)));
+    MusicObject *object = check_MusicObject(L, 1);
+    lock_Music(object);
+    const bool playing = IsMusicStreamPlaying(object->music);
+    unlock_Music(object);
+    lua_pushboolean(L, playing);
     return 1;
 }
 
 static int f_UpdateMusicStream(lua_State *L) {
-    UpdateMusicStream(*check_Music(L, 1));
+    MusicObject *object = check_MusicObject(L, 1);
+    // background streams are refilled by the music thread
+    if (!object->background) UpdateMusicStream(object->music);
     return 0;
 }
 
 static int f_StopMusicStream(lua_State *L) {
-    StopMusicStream(*check_Music(L, 1));
+    MusicObject *object = check_MusicObject(L, 1);
+    lock_Music(object);
+    cancel_Music_fade(object);
+    StopMusicStream(object->music);
+    unlock_Music(object);
     return 0;
 }
 
 static int f_PauseMusicStream(lua_State *L) {
-    PauseMusicStream(*check_Music(L, 1));
+    MusicObject *object = check_MusicObject(L, 1);
+    lock_Music(object);
+    PauseMusicStream(object->music);
+    unlock_Music(object);
     return 0;
 }
 
 static int f_ResumeMusicStream(lua_State *L) {
-    ResumeMusicStream(*check_Music(L, 1));
+    MusicObject *object = check_MusicObject(L, 1);
+    lock_Music(object);
+    ResumeMusicStream(object->music);
+    unlock_Music(object);
     return 0;
 }
 
 static int f_SeekMusicStream(lua_State *L) {
-    SeekMusicStream(*check_Music(L, 1), (float)luaL_checknumber(L, 2));
+    MusicObject *object = check_MusicObject(L, 1);
+    const float position = (float)luaL_checknumber(L, 2);
+    lock_Music(object);
+    SeekMusicStream(object->music, position);
+    unlock_Music(object);
     return 0;
 }
 
 static int f_SetMusicVolume(lua_State *L) {
-    SetMusicVolume(*check_Music(L, 1), (float)luaL_checknumber(L, 2));
+    MusicObject *object = check_MusicObject(L, 1);
+    const float volume = (float)luaL_checknumber(L, 2);
+    lock_Music(object);
+    object->volume = volume;
+    set_Music_gain(object, object->gain);
+    unlock_Music(object);
     return 0;
 }
 
 static int f_SetMusicPitch(lua_State *L) {
-    SetMusicPitch(*check_Music(L, 1), (float)luaL_checknumber(L, 2));
+    MusicObject *object = check_MusicObject(L, 1);
+    const float pitch = (float)luaL_checknumber(L, 2);
+    lock_Music(object);
+    SetMusicPitch(object->music, pitch);
+    unlock_Music(object);
     return 0;
 }
 
 static int f_SetMusicPan(lua_State *L) {
-    SetMusicPan(*check_Music(L, 1), (float)luaL_checknumber(L, 2));
+    MusicObject *object = check_MusicObject(L, 1);
+    const float pan = (float)luaL_checknumber(L, 2);
+    lock_Music(object);
+    SetMusicPan(object->music, pan);
+    unlock_Music(object);
     return 0;
 }
 
@@ -2511,10 +8894,172 @@ static int f_GetMusicTimeLength(lua_State *L) {
 }
 
 static int f_GetMusicTimePlayed(lua_State *L) {
-    lua_pushnumber(L, GetMusicTimePlayed(*check_Music(L, 1)));
+    MusicObject *object = check_MusicObject(L, 1);
+    lock_Music(object);
+    const float played = GetMusicTimePlayed(object->music);
+    unlock_Music(object);
+    lua_pushnumber(L, played);
+    return 1;
+}
+
+static int f_SetMusicStreamBackground(lua_State *L) {
+    MusicObject *object = check_MusicObject(L, 1);
+    luaL_checktype(L, 2, LUA_TBOOLEAN);
+    if (lua_toboolean(L, 2)) add_background_Music(L, object);
+    else remove_background_Music(object);
+    return 0;
+}
+
+// Fades 'from' out and stops it while 'to' starts and fades in, either may be
+// nil. Both streams move to the background, where the music thread runs the fade.
+static int f_CrossfadeMusicStream(lua_State *L) {
+    MusicObject *from = lua_isnil(L, 1) ? NULL : check_MusicObject(L, 1);
+    MusicObject *to = lua_isnil(L, 2) ? NULL : check_MusicObject(L, 2);
+    const double duration = luaL_checknumber(L, 3);
+    luaL_argcheck(L, from != NULL || to != NULL, 1, "expected at least one Music");
+    luaL_argcheck(L, from != to, 2, "cannot crossfade a stream with itself");
+    luaL_argcheck(L, duration >= 0.0, 3, "invalid duration");
+    if (from != NULL) add_background_Music(L, from);
+    if (to != NULL) add_background_Music(L, to);
+    pthread_mutex_lock(&music_worker.mutex);
+    if (from != NULL && IsMusicStreamPlaying(from->music))
+        start_Music_fade(from, 0.0f, duration, true);
+    if (to != NULL) {
+        if (!IsMusicStreamPlaying(to->music)) {
+            to->fading = false;
+            set_Music_gain(to, 0.0f);
+            PlayMusicStream(to->music);
+        }
+        start_Music_fade(to, 1.0f, duration, false);
+    }
+    pthread_mutex_unlock(&music_worker.mutex);
+    return 0;
+}
+
+// AudioStream management functions -------------------------------------------
+
+static int f_LoadAudioStream(lua_State *L) {
+    const lua_Integer sampleRate = luaL_checkinteger(L, 1), sampleSize = luaL_checkinteger(L, 2), channels = luaL_checkinteger(L, 3);
+    const lua_Integer ringFrames = luaL_optinteger(L, 4, 0);
+    luaL_argcheck(L, sampleRate > 0 && sampleRate <= 384000, 1, "invalid sample rate");
+    luaL_argcheck(L, sampleSize == 8 || sampleSize == 16 || sampleSize == 32, 2, "invalid sample size");
+    luaL_argcheck(L, channels >= 1 && channels <= 8, 3, "invalid channel count");
+    luaL_argcheck(L, ringFrames >= 0 && ringFrames <= AUDIO_RING_MAX_FRAMES, 4, "invalid ring size");
+    luaL_argcheck(L, ringFrames == 0 || sampleSize == 32, 2, "ring buffered streams use 32 bit float samples");
+    AudioStreamObject *object = push_object(L, "AudioStream", sizeof(AudioStreamObject), 0);
+    *object = (AudioStreamObject){ .slot = -1 };
+    if (ringFrames > 0) {
+        unsigned int capacity = 1;
+        while (capacity < (unsigned int)ringFrames) capacity <<= 1;
+        AudioRing *ring = calloc(1, sizeof(AudioRing) + sizeof(float) * (size_t)capacity * (size_t)channels);
+        if (ring == NULL) return luaL_error(L, "out of memory");
+        ring->capacity = capacity;
+        ring->channels = (unsigned int)channels;
+        object->ring = ring;
+        object->slot = acquire_audio_slot(read_AudioRing, ring);
+        if (object->slot < 0) return luaL_error(L, "too many callback driven audio streams (%d)", AUDIO_SLOT_COUNT);
+    }
+    object->stream = LoadAudioStream((unsigned int)sampleRate, (unsigned int)sampleSize, (unsigned int)channels);
+    if (object->ring != NULL) SetAudioStreamCallback(object->stream, audio_slot_callbacks[object->slot]);
+    return 1;
+}
+
+static int f_UpdateAudioStream(lua_State *L) {
+    const AudioStreamObject *object = check_AudioStreamObject(L, 1);
+    const AudioStream *stream = &object->stream;
+    luaL_argcheck(L, object->ring == NULL, 1, "stream is fed by its ring buffer, use WriteAudioStream");
+    const SampleBuffer *buffer = luaL_testudata(L, 2, "SampleBuffer");
+    if (buffer != NULL) {
+        luaL_argcheck(L, stream->sampleSize == 32, 1, "stream is not in 32 bit float format");
+        luaL_argcheck(L, buffer->channels == (int)stream->channels, 2, "channel count mismatch");
+        UpdateAudioStream(*stream, pack_SampleBuffer(L, buffer), buffer->frameCount);
+        return 0;
+    }
+    // raw frames in the stream's format
+    size_t length;
+    const char *data = luaL_checklstring(L, 2, &length);
+    const size_t frameSize = (size_t)stream->sampleSize / 8 * stream->channels;
+    luaL_argcheck(L, frameSize > 0 && length % frameSize == 0 && length / frameSize <= INT_MAX, 2, "incomplete frames");
+    UpdateAudioStream(*stream, data, (int)(length / frameSize));
+    return 0;
+}
+
+static int f_WriteAudioStream(lua_State *L) {
+    AudioStreamObject *object = check_AudioStreamObject(L, 1);
+    AudioRing *ring = object->ring;
+    luaL_argcheck(L, ring != NULL, 1, "stream has no ring buffer");
+    const SampleBuffer *buffer = luaL_testudata(L, 2, "SampleBuffer");
+    if (buffer != NULL) {
+        luaL_argcheck(L, buffer->channels == (int)ring->channels, 2, "channel count mismatch");
+        lua_pushinteger(L, write_AudioRing(ring, buffer->samples, buffer->stride, (unsigned int)buffer->frameCount));
+        return 1;
+    }
+    // interleaved signed 16 bit little endian samples
+    size_t length;
+    const char *data = luaL_checklstring(L, 2, &length);
+    const size_t frameSize = 2 * (size_t)ring->channels;
+    luaL_argcheck(L, length % frameSize == 0, 2, "incomplete frames");
+    const size_t frames = length / frameSize;
+    lua_pushinteger(L, write_AudioRing_s16(ring, (const unsigned char*)data, frames < UINT_MAX ? (unsigned int)frames : UINT_MAX));
+    return 1;
+}
+
+static int f_IsAudioStreamProcessed(lua_State *L) {
+    const AudioStreamObject *object = check_AudioStreamObject(L, 1);
+    // a ring buffered stream wants data once half of the ring has been played
+    if (object->ring != NULL) lua_pushboolean(L, get_AudioRing_queued(object->ring) <= object->ring->capacity / 2);
+    else lua_pushboolean(L, IsAudioStreamProcessed(object->stream));
+    return 1;
+}
+
+static int f_PlayAudioStream(lua_State *L) {
+    PlayAudioStream(*check_AudioStream(L, 1));
+    return 0;
+}
+
+static int f_PauseAudioStream(lua_State *L) {
+    PauseAudioStream(*check_AudioStream(L, 1));
+    return 0;
+}
+
+static int f_ResumeAudioStream(lua_State *L) {
+    ResumeAudioStream(*check_AudioStream(L, 1));
+    return 0;
+}
+
+static int f_IsAudioStreamPlaying(lua_State *L) {
+    lua_pushboolean(L, IsAudioStreamPlaying(*check_AudioStream(L, 1)));
     return 1;
 }
 
+static int f_StopAudioStream(lua_State *L) {
+    StopAudioStream(*check_AudioStream(L, 1));
+    return 0;
+}
+
+static int f_SetAudioStreamVolume(lua_State *L) {
+    SetAudioStreamVolume(*check_AudioStream(L, 1), (float)luaL_checknumber(L, 2));
+    return 0;
+}
+
+static int f_SetAudioStreamPitch(lua_State *L) {
+    SetAudioStreamPitch(*check_AudioStream(L, 1), (float)luaL_checknumber(L, 2));
+    return 0;
+}
+
+static int f_SetAudioStreamPan(lua_State *L) {
+    SetAudioStreamPan(*check_AudioStream(L, 1), (float)luaL_checknumber(L, 2));
+    return 0;
+}
+
+static int f_SetAudioStreamBufferSizeDefault(lua_State *L) {
+    const lua_Integer size = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, size >= 0 && size <= INT_MAX, 1, "invalid buffer size");
+    SetAudioStreamBufferSizeDefault((int)size);
+    audio_buffer_size_default = (int)size;
+    return 0;
+}
+
 //==[[ raygui ]]================================================================
 
 // Global gui state control functions ------------------------------------------
@@ -2806,8 +9351,6 @@ static int f_GuiCheckIconPixel(lua_State *L) {
 
 static const luaL_Reg Vector2_meta[] = {
     { "__tostring", f_Vector2__tostring },
-    { "__index", f_Vector2__index },
-    { "__newindex", f_Vector2__newindex },
     { "__add", f_Vector2__add },
     { "__sub", f_Vector2__sub },
     { "__mul", f_Vector2__mul },
@@ -2817,6 +9360,11 @@ static const luaL_Reg Vector2_meta[] = {
     { "Distance", f_Vector2_Distance },
     { "Normal", f_Vector2_Normal },
     { "Angle", f_Vector2_Angle },
+    { "AddInPlace", f_Vector2_AddInPlace },
+    { "SubInPlace", f_Vector2_SubInPlace },
+    { "ScaleInPlace", f_Vector2_ScaleInPlace },
+    { "LerpInto", f_Vector2_LerpInto },
+    { "MulAdd", f_Vector2_MulAdd },
     { "?x", f_Vector2_get_x },
     { "=x", f_Vector2_set_x },
     { "?y", f_Vector2_get_y },
@@ -2824,10 +9372,25 @@ static const luaL_Reg Vector2_meta[] = {
     { NULL, NULL }
 };
 
+static const luaL_Reg Vector2Array_meta[] = {
+    { "__gc", f_Vector2Array__gc },
+    { "__tostring", f_Vector2Array__tostring },
+    { "__len", f_Vector2Array__len },
+    { "Push", f_Vector2Array_Push },
+    { "Get", f_Vector2Array_Get },
+    { "GetXY", f_Vector2Array_GetXY },
+    { "Set", f_Vector2Array_Set },
+    { "Resize", f_Vector2Array_Resize },
+    { "Clear", f_Vector2Array_Clear },
+    { "Translate", f_Vector2Array_Translate },
+    { "Scale", f_Vector2Array_Scale },
+    { "Rotate", f_Vector2Array_Rotate },
+    { "?count", f_Vector2Array_get_count },
+    { NULL, NULL }
+};
+
 static const luaL_Reg Vector3_meta[] = {
     { "__tostring", f_Vector3__tostring },
-    { "__index", f_Vector3__index },
-    { "__newindex", f_Vector3__newindex },
     { "__add", f_Vector3__add },
     { "__sub", f_Vector3__sub },
     { "__mul", f_Vector3__mul },
@@ -2837,6 +9400,11 @@ static const luaL_Reg Vector3_meta[] = {
     { "Length", f_Vector3_Length },
     { "Distance", f_Vector3_Distance },
     { "Normal", f_Vector3_Normal },
+    { "AddInPlace", f_Vector3_AddInPlace },
+    { "SubInPlace", f_Vector3_SubInPlace },
+    { "ScaleInPlace", f_Vector3_ScaleInPlace },
+    { "LerpInto", f_Vector3_LerpInto },
+    { "MulAdd", f_Vector3_MulAdd },
     { "?x", f_Vector3_get_x },
     { "=x", f_Vector3_set_x },
     { "?y", f_Vector3_get_y },
@@ -2848,8 +9416,6 @@ static const luaL_Reg Vector3_meta[] = {
 
 static const luaL_Reg Color_meta[] = {
     { "__tostring", f_Color__tostring },
-    { "__index", f_Color__index },
-    { "__newindex", f_Color__newindex },
     { "Fade", f_Color_Fade },
     { "?r", f_Color_get_r },
     { "=r", f_Color_set_r },
@@ -2862,10 +9428,23 @@ static const luaL_Reg Color_meta[] = {
     { NULL, NULL }
 };
 
+static const luaL_Reg ColorBuffer_meta[] = {
+    { "__tostring", f_ColorBuffer__tostring },
+    { "__len", f_ColorBuffer__len },
+    { "Get", f_ColorBuffer_Get },
+    { "GetRGBA", f_ColorBuffer_GetRGBA },
+    { "Set", f_ColorBuffer_Set },
+    { "Fill", f_ColorBuffer_Fill },
+    { "Map", f_ColorBuffer_Map },
+    { "ToImage", f_LoadImageFromColors },
+    { "?width", f_ColorBuffer_get_width },
+    { "?height", f_ColorBuffer_get_height },
+    { "?count", f_ColorBuffer_get_count },
+    { NULL, NULL }
+};
+
 static const luaL_Reg Rectangle_meta[] = {
     { "__tostring", f_Rectangle__tostring },
-    { "__index", f_Rectangle__index },
-    { "__newindex", f_Rectangle__newindex },
     { "?x", f_Rectangle_get_x },
     { "=x", f_Rectangle_set_x },
     { "?y", f_Rectangle_get_y },
@@ -2880,7 +9459,6 @@ static const luaL_Reg Rectangle_meta[] = {
 static const luaL_Reg Image_meta[] = {
     { "__tostring", f_Image__tostring },
     { "__gc", f_Image__gc },
-    { "__index", f_Image__index },
 
     { "Export", f_ExportImage },
 
@@ -2912,6 +9490,7 @@ static const luaL_Reg Image_meta[] = {
     { "ColorReplace", f_ImageColorReplace },
     { "LoadColors", f_LoadImageColors },
     { "LoadPalette", f_LoadImagePalette },
+    { "UpdateFromColors", f_UpdateImageFromColors },
     { "GetAlphaBorder", f_GetImageAlphaBorder },
     { "GetColor", f_GetImageColor },
 
@@ -2936,10 +9515,11 @@ static const luaL_Reg Image_meta[] = {
 static const luaL_Reg Texture_meta[] = {
     { "__tostring", f_Texture__tostring },
     { "__gc", f_Texture__gc },
-    { "__index", f_Texture__index },
     { "?width", f_Texture_get_width },
     { "?height", f_Texture_get_height },
 
+    { "Update", f_UpdateTexture },
+    { "UpdateRec", f_UpdateTextureRec },
     { "Draw", f_DrawTexture },
     { "DrawV", f_DrawTextureV },
     { "DrawEx", f_DrawTextureEx },
@@ -2953,6 +9533,19 @@ static const luaL_Reg Texture_meta[] = {
     { NULL, NULL }
 };
 
+static const luaL_Reg RenderTexture_meta[] = {
+    { "__tostring", f_RenderTexture__tostring },
+    { "__gc", f_RenderTexture__gc },
+    { "?texture", f_RenderTexture_get_texture },
+    { "?width", f_RenderTexture_get_width },
+    { "?height", f_RenderTexture_get_height },
+
+    { "Begin", f_BeginTextureMode },
+    { "Release", f_ReleaseRenderTexture },
+
+    { NULL, NULL }
+};
+
 static const luaL_Reg Font_meta[] = {
     { "__tostring", f_Font__tostring },
     { "__gc", f_Font__gc },
@@ -2967,8 +9560,6 @@ static const luaL_Reg Font_meta[] = {
 
 static const luaL_Reg Camera3D_meta[] = {
     { "__tostring", f_Camera3D__tostring },
-    { "__index", f_Camera3D__index },
-    { "__newindex", f_Camera3D__newindex },
     { "?position", f_Camera3D_get_position },
     { "=position", f_Camera3D_set_position },
     { "?target", f_Camera3D_get_target },
@@ -2984,8 +9575,6 @@ static const luaL_Reg Camera3D_meta[] = {
 
 static const luaL_Reg Camera2D_meta[] = {
     { "__tostring", f_Camera2D__tostring },
-    { "__index", f_Camera2D__index },
-    { "__newindex", f_Camera2D__newindex },
     { "?offset", f_Camera2D_get_offset },
     { "=offset", f_Camera2D_set_offset },
     { "?target", f_Camera2D_get_target },
@@ -3003,6 +9592,12 @@ static const luaL_Reg Wave_meta[] = {
     { "Copy", f_WaveCopy },
     { "Crop", f_WaveCrop },
     { "Format", f_WaveFormat },
+    { "Resample", f_WaveResample },
+    { "Mixdown", f_WaveMixdown },
+    { "Normalize", f_WaveNormalize },
+    { "TrimSilence", f_WaveTrimSilence },
+    { "Fade", f_WaveFade },
+    { "Concat", f_WaveConcat },
     { "LoadSamples", f_LoadWaveSamples },
     { "?frameCount", f_Wave_get_frameCount },
     { "?sampleRate", f_Wave_get_sampleRate },
@@ -3011,6 +9606,27 @@ static const luaL_Reg Wave_meta[] = {
     { NULL, NULL }
 };
 
+static const luaL_Reg SampleBuffer_meta[] = {
+    { "__tostring", f_SampleBuffer__tostring },
+    { "__len", f_SampleBuffer__len },
+    { "Get", f_SampleBuffer_Get },
+    { "Set", f_SampleBuffer_Set },
+    { "Slice", f_SampleBuffer_Slice },
+    { "Channel", f_SampleBuffer_Channel },
+    { "Copy", f_SampleBuffer_Copy },
+    { "Gain", f_SampleBuffer_Gain },
+    { "Mix", f_SampleBuffer_Mix },
+    { "Peak", f_SampleBuffer_Peak },
+    { "RMS", f_SampleBuffer_RMS },
+    { "Normalize", f_SampleBuffer_Normalize },
+    { "ToWave", f_LoadWaveFromSamples },
+    { "?frameCount", f_SampleBuffer_get_frameCount },
+    { "?channels", f_SampleBuffer_get_channels },
+    { "?sampleRate", f_SampleBuffer_get_sampleRate },
+    { "=sampleRate", f_SampleBuffer_set_sampleRate },
+    { NULL, NULL }
+};
+
 static const luaL_Reg Sound_meta[] = {
     { "__gc", f_Sound__gc },
     { "__tostring", f_Sound__tostring },
@@ -3019,6 +9635,7 @@ static const luaL_Reg Sound_meta[] = {
     { "Pause", f_PauseSound },
     { "Resume", f_ResumeSound },
     { "PlayMulti", f_PlaySoundMulti },
+    { "Update", f_UpdateSound },
     { "IsPlaying", f_IsSoundPlaying },
     { "SeVolume", f_SetSoundVolume },
     { "SePitch", f_SetSoundPitch },
@@ -3041,23 +9658,310 @@ static const luaL_Reg Music_meta[] = {
     { "SetPan", f_SetMusicPan },
     { "GetTimeLength", f_GetMusicTimeLength },
     { "GetTimePlayed", f_GetMusicTimePlayed },
+    { "SetBackground", f_SetMusicStreamBackground },
+    { "Crossfade", f_CrossfadeMusicStream },
+    { "?background", f_Music_get_background },
+    { "=background", f_Music_set_background },
+    { NULL, NULL }
+};
+
+static const luaL_Reg AudioStream_meta[] = {
+    { "__gc", f_AudioStream__gc },
+    { "__tostring", f_AudioStream__tostring },
+    { "Update", f_UpdateAudioStream },
+    { "Write", f_WriteAudioStream },
+    { "IsProcessed", f_IsAudioStreamProcessed },
+    { "Play", f_PlayAudioStream },
+    { "Pause", f_PauseAudioStream },
+    { "Resume", f_ResumeAudioStream },
+    { "IsPlaying", f_IsAudioStreamPlaying },
+    { "Stop", f_StopAudioStream },
+    { "SetVolume", f_SetAudioStreamVolume },
+    { "SetPitch", f_SetAudioStreamPitch },
+    { "SetPan", f_SetAudioStreamPan },
+    { "?sampleRate", f_AudioStream_get_sampleRate },
+    { "?sampleSize", f_AudioStream_get_sampleSize },
+    { "?channels", f_AudioStream_get_channels },
+    { "?queued", f_AudioStream_get_queued },
+    { "?capacity", f_AudioStream_get_capacity },
+    { "?underruns", f_AudioStream_get_underruns },
+    { NULL, NULL }
+};
+
+static const luaL_Reg DrawList_meta[] = {
+    { "__gc", f_DrawList__gc },
+    { "__tostring", f_DrawList__tostring },
+    { "__len", f_DrawList__len },
+    { "Draw", f_DrawList_Draw },
+    { "Clear", f_DrawList_Clear },
+    { "Truncate", f_DrawList_Truncate },
+    { "Set", f_DrawList_Set },
+    { "Remove", f_DrawList_Remove },
+    { "DrawPixel", f_DrawList_DrawPixel },
+    { "DrawPixelV", f_DrawList_DrawPixelV },
+    { "DrawLine", f_DrawList_DrawLine },
+    { "DrawLineV", f_DrawList_DrawLineV },
+    { "DrawLineEx", f_DrawList_DrawLineEx },
+    { "DrawCircle", f_DrawList_DrawCircle },
+    { "DrawCircleV", f_DrawList_DrawCircleV },
+    { "DrawCircleLines", f_DrawList_DrawCircleLines },
+    { "DrawRectangle", f_DrawList_DrawRectangle },
+    { "DrawRectangleV", f_DrawList_DrawRectangleV },
+    { "DrawRectangleRec", f_DrawList_DrawRectangleRec },
+    { "DrawRectanglePro", f_DrawList_DrawRectanglePro },
+    { "DrawRectangleLines", f_DrawList_DrawRectangleLines },
+    { "DrawRectangleLinesEx", f_DrawList_DrawRectangleLinesEx },
+    { "DrawRectangleRounded", f_DrawList_DrawRectangleRounded },
+    { "DrawTriangle", f_DrawList_DrawTriangle },
+    { "DrawTriangleLines", f_DrawList_DrawTriangleLines },
+    { "DrawPoly", f_DrawList_DrawPoly },
+    { "DrawText", f_DrawList_DrawText },
+    { "DrawTextEx", f_DrawList_DrawTextEx },
+    { "DrawTexture", f_DrawList_DrawTexture },
+    { "DrawTextureV", f_DrawList_DrawTextureV },
+    { "DrawTextureEx", f_DrawList_DrawTextureEx },
+    { "DrawTextureRec", f_DrawList_DrawTextureRec },
+    { "DrawTexturePro", f_DrawList_DrawTexturePro },
+    { NULL, NULL }
+};
+
+static const luaL_Reg SpriteBatch_meta[] = {
+    { "__gc", f_SpriteBatch__gc },
+    { "__tostring", f_SpriteBatch__tostring },
+    { "__len", f_SpriteBatch__len },
+    { "Add", f_SpriteBatch_Add },
+    { "Set", f_SpriteBatch_Set },
+    { "SetSource", f_SpriteBatch_SetSource },
+    { "SetDest", f_SpriteBatch_SetDest },
+    { "SetPosition", f_SpriteBatch_SetPosition },
+    { "SetOrigin", f_SpriteBatch_SetOrigin },
+    { "SetRotation", f_SpriteBatch_SetRotation },
+    { "SetTint", f_SpriteBatch_SetTint },
+    { "GetPosition", f_SpriteBatch_GetPosition },
+    { "Resize", f_SpriteBatch_Resize },
+    { "Clear", f_SpriteBatch_Clear },
+    { "Draw", f_SpriteBatch_Draw },
+    { "?texture", f_SpriteBatch_get_texture },
+    { NULL, NULL }
+};
+
+static const luaL_Reg ParticleSystem_meta[] = {
+    { "__gc", f_ParticleSystem__gc },
+    { "__tostring", f_ParticleSystem__tostring },
+    { "Configure", f_ParticleSystem_Configure },
+    { "Emit", f_ParticleSystem_Emit },
+    { "Update", f_ParticleSystem_Update },
+    { "Clear", f_ParticleSystem_Clear },
+    { "Draw", f_ParticleSystem_Draw },
+    { "?count", f_ParticleSystem_get_count },
+    { "?position", f_ParticleSystem_get_position },
+    { "=position", f_ParticleSystem_set_position },
+    { "?rate", f_ParticleSystem_get_rate },
+    { "=rate", f_ParticleSystem_set_rate },
+    { NULL, NULL }
+};
+
+static const luaL_Reg SpatialHash_meta[] = {
+    { "__gc", f_SpatialHash__gc },
+    { "__tostring", f_SpatialHash__tostring },
+    { "__len", f_SpatialHash__len },
+    { "Insert", f_SpatialHash_Insert },
+    { "Update", f_SpatialHash_Update },
+    { "Remove", f_SpatialHash_Remove },
+    { "Has", f_SpatialHash_Has },
+    { "Clear", f_SpatialHash_Clear },
+    { "QueryRec", f_SpatialHash_QueryRec },
+    { "QueryRadius", f_SpatialHash_QueryRadius },
+    { "QueryPairs", f_SpatialHash_QueryPairs },
+    { "?count", f_SpatialHash_get_count },
+    { "?cellSize", f_SpatialHash_get_cellSize },
+    { NULL, NULL }
+};
+
+static const luaL_Reg Archive_meta[] = {
+    { "__gc", f_Archive__gc },
+    { "__tostring", f_Archive__tostring },
+    { "Unmount", f_Archive_Unmount },
+    { "Has", f_Archive_Has },
+    { "List", f_Archive_List },
+    { "?count", f_Archive_get_count },
+    { "?mounted", f_Archive_get_mounted },
+    { NULL, NULL }
+};
+
+static const luaL_Reg Future_meta[] = {
+    { "__gc", f_Future__gc },
+    { "__tostring", f_Future__tostring },
+    { "IsDone", f_Future_IsDone },
+    { "Get", f_Future_Get },
+    { "Wait", f_Future_Wait },
+    { "?failed", f_Future_get_failed },
+    { NULL, NULL }
+};
+
+static const luaL_Reg ImagePipeline_meta[] = {
+    { "__gc", f_ImagePipeline__gc },
+    { "__tostring", f_ImagePipeline__tostring },
+    { "__len", f_ImagePipeline__len },
+    { "ColorTint", f_ImagePipeline_ColorTint },
+    { "ColorInvert", f_ImagePipeline_ColorInvert },
+    { "ColorGrayscale", f_ImagePipeline_ColorGrayscale },
+    { "ColorContrast", f_ImagePipeline_ColorContrast },
+    { "ColorBrightness", f_ImagePipeline_ColorBrightness },
+    { "ColorReplace", f_ImagePipeline_ColorReplace },
+    { "AlphaPremultiply", f_ImagePipeline_AlphaPremultiply },
+    { "Clear", f_ImagePipeline_Clear },
+    { "Apply", f_ImagePipeline_Apply },
+    { NULL, NULL }
+};
+
+static const luaL_Reg TextureAtlas_meta[] = {
+    { "__gc", f_TextureAtlas__gc },
+    { "__tostring", f_TextureAtlas__tostring },
+    { "__len", f_TextureAtlas__len },
+    { "Add", f_TextureAtlas_Add },
+    { "Build", f_TextureAtlas_Build },
+    { "Get", f_TextureAtlas_Get },
+    { "GetPage", f_TextureAtlas_GetPage },
+    { "Save", f_TextureAtlas_Save },
+    { "?pageCount", f_TextureAtlas_get_pageCount },
+    { "?built", f_TextureAtlas_get_built },
+    { NULL, NULL }
+};
+
+static const luaL_Reg AtlasRegion_meta[] = {
+    { "__tostring", f_AtlasRegion__tostring },
+    { "?texture", f_AtlasRegion_get_texture },
+    { "?source", f_AtlasRegion_get_source },
+    { "?width", f_AtlasRegion_get_width },
+    { "?height", f_AtlasRegion_get_height },
+
+    { "Draw", f_DrawTexture },
+    { "DrawV", f_DrawTextureV },
+    { "DrawEx", f_DrawTextureEx },
+    { "DrawRec", f_DrawTextureRec },
+    { "DrawPro", f_DrawTexturePro },
+
+    { NULL, NULL }
+};
+
+static const luaL_Reg TextLayout_meta[] = {
+    { "__gc", f_TextLayout__gc },
+    { "__tostring", f_TextLayout__tostring },
+    { "__len", f_TextLayout__len },
+    { "SetText", f_TextLayout_SetText },
+    { "Draw", f_TextLayout_Draw },
+    { "?text", f_TextLayout_get_text },
+    { "=text", f_TextLayout_set_text },
+    { "?font", f_TextLayout_get_font },
+    { "?fontSize", f_TextLayout_get_fontSize },
+    { "=fontSize", f_TextLayout_set_fontSize },
+    { "?spacing", f_TextLayout_get_spacing },
+    { "=spacing", f_TextLayout_set_spacing },
+    { "?wrapWidth", f_TextLayout_get_wrapWidth },
+    { "=wrapWidth", f_TextLayout_set_wrapWidth },
+    { "?align", f_TextLayout_get_align },
+    { "=align", f_TextLayout_set_align },
+    { "?size", f_TextLayout_get_size },
+    { "?width", f_TextLayout_get_width },
+    { "?height", f_TextLayout_get_height },
+    { "?lineCount", f_TextLayout_get_lineCount },
+    { NULL, NULL }
+};
+
+static const luaL_Reg Mixer_meta[] = {
+    { "__gc", f_Mixer__gc },
+    { "__tostring", f_Mixer__tostring },
+    { "Play", f_Mixer_Play },
+    { "PlayAt", f_Mixer_PlayAt },
+    { "SetVoice", f_Mixer_SetVoice },
+    { "Stop", f_Mixer_Stop },
+    { "StopAll", f_Mixer_StopAll },
+    { "IsPlaying", f_Mixer_IsPlaying },
+    { "SetBus", f_Mixer_SetBus },
+    { "AddEffect", f_Mixer_AddEffect },
+    { "SetEffect", f_Mixer_SetEffect },
+    { "SetSoundLimits", f_Mixer_SetSoundLimits },
+    { "SetListener", f_Mixer_SetListener },
+    { "GetStats", f_Mixer_GetStats },
+    { "?stealPolicy", f_Mixer_get_stealPolicy },
+    { "=stealPolicy", f_Mixer_set_stealPolicy },
+    { "?maxDistance", f_Mixer_get_maxDistance },
+    { "=maxDistance", f_Mixer_set_maxDistance },
+    { "?voices", f_Mixer_get_voices },
+    { "?capacity", f_Mixer_get_capacity },
+    { "?buses", f_Mixer_get_buses },
+    { "?sampleRate", f_Mixer_get_sampleRate },
+    { NULL, NULL }
+};
+
+static const ObjectMeta raylib_metas[] = {
+    { "Vector2", Vector2_meta },
+    { "Vector2*", Vector2_meta },
+    { "Vector2Array", Vector2Array_meta },
+    { "Vector3", Vector3_meta },
+    { "Vector3*", Vector3_meta },
+    { "Color", Color_meta },
+    { "ColorBuffer", ColorBuffer_meta },
+    { "Rectangle", Rectangle_meta },
+    { "Image", Image_meta },
+    { "Texture", Texture_meta },
+    { "Texture*", Texture_meta },
+    { "RenderTexture", RenderTexture_meta },
+    { "Font", Font_meta },
+    { "Camera3D", Camera3D_meta },
+    { "Camera2D", Camera2D_meta },
+    { "Wave", Wave_meta },
+    { "SampleBuffer", SampleBuffer_meta },
+    { "Sound", Sound_meta },
+    { "Music", Music_meta },
+    { "AudioStream", AudioStream_meta },
+    { "Mixer", Mixer_meta },
+    { "DrawList", DrawList_meta },
+    { "SpriteBatch", SpriteBatch_meta },
+    { "ParticleSystem", ParticleSystem_meta },
+    { "SpatialHash", SpatialHash_meta },
+    { "Archive", Archive_meta },
+    { "Future", Future_meta },
+    { "ImagePipeline", ImagePipeline_meta },
+    { "TextureAtlas", TextureAtlas_meta },
+    { "AtlasRegion", AtlasRegion_meta },
+    { "TextLayout", TextLayout_meta },
     { NULL, NULL }
 };
 
 static const luaL_Reg raylib_funcs[] = {
     // Object creation ---------------------------------------------------------
     { "Vector2", f_Vector2 },
+    { "Vector2Array", f_Vector2Array },
     { "Vector3", f_Vector3 },
     { "Color", f_Color },
+    { "ColorBuffer", f_ColorBuffer },
     { "Rectangle", f_Rectangle },
     { "Camera3D", f_Camera3D },
     { "Camera2D", f_Camera2D },
+    { "SampleBuffer", f_SampleBuffer },
+    { "DrawList", f_DrawList },
+    { "SpriteBatch", f_SpriteBatch },
+    { "ParticleSystem", f_ParticleSystem },
+    { "SpatialHash", f_SpatialHash },
+    { "ImagePipeline", f_ImagePipeline },
+    { "TextureAtlas", f_TextureAtlas },
+    { "TextLayout", f_TextLayout },
+    { "Mixer", f_Mixer },
+    // Memory statistics -------------------------------------------------------
+    { "GetAllocatedBytes", f_GetAllocatedBytes },
+    // Profiler ----------------------------------------------------------------
+    { "IsProfilerEnabled", f_IsProfilerEnabled },
+    { "GetProfilerFrame", f_GetProfilerFrame },
+    { "ExportProfilerFrame", f_ExportProfilerFrame },
     // module: core ------------------------------------------------------------
         // Window-related functions
         { "InitWindow", f_InitWindow },
         { "WindowShouldClose", f_WindowShouldClose },
         { "CloseWindow", f_CloseWindow },
         { "IsWindowReady", f_IsWindowReady },
+        { "IsHeadless", f_IsHeadless },
         { "IsWindowFullscreen", f_IsWindowFullscreen },
         { "IsWindowHidden", f_IsWindowHidden },
         { "IsWindowMaximized", f_IsWindowMaximized },
@@ -3110,6 +10014,8 @@ static const luaL_Reg raylib_funcs[] = {
         { "EndMode2D", f_EndMode2D },
         { "BeginMode3D", f_BeginMode3D },
         { "EndMode3D", f_EndMode3D },
+        { "BeginTextureMode", f_BeginTextureMode },
+        { "EndTextureMode", f_EndTextureMode },
         { "BeginBlendMode", f_BeginBlendMode },
         { "EndBlendMode", f_EndBlendMode },
         { "BeginScissorMode", f_BeginScissorMode },
@@ -3120,6 +10026,8 @@ static const luaL_Reg raylib_funcs[] = {
         { "GetFrameTime", f_GetFrameTime },
         { "GetTime", f_GetTime },
         // Files management functions ------------------------------------------
+        { "MountArchive", f_MountArchive },
+        { "LoadFileDataAsync", f_LoadFileDataAsync },
         { "LoadFileData", f_LoadFileData },
         { "SaveFileData", f_SaveFileData },
         { "FileExists", f_FileExists },
@@ -3253,6 +10161,8 @@ static const luaL_Reg raylib_funcs[] = {
         { "LoadImageRaw", f_LoadImageRaw },
         { "LoadImageAnim", f_LoadImageAnim },
         { "LoadImageFromString", f_LoadImageFromString },
+        { "LoadImageAsync", f_LoadImageAsync },
+        { "LoadImageFromStringAsync", f_LoadImageFromStringAsync },
         { "LoadImageFromTexture", f_LoadImageFromTexture },
         { "LoadImageFromScreen", f_LoadImageFromScreen },
         { "ExportImage", f_ExportImage },
@@ -3293,6 +10203,8 @@ static const luaL_Reg raylib_funcs[] = {
         { "ImageColorReplace", f_ImageColorReplace },
         { "LoadImageColors", f_LoadImageColors },
         { "LoadImagePalette", f_LoadImagePalette },
+        { "LoadImageFromColors", f_LoadImageFromColors },
+        { "UpdateImageFromColors", f_UpdateImageFromColors },
         { "GetImageAlphaBorder", f_GetImageAlphaBorder },
         { "GetImageColor", f_GetImageColor },
         // Image drawing functions ---------------------------------------------
@@ -3312,6 +10224,17 @@ static const luaL_Reg raylib_funcs[] = {
         { "ImageDrawTextEx", f_ImageDrawTextEx },
         // Texture loading functions -------------------------------------------
         { "LoadTexture", f_LoadTexture },
+        { "LoadTextureFromImage", f_LoadTextureFromImage },
+        { "LoadRenderTexture", f_LoadRenderTexture },
+        { "AcquireRenderTexture", f_AcquireRenderTexture },
+        { "ReleaseRenderTexture", f_ReleaseRenderTexture },
+        { "LoadTextureAsync", f_LoadTextureAsync },
+        { "UpdateTexture", f_UpdateTexture },
+        { "UpdateTextureRec", f_UpdateTextureRec },
+        { "LoadTextureAtlas", f_LoadTextureAtlas },
+        { "SetAsyncUploadBudget", f_SetAsyncUploadBudget },
+        { "SetWorkerThreadCount", f_SetWorkerThreadCount },
+        { "GetWorkerThreadCount", f_GetWorkerThreadCount },
         // Texture configuration functions -------------------------------------
         { "GenTextureMipmaps", f_GenTextureMipmaps },
         { "SetTextureFilter", f_SetTextureFilter },
@@ -3337,6 +10260,7 @@ static const luaL_Reg raylib_funcs[] = {
         { "DrawTextEx", f_DrawTextEx },
         { "DrawTextPro", f_DrawTextPro },
         { "DrawTextCodepoint", f_DrawTextCodepoint },
+        { "DrawTextLayout", f_TextLayout_Draw },
         // Text font info functions --------------------------------------------
         { "MeasureText", f_MeasureText },
         { "MeasureTextEx", f_MeasureTextEx },
@@ -3349,6 +10273,8 @@ static const luaL_Reg raylib_funcs[] = {
         // Wave/Sound loading/unloading functions ------------------------------
         { "LoadWave", f_LoadWave },
         { "LoadWaveFromString", f_LoadWaveFromString },
+        { "LoadWaveAsync", f_LoadWaveAsync },
+        { "LoadWaveFromStringAsync", f_LoadWaveFromStringAsync },
         { "LoadSound", f_LoadSound },
         { "LoadSoundFromWave", f_LoadSoundFromWave },
         { "UpdateSound", f_UpdateSound },
@@ -3368,7 +10294,15 @@ static const luaL_Reg raylib_funcs[] = {
         { "WaveCopy", f_WaveCopy },
         { "WaveCrop", f_WaveCrop },
         { "WaveFormat", f_WaveFormat },
+        { "WaveResample", f_WaveResample },
+        { "WaveMixdown", f_WaveMixdown },
+        { "WaveNormalize", f_WaveNormalize },
+        { "WaveTrimSilence", f_WaveTrimSilence },
+        { "WaveFade", f_WaveFade },
+        { "WaveConcat", f_WaveConcat },
+        { "ProcessWaves", f_ProcessWaves },
         { "LoadWaveSamples", f_LoadWaveSamples },
+        { "LoadWaveFromSamples", f_LoadWaveFromSamples },
         // Music management functions ------------------------------------------
         { "LoadMusicStream", f_LoadMusicStream },
         { "LoadMusicStreamFromString", f_LoadMusicStreamFromString },
@@ -3384,6 +10318,22 @@ static const luaL_Reg raylib_funcs[] = {
         { "SetMusicPan", f_SetMusicPan },
         { "GetMusicTimeLength", f_GetMusicTimeLength },
         { "GetMusicTimePlayed", f_GetMusicTimePlayed },
+        { "SetMusicStreamBackground", f_SetMusicStreamBackground },
+        { "CrossfadeMusicStream", f_CrossfadeMusicStream },
+        // AudioStream management functions ------------------------------------
+        { "LoadAudioStream", f_LoadAudioStream },
+        { "UpdateAudioStream", f_UpdateAudioStream },
+        { "WriteAudioStream", f_WriteAudioStream },
+        { "IsAudioStreamProcessed", f_IsAudioStreamProcessed },
+        { "PlayAudioStream", f_PlayAudioStream },
+        { "PauseAudioStream", f_PauseAudioStream },
+        { "ResumeAudioStream", f_ResumeAudioStream },
+        { "IsAudioStreamPlaying", f_IsAudioStreamPlaying },
+        { "StopAudioStream", f_StopAudioStream },
+        { "SetAudioStreamVolume", f_SetAudioStreamVolume },
+        { "SetAudioStreamPitch", f_SetAudioStreamPitch },
+        { "SetAudioStreamPan", f_SetAudioStreamPan },
+        { "SetAudioStreamBufferSizeDefault", f_SetAudioStreamBufferSizeDefault },
     // module: raygui ----------------------------------------------------------
         // Global gui state control functions ----------------------------------
         { "GuiEnable", f_GuiEnable },
@@ -4140,22 +11090,26 @@ static const struct {
 };
 
 static void InitRayLua(lua_State *L) {
+    InitProfiler(L, raylib_funcs, raylib_metas);
     // push object metatables
-    push_meta(L, "Vector2", Vector2_meta); push_meta(L, "Vector2*", Vector2_meta);
-    push_meta(L, "Vector3", Vector3_meta); push_meta(L, "Vector3*", Vector3_meta);
-    push_meta(L, "Color", Color_meta);
-    push_meta(L, "Rectangle", Rectangle_meta);
-    push_meta(L, "Image", Image_meta);
-    push_meta(L, "Texture", Texture_meta);
-    push_meta(L, "Font", Font_meta);
-    push_meta(L, "Camera3D", Camera3D_meta);
-    push_meta(L, "Camera2D", Camera2D_meta);
-    push_meta(L, "Wave", Wave_meta);
-    push_meta(L, "Sound", Sound_meta);
-    push_meta(L, "Music", Music_meta);
+    int funcCount = 0;
+    while (raylib_funcs[funcCount].name != NULL) ++funcCount;
+    for (int i = 0; raylib_metas[i].name != NULL; ++i) {
+        push_meta(L, raylib_metas[i].name, raylib_metas[i].funcs);
+        if (profiler.enabled) profile_meta(L, raylib_metas, i, funcCount);
+    }
     // register our functions
     lua_pushglobaltable(L);
-    luaL_setfuncs(L, raylib_funcs, 0);
+    if (profiler.enabled) {
+        for (int i = 0; raylib_funcs[i].name != NULL; ++i) {
+            lua_pushcfunction(L, raylib_funcs[i].func);
+            lua_pushinteger(L, i);
+            lua_pushcclosure(L, f_profiled, 2);
+            lua_setfield(L, -2, raylib_funcs[i].name);
+        }
+    } else {
+        luaL_setfuncs(L, raylib_funcs, 0);
+    }
     // register values
     for (int i = 0; raylib_values[i].name != NULL; ++i) {
         lua_pushinteger(L, raylib_values[i].value);
@@ -4167,21 +11121,136 @@ static void InitRayLua(lua_State *L) {
         lua_setfield(L, -2, raylib_colors[i].name);
     }
     lua_pop(L, 1);
+    // load modules from mounted archives
+    InitArchiveSearcher(L);
 }
 
 
 //==[[ main ]]==================================================================
 
-static int RunLuaCode(lua_State *L) {
-    if (luaL_loadfile(L, "init.lua") != LUA_OK)
-        lua_error(L);
-    lua_call(L, 0, 0);
+static void InstallCountingAlloc(lua_State *L) {
+    alloc_stats.alloc = lua_getallocf(L, &alloc_stats.ud);
+    lua_setallocf(L, CountingAlloc, NULL);
+}
+
+typedef struct Options {
+    int argc;
+    char **argv;
+    int scriptArg;          // index of the script in argv, argc if the default script is used
+    const char *script;
+    const char *output;     // compile the script to this file instead of running it
+    int archives;           // number of --archive options
+    bool strip;             // strip debug information from compiled chunks
+} Options;
+
+static void PrintUsage(const char *program) {
+    fprintf(stderr,
+        "usage: %s [options] [script [args...]]\n"
+        "Runs 'script' (default: init.lua, '-' reads it from stdin), which may be Lua source or\n"
+        "precompiled bytecode.\n"
+        "Available options are:\n"
+        "  -o, --output FILE  compile 'script' to bytecode in FILE instead of running it\n"
+        "  -s, --strip        strip debug information from the compiled bytecode\n"
+        "  -a, --archive FILE mount the asset archive FILE before running 'script'\n"
+        "  --headless         render offscreen without a visible window (see RAYLUA_HEADLESS),\n"
+        "                     still needs a display server, use xvfb-run on machines without one\n"
+        "  --profile          enable the binding profiler (see RAYLUA_PROFILE)\n"
+        "  -h, --help         show this help\n"
+        "  --                 stop handling options\n",
+        program);
+}
+
+static int MissingFileName(const char *program, const char *opt) {
+    fprintf(stderr, "%s: '%s' needs a file name\n", program, opt);
+    return 1;
+}
+
+// Returns 0 on success, 1 on invalid arguments and -1 if the program should just exit
+static int ParseOptions(Options *options, int argc, char *argv[]) {
+    *options = (Options){ .argc = argc, .argv = argv, .script = "init.lua" };
+    int i = 1;
+    // a lone '-' is the script read from stdin and ends the options
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; ++i) {
+        const char *opt = argv[i];
+        if (strcmp(opt, "--") == 0) { ++i; break; }
+        else if (strcmp(opt, "--headless") == 0) headless.enabled = true;
+        else if (strcmp(opt, "--profile") == 0) profiler.requested = true;
+        else if (strcmp(opt, "-s") == 0 || strcmp(opt, "--strip") == 0) options->strip = true;
+        else if (strcmp(opt, "-o") == 0 || strcmp(opt, "--output") == 0) {
+            if (++i >= argc) return MissingFileName(argv[0], opt);
+            options->output = argv[i];
+        } else if (strcmp(opt, "-a") == 0 || strcmp(opt, "--archive") == 0) {
+            if (++i >= argc) return MissingFileName(argv[0], opt);
+            options->archives++;
+        } else if (strcmp(opt, "-h") == 0 || strcmp(opt, "--help") == 0) {
+            PrintUsage(argv[0]);
+            return -1;
+        } else {
+            fprintf(stderr, "%s: unrecognized option '%s'\n", argv[0], opt);
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    options->scriptArg = i;
+    if (i < argc) options->script = argv[i];
+    return 0;
+}
+
+static int WriteChunk(lua_State *L, const void *p, size_t size, void *ud) {
+    (void)L;
+    return fwrite(p, 1, size, (FILE*)ud) != size;
+}
+
+static int CompileLuaCode(lua_State *L, const Options *options) {
+    FILE *fp = fopen(options->output, "wb");
+    if (fp == NULL) return luaL_error(L, "cannot open '%s' for writing", options->output);
+    const int status = lua_dump(L, WriteChunk, fp, options->strip);
+    if (fclose(fp) != 0 || status != 0) return luaL_error(L, "cannot write '%s'", options->output);
     return 0;
 }
 
-int main(void) {
+static int RunLuaCode(lua_State *L) {
+    const Options *options = lua_touserdata(L, 1);
+    // mount archives in command line order, the last one takes precedence
+    for (int i = 1, n = options->archives; n > 0 && i < options->scriptArg; ++i) {
+        if (strcmp(options->argv[i], "-a") == 0 || strcmp(options->argv[i], "--archive") == 0) {
+            mount_Archive(L, options->argv[++i]);
+            lua_pop(L, 1);
+            --n;
+        }
+    }
+    // the script may come from an archive or stdin, source and precompiled chunks are accepted
+    const bool stdinScript = strcmp(options->script, "-") == 0;
+    if ((stdinScript ? luaL_loadfile(L, NULL) : load_lua_file(L, options->script)) != LUA_OK)
+        lua_error(L);
+    if (options->output != NULL)
+        return CompileLuaCode(L, options);
+    // build the global 'arg' table like the standalone Lua interpreter does
+    const int first = options->scriptArg;
+    lua_createtable(L, options->argc > first ? options->argc - first - 1 : 0, first + 1);
+    for (int i = 0; i < options->argc; ++i) {
+        lua_pushstring(L, options->argv[i]);
+        lua_rawseti(L, -2, i - first);
+    }
+    lua_pushstring(L, options->script);
+    lua_rawseti(L, -2, 0);
+    lua_setglobal(L, "arg");
+    // and pass the script arguments as '...'
+    int nargs = 0;
+    for (int i = first + 1; i < options->argc; ++i, ++nargs)
+        lua_pushstring(L, options->argv[i]);
+    lua_call(L, nargs, 0);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    const int parsed = ParseOptions(&options, argc, argv);
+    if (parsed != 0) return parsed < 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (headless.enabled || env_flag("RAYLUA_HEADLESS")) InitHeadless();
     // create new Lua state
     lua_State *L = luaL_newstate();
+    InstallCountingAlloc(L);
     luaL_openlibs(L);
     InitRayLua(L);
     // push 'debug.traceback' as error handler
@@ -4190,8 +11259,13 @@ int main(void) {
     lua_remove(L, -2);
     // run the Lua code in a protected environment to catch errors
     lua_pushcfunction(L, RunLuaCode);
-    if (lua_pcall(L, 0, 0, -2) != LUA_OK)
+    lua_pushlightuserdata(L, &options);
+    const int status = lua_pcall(L, 1, 0, -3);
+    if (status != LUA_OK)
         fprintf(stderr, "%s\n", lua_tostring(L, -1));
     lua_close(L);
-    return 0;
+    ReleaseMusicWorker();
+    ReleaseAsyncPool();
+    ReleaseProfiler();
+    return status == LUA_OK ? EXIT_SUCCESS : EXIT_FAILURE;
 }